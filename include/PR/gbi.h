@@ -126,6 +126,9 @@
 #define G_TRI2			0x06
 #define G_QUAD			0x07
 #define G_LINE3D		0x08
+#ifdef F3DEX_GBI_2E
+#define G_PARTICLES		0x09	/* PC only, see gSPParticles */
+#endif
 #else   /* F3DEX_GBI_2 */
 
 /* DMA commands: */
@@ -1141,6 +1144,17 @@ typedef union {
     long long int	force_structure_alignment;
 } Vtx;
 
+#ifdef G_PARTICLES
+/*
+ * Particle batch: one triangle around the origin, drawn once at each
+ * position (set up for use with gSPParticles)
+ */
+typedef struct {
+	Vtx_t		tri[3];	/* billboard triangle */
+	short		(*pos)[3];	/* x, y, z of each particle */
+} Particles_t;
+#endif
+
 /*
  * Sprite structure
  */
@@ -1868,6 +1882,18 @@ typedef union {
                 gsDma1p(G_VTX, v, sizeof(Vtx)*(n), ((n)-1)<<4|(v0))
 #endif
 
+#ifdef G_PARTICLES
+/*
+ * Draws n particles from a Particles_t, which the PC renderer transforms and
+ * rasterizes as a single batch instead of one vertex load per 5 triangles.
+ */
+# define	gSPParticles(pkt, p, n)					\
+{									\
+	Gfx *_g = (Gfx *)(pkt);						\
+	_g->words.w0 = _SHIFTL(G_PARTICLES,24,8)|_SHIFTL((n),0,16);	\
+	_g->words.w1 = (uintptr_t)(p);				\
+}
+#endif
 	
 #ifdef	F3DEX_GBI_2
 # define gSPViewport(pkt, v)	\
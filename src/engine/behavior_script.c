@@ -14,6 +14,14 @@
 #include "graph_node.h"
 #include "surface_collision.h"
 
+#ifdef BHV_PREDECODE
+#include <stdlib.h>
+#endif
+#ifdef BHV_BENCHMARK
+#include <stdio.h>
+#include "pc/perf_timer.h"
+#endif
+
 // Macros for retrieving arguments from behavior scripts.
 #define BHV_CMD_GET_1ST_U8(index)  (u8)((gCurBhvCommand[index] >> 24) & 0xFF) // unused
 #define BHV_CMD_GET_2ND_U8(index)  (u8)((gCurBhvCommand[index] >> 16) & 0xFF)
@@ -891,14 +899,324 @@ static BhvCommandProc BehaviorCmdTable[] = {
     bhv_cmd_spawn_water_droplet,
 };
 
+#ifdef BHV_PREDECODE
+// Threaded-code form of behavior scripts. Each command is decoded once, the
+// first time it is reached, into a BhvDecodedCmd with its operands extracted
+// and links to the following command and to its jump target. cur_obj_update
+// then walks these links instead of dispatching on raw script words.
+// Objects keep storing raw script addresses in curBhvCommand and bhvStack, so
+// code that swaps behaviors or resets objects doesn't need to know about this.
+
+struct BhvDecodedCmd;
+typedef s32 (*BhvDecodedProc)(struct BhvDecodedCmd **cmdPtr);
+
+struct BhvDecodedCmd {
+    BhvDecodedProc proc;
+    const BehaviorScript *src;
+    struct BhvDecodedCmd *next;       // Command following this one, resolved on first use
+    struct BhvDecodedCmd *target;     // Last jump target taken from this command
+    const BehaviorScript *targetSrc;  // Script address of target
+    struct BhvDecodedCmd *hashNext;
+    union {
+        s32 i;
+        f32 f;
+        void *ptr;
+        const BehaviorScript *addr;
+    } arg;
+    u8 field;
+    u8 size;
+};
+
+#define BHV_DECODED_HASH_SIZE 2048
+#define BHV_DECODED_POOL_SIZE 256
+
+static struct BhvDecodedCmd *sBhvDecodedHash[BHV_DECODED_HASH_SIZE];
+static struct BhvDecodedCmd *sBhvDecodedPool;
+static s32 sBhvDecodedPoolUsed = BHV_DECODED_POOL_SIZE;
+
+// Size in words of each behavior command, indexed by opcode.
+static const u8 sBhvCmdSizes[] = {
+    1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 1, 1, 1, 1,
+    3, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 2, 1, 3, 2, 3, 3, 1, 2, 2, 5, 2, 1, 2, 1, 1, 2, 2,
+};
+
+static struct BhvDecodedCmd *bhv_decode_cmd(const BehaviorScript *addr);
+
+static struct BhvDecodedCmd *bhv_decoded_lookup(const BehaviorScript *addr) {
+    uintptr_t key = (uintptr_t) addr >> 2;
+    struct BhvDecodedCmd *cmd = sBhvDecodedHash[(key ^ (key >> 11)) & (BHV_DECODED_HASH_SIZE - 1)];
+
+    while (cmd != NULL) {
+        if (cmd->src == addr) {
+            return cmd;
+        }
+        cmd = cmd->hashNext;
+    }
+
+    return bhv_decode_cmd(addr);
+}
+
+// Return the decoded command following cmd.
+static struct BhvDecodedCmd *bhv_decoded_next(struct BhvDecodedCmd *cmd) {
+    if (cmd->next == NULL) {
+        cmd->next = bhv_decoded_lookup(cmd->src + cmd->size);
+    }
+    return cmd->next;
+}
+
+// Return the decoded command at addr, which cmd is jumping to. The last target
+// is cached on cmd, so loops and returns to the same place skip the lookup.
+static struct BhvDecodedCmd *bhv_decoded_jump(struct BhvDecodedCmd *cmd, const BehaviorScript *addr) {
+    if (addr == cmd->src + cmd->size) {
+        return bhv_decoded_next(cmd);
+    }
+    if (addr != cmd->targetSrc) {
+        cmd->target = bhv_decoded_lookup(addr);
+        cmd->targetSrc = addr;
+    }
+    return cmd->target;
+}
+
+// Runs any command through its original handler.
+static s32 bhv_decoded_generic(struct BhvDecodedCmd **cmdPtr) {
+    struct BhvDecodedCmd *cmd = *cmdPtr;
+    s32 result;
+
+    gCurBhvCommand = cmd->src;
+    result = BehaviorCmdTable[*cmd->src >> 24]();
+
+    if (gCurBhvCommand != cmd->src) {
+        *cmdPtr = bhv_decoded_jump(cmd, gCurBhvCommand);
+    }
+    return result;
+}
+
+static s32 bhv_decoded_break(UNUSED struct BhvDecodedCmd **cmdPtr) {
+    return BHV_PROC_BREAK;
+}
+
+static s32 bhv_decoded_call(struct BhvDecodedCmd **cmdPtr) {
+    struct BhvDecodedCmd *cmd = *cmdPtr;
+
+    cur_obj_bhv_stack_push((uintptr_t) (cmd->src + 2));
+    *cmdPtr = bhv_decoded_jump(cmd, cmd->arg.addr);
+    return BHV_PROC_CONTINUE;
+}
+
+static s32 bhv_decoded_return(struct BhvDecodedCmd **cmdPtr) {
+    *cmdPtr = bhv_decoded_jump(*cmdPtr, (const BehaviorScript *) cur_obj_bhv_stack_pop());
+    return BHV_PROC_CONTINUE;
+}
+
+static s32 bhv_decoded_goto(struct BhvDecodedCmd **cmdPtr) {
+    *cmdPtr = bhv_decoded_jump(*cmdPtr, (*cmdPtr)->arg.addr);
+    return BHV_PROC_CONTINUE;
+}
+
+static s32 bhv_decoded_delay(struct BhvDecodedCmd **cmdPtr) {
+    if (gCurrentObject->bhvDelayTimer < (*cmdPtr)->arg.i - 1) {
+        gCurrentObject->bhvDelayTimer++;
+    } else {
+        gCurrentObject->bhvDelayTimer = 0;
+        *cmdPtr = bhv_decoded_next(*cmdPtr);
+    }
+    return BHV_PROC_BREAK;
+}
+
+static s32 bhv_decoded_begin_loop(struct BhvDecodedCmd **cmdPtr) {
+    cur_obj_bhv_stack_push((uintptr_t) ((*cmdPtr)->src + 1));
+    *cmdPtr = bhv_decoded_next(*cmdPtr);
+    return BHV_PROC_CONTINUE;
+}
+
+static s32 bhv_decoded_end_loop(struct BhvDecodedCmd **cmdPtr) {
+    struct BhvDecodedCmd *cmd = *cmdPtr;
+    const BehaviorScript *loopStart = (const BehaviorScript *) cur_obj_bhv_stack_pop();
+
+    cur_obj_bhv_stack_push((uintptr_t) loopStart);
+    *cmdPtr = bhv_decoded_jump(cmd, loopStart);
+    return BHV_PROC_BREAK;
+}
+
+static s32 bhv_decoded_call_native(struct BhvDecodedCmd **cmdPtr) {
+    ((NativeBhvFunc) (*cmdPtr)->arg.ptr)();
+
+    *cmdPtr = bhv_decoded_next(*cmdPtr);
+    return BHV_PROC_CONTINUE;
+}
+
+static s32 bhv_decoded_add_float(struct BhvDecodedCmd **cmdPtr) {
+    cur_obj_add_float((*cmdPtr)->field, (*cmdPtr)->arg.f);
+
+    *cmdPtr = bhv_decoded_next(*cmdPtr);
+    return BHV_PROC_CONTINUE;
+}
+
+static s32 bhv_decoded_set_float(struct BhvDecodedCmd **cmdPtr) {
+    cur_obj_set_float((*cmdPtr)->field, (*cmdPtr)->arg.f);
+
+    *cmdPtr = bhv_decoded_next(*cmdPtr);
+    return BHV_PROC_CONTINUE;
+}
+
+static s32 bhv_decoded_add_int(struct BhvDecodedCmd **cmdPtr) {
+    cur_obj_add_int((*cmdPtr)->field, (*cmdPtr)->arg.i);
+
+    *cmdPtr = bhv_decoded_next(*cmdPtr);
+    return BHV_PROC_CONTINUE;
+}
+
+static s32 bhv_decoded_set_int(struct BhvDecodedCmd **cmdPtr) {
+    cur_obj_set_int((*cmdPtr)->field, (*cmdPtr)->arg.i);
+
+    *cmdPtr = bhv_decoded_next(*cmdPtr);
+    return BHV_PROC_CONTINUE;
+}
+
+static s32 bhv_decoded_or_int(struct BhvDecodedCmd **cmdPtr) {
+    cur_obj_or_int((*cmdPtr)->field, (*cmdPtr)->arg.i);
+
+    *cmdPtr = bhv_decoded_next(*cmdPtr);
+    return BHV_PROC_CONTINUE;
+}
+
+static s32 bhv_decoded_animate_texture(struct BhvDecodedCmd **cmdPtr) {
+    if ((gGlobalTimer % (*cmdPtr)->arg.i) == 0) {
+        cur_obj_add_int((*cmdPtr)->field, 1);
+    }
+
+    *cmdPtr = bhv_decoded_next(*cmdPtr);
+    return BHV_PROC_CONTINUE;
+}
+
+// Decode the command at addr and add it to the lookup table.
+static struct BhvDecodedCmd *bhv_decode_cmd(const BehaviorScript *addr) {
+    uintptr_t key = (uintptr_t) addr >> 2;
+    u32 hash = (key ^ (key >> 11)) & (BHV_DECODED_HASH_SIZE - 1);
+    struct BhvDecodedCmd *cmd;
+    u8 opcode = *addr >> 24;
+
+    if (sBhvDecodedPoolUsed == BHV_DECODED_POOL_SIZE) {
+        sBhvDecodedPool = calloc(BHV_DECODED_POOL_SIZE, sizeof(struct BhvDecodedCmd));
+        sBhvDecodedPoolUsed = 0;
+    }
+    cmd = &sBhvDecodedPool[sBhvDecodedPoolUsed++];
+
+    cmd->src = addr;
+    cmd->size = sBhvCmdSizes[opcode];
+    cmd->field = (addr[0] >> 16) & 0xFF;
+
+    switch (opcode) {
+        case 0x0A: // BREAK
+        case 0x0B: // BREAK_UNUSED
+            cmd->proc = bhv_decoded_break;
+            break;
+        case 0x02: // CALL
+            cmd->proc = bhv_decoded_call;
+            cmd->arg.addr = segmented_to_virtual((void *) addr[1]);
+            break;
+        case 0x03: // RETURN
+            cmd->proc = bhv_decoded_return;
+            break;
+        case 0x04: // GOTO
+            cmd->proc = bhv_decoded_goto;
+            cmd->arg.addr = segmented_to_virtual((void *) addr[1]);
+            break;
+        case 0x01: // DELAY
+            cmd->proc = bhv_decoded_delay;
+            cmd->arg.i = (s16)(addr[0] & 0xFFFF);
+            break;
+        case 0x08: // BEGIN_LOOP
+            cmd->proc = bhv_decoded_begin_loop;
+            break;
+        case 0x09: // END_LOOP
+            cmd->proc = bhv_decoded_end_loop;
+            break;
+        case 0x0C: // CALL_NATIVE
+            cmd->proc = bhv_decoded_call_native;
+            cmd->arg.ptr = (void *) addr[1];
+            break;
+        case 0x0D: // ADD_FLOAT
+            cmd->proc = bhv_decoded_add_float;
+            cmd->arg.f = (s16)(addr[0] & 0xFFFF);
+            break;
+        case 0x0E: // SET_FLOAT
+            cmd->proc = bhv_decoded_set_float;
+            cmd->arg.f = (s16)(addr[0] & 0xFFFF);
+            break;
+        case 0x0F: // ADD_INT
+            cmd->proc = bhv_decoded_add_int;
+            cmd->arg.i = (s16)(addr[0] & 0xFFFF);
+            break;
+        case 0x10: // SET_INT
+            cmd->proc = bhv_decoded_set_int;
+            cmd->arg.i = (s16)(addr[0] & 0xFFFF);
+            break;
+        case 0x11: // OR_INT
+            cmd->proc = bhv_decoded_or_int;
+            cmd->arg.i = addr[0] & 0xFFFF;
+            break;
+        case 0x34: // ANIMATE_TEXTURE
+            cmd->proc = bhv_decoded_animate_texture;
+            cmd->arg.i = (s16)(addr[0] & 0xFFFF);
+            break;
+        default:
+            cmd->proc = bhv_decoded_generic;
+            break;
+    }
+
+    cmd->hashNext = sBhvDecodedHash[hash];
+    sBhvDecodedHash[hash] = cmd;
+
+    return cmd;
+}
+#endif
+
+#ifdef BHV_BENCHMARK
+#define BHV_BENCHMARK_FRAMES 300
+
+static u64 sBhvBenchmarkNs;
+static u32 sBhvBenchmarkObjects;
+static u32 sBhvBenchmarkStartFrame;
+
+// Accumulate the time spent executing one object's behavior script, and print
+// the average every BHV_BENCHMARK_FRAMES frames. Run with a cont.m64 in place
+// so that builds with and without BHV_PREDECODE can be compared on the same input.
+static void bhv_benchmark_record(u64 ns) {
+    sBhvBenchmarkNs += ns;
+    sBhvBenchmarkObjects++;
+
+    if (gGlobalTimer - sBhvBenchmarkStartFrame >= BHV_BENCHMARK_FRAMES) {
+        printf("bhv: frames %u-%u, %u objects, %u ns/object (%s)\n", sBhvBenchmarkStartFrame,
+               gGlobalTimer, sBhvBenchmarkObjects, (u32)(sBhvBenchmarkNs / sBhvBenchmarkObjects),
+#ifdef BHV_PREDECODE
+               "predecoded"
+#else
+               "interpreted"
+#endif
+        );
+        sBhvBenchmarkNs = 0;
+        sBhvBenchmarkObjects = 0;
+        sBhvBenchmarkStartFrame = gGlobalTimer;
+    }
+}
+#endif
+
 // Execute the behavior script of the current object, process the object flags, and other miscellaneous code for updating objects.
 void cur_obj_update(void) {
 
 
     s16 objFlags = gCurrentObject->oFlags;
     f32 distanceFromMario;
+#ifdef BHV_PREDECODE
+    struct BhvDecodedCmd *bhvCmd;
+#else
     BhvCommandProc bhvCmdProc;
+#endif
     s32 bhvProcResult;
+#ifdef BHV_BENCHMARK
+    u64 bhvStartTime;
+#endif
 
     // Calculate the distance from the object to Mario.
     if (objFlags & OBJ_FLAG_COMPUTE_DIST_TO_MARIO) {
@@ -920,14 +1238,30 @@ void cur_obj_update(void) {
     }
 
     // Execute the behavior script.
+#ifdef BHV_BENCHMARK
+    bhvStartTime = perf_timer_ns();
+#endif
+#ifdef BHV_PREDECODE
+    bhvCmd = bhv_decoded_lookup(gCurrentObject->curBhvCommand);
+
+    do {
+        bhvProcResult = bhvCmd->proc(&bhvCmd);
+    } while (bhvProcResult == BHV_PROC_CONTINUE);
+
+    gCurBhvCommand = bhvCmd->src;
+#else
     gCurBhvCommand = gCurrentObject->curBhvCommand;
 
     do {
         bhvCmdProc = BehaviorCmdTable[*gCurBhvCommand >> 24];
         bhvProcResult = bhvCmdProc();
     } while (bhvProcResult == BHV_PROC_CONTINUE);
+#endif
 
     gCurrentObject->curBhvCommand = gCurBhvCommand;
+#ifdef BHV_BENCHMARK
+    bhv_benchmark_record(perf_timer_ns() - bhvStartTime);
+#endif
 
     // Increment the object's timer.
     if (gCurrentObject->oTimer < 0x3FFFFFFF) {
@@ -194,6 +194,10 @@ struct GraphNodeCamera *init_graph_node_camera(struct AllocOnlyPool *pool,
         graphNode->config.mode = mode;
         graphNode->roll = 0;
         graphNode->rollScreen = 0;
+#ifndef TARGET_N64
+        graphNode->compiledCmds = NULL;
+        graphNode->numCompiledCmds = 0;
+#endif
 
         if (func != NULL) {
             func(GEO_CONTEXT_CREATE, &graphNode->fnNode.node, pool);
@@ -379,6 +383,92 @@ struct GraphNodeBillboard *init_graph_node_billboard(struct AllocOnlyPool *pool,
     return graphNode;
 }
 
+#ifndef TARGET_N64
+/**
+ * Walk a display list, growing the box [min, max] around the vertices it loads
+ * and counting the triangles it draws. Returns FALSE if the list can't be bounded
+ * in model space, e.g. because it loads its own matrices.
+ */
+static s32 display_list_accumulate_bounds(const Gfx *dl, Vec3f min, Vec3f max, s32 *numTriangles,
+                                          s32 depth) {
+    const Vtx *vtx;
+    s32 n;
+    s32 i;
+    s32 j;
+
+    if (depth > 8) {
+        return FALSE;
+    }
+
+    dl = segmented_to_virtual((void *) dl);
+    for (;;) {
+        switch (dl->words.w0 >> 24) {
+            case G_VTX:
+                vtx = segmented_to_virtual((void *) dl->words.w1);
+                n = (dl->words.w0 >> 12) & 0xFF;
+                for (i = 0; i < n; i++) {
+                    for (j = 0; j < 3; j++) {
+                        if (vtx[i].v.ob[j] < min[j]) {
+                            min[j] = vtx[i].v.ob[j];
+                        }
+                        if (vtx[i].v.ob[j] > max[j]) {
+                            max[j] = vtx[i].v.ob[j];
+                        }
+                    }
+                }
+                break;
+            case G_TRI1:
+                *numTriangles += 1;
+                break;
+            case G_TRI2:
+            case G_QUAD:
+                *numTriangles += 2;
+                break;
+            case G_MTX:
+            case G_POPMTX:
+            case G_TEXRECT:
+            case G_TEXRECTFLIP:
+            case G_FILLRECT:
+                return FALSE;
+            case G_DL:
+                if (((dl->words.w0 >> 16) & 0xFF) == G_DL_NOPUSH) {
+                    dl = segmented_to_virtual((void *) dl->words.w1);
+                    continue;
+                }
+                if (!display_list_accumulate_bounds((const Gfx *) dl->words.w1, min, max, numTriangles,
+                                                    depth + 1)) {
+                    return FALSE;
+                }
+                break;
+            case G_ENDDL:
+                return TRUE;
+        }
+        dl++;
+    }
+}
+
+/**
+ * Compute the bounding sphere used to frustum cull a display list node.
+ */
+static void init_display_list_bounds(struct GraphNodeDisplayList *graphNode) {
+    Vec3f min = { 32767.0f, 32767.0f, 32767.0f };
+    Vec3f max = { -32768.0f, -32768.0f, -32768.0f };
+
+    graphNode->boundsRadius = -1.0f;
+    graphNode->numTriangles = 0;
+
+    if (graphNode->displayList != NULL
+        && display_list_accumulate_bounds(graphNode->displayList, min, max, &graphNode->numTriangles, 0)
+        && min[0] <= max[0]) {
+        graphNode->boundsCenter[0] = (min[0] + max[0]) / 2.0f;
+        graphNode->boundsCenter[1] = (min[1] + max[1]) / 2.0f;
+        graphNode->boundsCenter[2] = (min[2] + max[2]) / 2.0f;
+        graphNode->boundsRadius =
+            sqrtf(sqr(max[0] - min[0]) + sqr(max[1] - min[1]) + sqr(max[2] - min[2])) / 2.0f;
+    }
+}
+#endif
+
 /**
  * Allocates and returns a newly created displaylist node
  */
@@ -393,6 +483,9 @@ struct GraphNodeDisplayList *init_graph_node_display_list(struct AllocOnlyPool *
         init_scene_graph_node_links(&graphNode->node, GRAPH_NODE_TYPE_DISPLAY_LIST);
         graphNode->node.flags = (drawingLayer << 8) | (graphNode->node.flags & 0xFF);
         graphNode->displayList = displayList;
+#ifndef TARGET_N64
+        init_display_list_bounds(graphNode);
+#endif
     }
 
     return graphNode;
@@ -118,6 +118,11 @@ struct DisplayListNode
     Mtx *transform;
     void *displayList;
     struct DisplayListNode *next;
+#ifndef TARGET_N64
+    struct GraphNodeObject *owner; // object being processed when appended, NULL for level geometry
+    f32 depth; // camera space depth, used to sort translucent layers back to front
+    u8 sortable; // level geometry from a display list node, can be drawn in any order
+#endif
 };
 
 /** GraphNode that manages the 8 top-level display lists that will be drawn
@@ -186,6 +191,12 @@ struct GraphNodeCamera
     /*0x34*/ Mat4 *matrixPtr; // pointer to look-at matrix of this camera as a Mat4
     /*0x38*/ s16 roll; // roll in look at matrix. Doesn't account for light direction unlike rollScreen.
     /*0x3A*/ s16 rollScreen; // rolls screen while keeping the light direction consistent
+#ifndef TARGET_N64
+    // Children of this camera flattened into a command stream by geo_compile_area,
+    // or NULL if they are processed recursively
+    struct GeoCompiledCmd *compiledCmds;
+    s32 numCompiledCmds;
+#endif
 };
 
 /** GraphNode that translates and rotates its children.
@@ -260,6 +271,13 @@ struct GraphNodeDisplayList
 {
     /*0x00*/ struct GraphNode node;
     /*0x14*/ void *displayList;
+#ifndef TARGET_N64
+    // Bounding sphere of the vertices drawn by displayList, in model space.
+    // A negative radius means the list could not be bounded and is never culled.
+    Vec3f boundsCenter;
+    f32 boundsRadius;
+    s32 numTriangles;
+#endif
 };
 
 /** GraphNode part that scales itself and its children.
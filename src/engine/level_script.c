@@ -2,6 +2,9 @@
 #ifdef NO_SEGMENTED_MEMORY
 #include <string.h>
 #endif
+#ifndef TARGET_N64
+#include <stdlib.h>
+#endif
 
 #include "sm64.h"
 #include "audio/external.h"
@@ -24,6 +27,13 @@
 #include "math_util.h"
 #include "surface_collision.h"
 #include "surface_load.h"
+#ifndef TARGET_N64
+#include "game/rendering_graph_node.h"
+#include "pc/configfile.h"
+#endif
+#ifdef LOAD_BENCHMARK
+#include "pc/load_benchmark.h"
+#endif
 
 #define CMD_GET(type, offset) (*(type *) (CMD_PROCESS_OFFSET(offset) + (u8 *) sCurrentCmd))
 
@@ -55,6 +65,166 @@ static s16 sScriptStatus;
 static s32 sRegister;
 static struct LevelCommand *sCurrentCmd;
 
+#ifndef TARGET_N64
+#define LEVEL_CACHE_SIZE 4
+#define LEVEL_CACHE_MAX_STEPS 512
+
+// A graph node tree built by a level command, and where it left the level pool
+struct LevelCacheStep {
+    struct LevelCommand *cmd;
+    u8 *freePtrBefore;
+    u8 *freePtrAfter;
+    void *result;
+};
+
+/**
+ * The level pool of a level script as it was right before FREE_LEVEL_POOL.
+ * On re-entry the pool lands at the same address, so the contents are copied
+ * back and the commands that build graph nodes reuse the recorded trees instead
+ * of running the geo layouts again. The remaining commands still run and write
+ * the same data as before, which keeps the pool layout identical.
+ */
+struct LevelCacheEntry {
+    struct LevelCommand *allocCmd;
+    s16 actNum;
+    u8 *startPtr;
+    s32 usedSpace;
+    u8 *data;
+    u32 lastUse;
+    s32 numSteps;
+    struct LevelCacheStep steps[LEVEL_CACHE_MAX_STEPS];
+};
+
+static struct LevelCacheEntry sLevelCache[LEVEL_CACHE_SIZE];
+static struct LevelCacheEntry *sLevelCacheRecord;
+static struct LevelCacheEntry *sLevelCacheReplay;
+static s32 sLevelCacheStep;
+static u32 sLevelCacheUseCounter;
+
+static void level_cache_invalidate(struct LevelCacheEntry *entry) {
+    free(entry->data);
+    entry->data = NULL;
+    entry->allocCmd = NULL;
+}
+
+/**
+ * Called when the level pool is allocated. Restores the pool if this level
+ * script was cached with the pool at the same address, otherwise starts
+ * recording it into the least recently used slot.
+ */
+static void level_cache_begin(void) {
+    struct LevelCacheEntry *entry;
+    struct LevelCacheEntry *victim = &sLevelCache[0];
+    s32 i;
+
+    sLevelCacheRecord = NULL;
+    sLevelCacheReplay = NULL;
+    sLevelCacheStep = 0;
+
+    if (!configLevelCache || sLevelPool == NULL) {
+        return;
+    }
+
+    for (i = 0; i < LEVEL_CACHE_SIZE; i++) {
+        entry = &sLevelCache[i];
+        if (entry->allocCmd == sCurrentCmd && entry->actNum == gCurrActNum) {
+            if (entry->startPtr == sLevelPool->startPtr && entry->usedSpace <= sLevelPool->totalSpace) {
+                memcpy(sLevelPool->startPtr, entry->data, entry->usedSpace);
+                entry->lastUse = ++sLevelCacheUseCounter;
+                sLevelCacheReplay = entry;
+                return;
+            }
+            level_cache_invalidate(entry);
+        }
+        if (victim->allocCmd != NULL
+            && (entry->allocCmd == NULL || entry->lastUse < victim->lastUse)) {
+            victim = entry;
+        }
+    }
+
+    level_cache_invalidate(victim);
+    victim->allocCmd = sCurrentCmd;
+    victim->actNum = gCurrActNum;
+    victim->startPtr = sLevelPool->startPtr;
+    victim->numSteps = 0;
+    sLevelCacheRecord = victim;
+}
+
+/**
+ * Returns the recorded result of the current graph building command if the
+ * level pool is being restored. If the script took a different path than when
+ * it was recorded, the entry is dropped and the command runs normally.
+ */
+static s32 level_cache_lookup(void **result) {
+    struct LevelCacheEntry *entry = sLevelCacheReplay;
+    struct LevelCacheStep *step;
+
+    if (entry == NULL) {
+        return FALSE;
+    }
+
+    step = &entry->steps[sLevelCacheStep];
+    if (sLevelCacheStep >= entry->numSteps || step->cmd != sCurrentCmd
+        || step->freePtrBefore != sLevelPool->freePtr) {
+        level_cache_invalidate(entry);
+        sLevelCacheReplay = NULL;
+        return FALSE;
+    }
+
+    sLevelCacheStep++;
+    sLevelPool->usedSpace += step->freePtrAfter - sLevelPool->freePtr;
+    sLevelPool->freePtr = step->freePtrAfter;
+    *result = step->result;
+    return TRUE;
+}
+
+static void level_cache_store(u8 *freePtrBefore, void *result) {
+    struct LevelCacheEntry *entry = sLevelCacheRecord;
+    struct LevelCacheStep *step;
+
+    if (entry == NULL) {
+        return;
+    }
+
+    if (entry->numSteps == LEVEL_CACHE_MAX_STEPS) {
+        level_cache_invalidate(entry);
+        sLevelCacheRecord = NULL;
+        return;
+    }
+
+    step = &entry->steps[entry->numSteps++];
+    step->cmd = sCurrentCmd;
+    step->freePtrBefore = freePtrBefore;
+    step->freePtrAfter = sLevelPool->freePtr;
+    step->result = result;
+}
+
+/**
+ * Called right before the level pool is shrunk to its used size.
+ */
+static void level_cache_end(void) {
+    struct LevelCacheEntry *entry = sLevelCacheRecord;
+
+    if (entry != NULL) {
+        entry->data = malloc(sLevelPool->usedSpace);
+        if (entry->data != NULL) {
+            memcpy(entry->data, sLevelPool->startPtr, sLevelPool->usedSpace);
+            entry->usedSpace = sLevelPool->usedSpace;
+            entry->lastUse = ++sLevelCacheUseCounter;
+        } else {
+            entry->allocCmd = NULL;
+        }
+    }
+
+    if (sLevelCacheReplay != NULL && sLevelCacheStep != sLevelCacheReplay->numSteps) {
+        level_cache_invalidate(sLevelCacheReplay);
+    }
+
+    sLevelCacheRecord = NULL;
+    sLevelCacheReplay = NULL;
+}
+#endif
+
 static s32 eval_script_op(s8 op, s32 arg) {
     s32 result = 0;
 
@@ -322,6 +492,9 @@ static void level_cmd_alloc_level_pool(void) {
     if (sLevelPool == NULL) {
         sLevelPool = alloc_only_pool_init(main_pool_available() - sizeof(struct AllocOnlyPool),
                                           MEMORY_POOL_LEFT);
+#ifndef TARGET_N64
+        level_cache_begin();
+#endif
     }
 
     sCurrentCmd = CMD_NEXT;
@@ -330,6 +503,9 @@ static void level_cmd_alloc_level_pool(void) {
 static void level_cmd_free_level_pool(void) {
     s32 i;
 
+#ifndef TARGET_N64
+    level_cache_end();
+#endif
     alloc_only_pool_resize(sLevelPool, sLevelPool->usedSpace);
     sLevelPool = NULL;
 
@@ -348,9 +524,22 @@ static void level_cmd_begin_area(void) {
     void *geoLayoutAddr = CMD_GET(void *, 4);
 
     if (areaIndex < 8) {
+#ifndef TARGET_N64
+        struct GraphNodeRoot *screenArea;
+        struct GraphNodeCamera *node;
+        u8 *poolPos = sLevelPool->freePtr;
+
+        if (!level_cache_lookup((void **) &screenArea)) {
+            screenArea = (struct GraphNodeRoot *) process_geo_layout(sLevelPool, geoLayoutAddr);
+            geo_compile_area(&screenArea->node, sLevelPool);
+            level_cache_store(poolPos, screenArea);
+        }
+        node = (struct GraphNodeCamera *) screenArea->views[0];
+#else
         struct GraphNodeRoot *screenArea =
             (struct GraphNodeRoot *) process_geo_layout(sLevelPool, geoLayoutAddr);
         struct GraphNodeCamera *node = (struct GraphNodeCamera *) screenArea->views[0];
+#endif
 
         sCurrAreaIndex = areaIndex;
         screenArea->areaIndex = areaIndex;
@@ -381,8 +570,18 @@ static void level_cmd_load_model_from_dl(void) {
     void *val3 = CMD_GET(void *, 4);
 
     if (val1 < 256) {
+#ifndef TARGET_N64
+        u8 *poolPos = sLevelPool->freePtr;
+
+        if (!level_cache_lookup((void **) &gLoadedGraphNodes[val1])) {
+            gLoadedGraphNodes[val1] =
+                (struct GraphNode *) init_graph_node_display_list(sLevelPool, 0, val2, val3);
+            level_cache_store(poolPos, gLoadedGraphNodes[val1]);
+        }
+#else
         gLoadedGraphNodes[val1] =
             (struct GraphNode *) init_graph_node_display_list(sLevelPool, 0, val2, val3);
+#endif
     }
 
     sCurrentCmd = CMD_NEXT;
@@ -393,7 +592,16 @@ static void level_cmd_load_model_from_geo(void) {
     void *arg1 = CMD_GET(void *, 4);
 
     if (arg0 < 256) {
+#ifndef TARGET_N64
+        u8 *poolPos = sLevelPool->freePtr;
+
+        if (!level_cache_lookup((void **) &gLoadedGraphNodes[arg0])) {
+            gLoadedGraphNodes[arg0] = process_geo_layout(sLevelPool, arg1);
+            level_cache_store(poolPos, gLoadedGraphNodes[arg0]);
+        }
+#else
         gLoadedGraphNodes[arg0] = process_geo_layout(sLevelPool, arg1);
+#endif
     }
 
     sCurrentCmd = CMD_NEXT;
@@ -613,6 +821,7 @@ static void level_cmd_set_terrain_data(void) {
         size = get_area_terrain_size(data) * sizeof(Collision);
         gAreas[sCurrAreaIndex].terrainData = alloc_only_pool_alloc(sLevelPool, size);
         memcpy(gAreas[sCurrAreaIndex].terrainData, data, size);
+        set_area_collision_bake(sCurrAreaIndex, data);
 #endif
     }
     sCurrentCmd = CMD_NEXT;
@@ -829,9 +1038,15 @@ struct LevelCommand *level_script_execute(struct LevelCommand *cmd) {
     sScriptStatus = SCRIPT_RUNNING;
     sCurrentCmd = cmd;
 
+#ifdef LOAD_BENCHMARK
+    load_benchmark_script_begin();
+#endif
     while (sScriptStatus == SCRIPT_RUNNING) {
         LevelScriptJumpTable[sCurrentCmd->type]();
     }
+#ifdef LOAD_BENCHMARK
+    load_benchmark_script_end();
+#endif
 
     profiler_log_thread5_time(LEVEL_SCRIPT_EXECUTE);
     init_render_image();
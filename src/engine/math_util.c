@@ -5,6 +5,10 @@
 #include "math_util.h"
 #include "surface_collision.h"
 
+#ifndef TARGET_N64
+#include "pc/mat4_simd.h"
+#endif
+
 #include "trig_tables.inc.c"
 
 // Variables for a spline curve animation (used for the flight path in the grand star cutscene)
@@ -341,6 +345,13 @@ void mtxf_billboard(Mat4 dest, Mat4 mtx, Vec3f position, s16 angle) {
     dest[2][2] = 1;
     dest[2][3] = 0;
 
+#ifndef TARGET_N64
+    if (gMat4Kernels.transform != NULL) {
+        gMat4Kernels.transform(dest[3], mtx, position[0], position[1], position[2]);
+        dest[3][3] = 1;
+        return;
+    }
+#endif
     dest[3][0] =
         mtx[0][0] * position[0] + mtx[1][0] * position[1] + mtx[2][0] * position[2] + mtx[3][0];
     dest[3][1] =
@@ -490,6 +501,13 @@ void mtxf_mul(Mat4 dest, Mat4 a, Mat4 b) {
     register f32 entry1;
     register f32 entry2;
 
+#ifndef TARGET_N64
+    if (gMat4Kernels.mul != NULL) {
+        gMat4Kernels.mul(dest, a, b);
+        return;
+    }
+#endif
+
     // column 0
     entry0 = a[0][0];
     entry1 = a[0][1];
@@ -534,6 +552,13 @@ void mtxf_mul(Mat4 dest, Mat4 a, Mat4 b) {
 void mtxf_scale_vec3f(Mat4 dest, Mat4 mtx, Vec3f s) {
     register s32 i;
 
+#ifndef TARGET_N64
+    if (gMat4Kernels.scale != NULL) {
+        gMat4Kernels.scale(dest, mtx, s);
+        return;
+    }
+#endif
+
     for (i = 0; i < 4; i++) {
         dest[0][i] = mtx[0][i] * s[0];
         dest[1][i] = mtx[1][i] * s[1];
@@ -552,6 +577,17 @@ void mtxf_mul_vec3s(Mat4 mtx, Vec3s b) {
     register f32 y = b[1];
     register f32 z = b[2];
 
+#ifndef TARGET_N64
+    if (gMat4Kernels.transform != NULL) {
+        Vec3f out;
+
+        gMat4Kernels.transform(out, mtx, x, y, z);
+        b[0] = out[0];
+        b[1] = out[1];
+        b[2] = out[2];
+        return;
+    }
+#endif
     b[0] = x * mtx[0][0] + y * mtx[1][0] + z * mtx[2][0] + mtx[3][0];
     b[1] = x * mtx[0][1] + y * mtx[1][1] + z * mtx[2][1] + mtx[3][1];
     b[2] = x * mtx[0][2] + y * mtx[1][2] + z * mtx[2][2] + mtx[3][2];
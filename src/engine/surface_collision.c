@@ -1,10 +1,12 @@
 #include <PR/ultratypes.h>
+#include <math.h>
 
 #include "sm64.h"
 #include "game/debug.h"
 #include "game/level_update.h"
 #include "game/mario.h"
 #include "game/object_list_processor.h"
+#include "game/profiler.h"
 #include "surface_collision.h"
 #include "surface_load.h"
 
@@ -199,6 +201,7 @@ s32 find_wall_collisions(struct WallCollisionData *colData) {
 
     // World (level) consists of a 16x16 grid. Find where the collision is on
     // the grid (round toward -inf)
+    PROFILER_ZONE_BEGIN(ZONE_COLLISION);
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0x0F;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0x0F;
 
@@ -212,6 +215,7 @@ s32 find_wall_collisions(struct WallCollisionData *colData) {
 
     // Increment the debug tracker.
     gNumCalls.wall += 1;
+    PROFILER_ZONE_END(ZONE_COLLISION);
 
     return numCollisions;
 }
@@ -326,6 +330,7 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
         return height;
     }
 
+    PROFILER_ZONE_BEGIN(ZONE_COLLISION);
     // Each level is split into cells to limit load, find the appropriate cell.
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0xF;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0xF;
@@ -347,6 +352,7 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
 
     // Increment the debug tracker.
     gNumCalls.ceil += 1;
+    PROFILER_ZONE_END(ZONE_COLLISION);
 
     return height;
 }
@@ -496,6 +502,7 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
         return height;
     }
 
+    PROFILER_ZONE_BEGIN(ZONE_COLLISION);
     // Each level is split into cells to limit load, find the appropriate cell.
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0xF;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0xF;
@@ -538,6 +545,7 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
 
     // Increment the debug tracker.
     gNumCalls.floor += 1;
+    PROFILER_ZONE_END(ZONE_COLLISION);
 
     return height;
 }
@@ -621,6 +629,625 @@ f32 find_poison_gas_level(f32 x, f32 z) {
     return gasLevel;
 }
 
+#ifndef TARGET_N64
+/**************************************************
+ *                 BATCHED QUERIES                *
+ **************************************************/
+
+/**
+ * These give the same results as calling find_wall_collisions, find_floor or
+ * find_ceil on each probe in order, but look up each cell once and walk its
+ * surface lists once for all the probes inside it. The checks against a single
+ * surface are the same as in the loops above.
+ */
+
+#define PROBE_BATCH_MAX 32
+
+/**
+ * Get the cell (z * 16 + x) of a probe, or -1 if the single query would
+ * return right away because the probe is outside the level boundary.
+ */
+static s32 probe_cell(s16 x, s16 z) {
+    if (x <= -LEVEL_BOUNDARY_MAX || x >= LEVEL_BOUNDARY_MAX) {
+        return -1;
+    }
+    if (z <= -LEVEL_BOUNDARY_MAX || z >= LEVEL_BOUNDARY_MAX) {
+        return -1;
+    }
+    return (((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0x0F) * 16 + (((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0x0F);
+}
+
+/**
+ * Gather `first` and the probes after it that are in the same cell into
+ * `group`, in order, and clear their cells so they are only handled once.
+ */
+static s32 probe_group(s16 *cells, s32 first, s32 count, s32 *group) {
+    s32 cell = cells[first];
+    s32 n = 0;
+    s32 i;
+
+    for (i = first; i < count; i++) {
+        if (cells[i] == cell) {
+            group[n++] = i;
+            cells[i] = -1;
+        }
+    }
+
+    return n;
+}
+
+/**
+ * The loop body of find_wall_collisions_from_list for one surface.
+ */
+static s32 check_wall_collision(struct Surface *surf, struct WallCollisionData *data,
+                                f32 x, f32 y, f32 z, f32 radius) {
+    f32 offset;
+    f32 w1, w2, w3;
+    f32 y1, y2, y3;
+
+    if (y < surf->lowerY || y > surf->upperY) {
+        return FALSE;
+    }
+
+    offset = surf->normal.x * x + surf->normal.y * y + surf->normal.z * z + surf->originOffset;
+
+    if (offset < -radius || offset > radius) {
+        return FALSE;
+    }
+
+    if (surf->flags & SURFACE_FLAG_X_PROJECTION) {
+        w1 = -surf->vertex1[2];            w2 = -surf->vertex2[2];            w3 = -surf->vertex3[2];
+        y1 = surf->vertex1[1];            y2 = surf->vertex2[1];            y3 = surf->vertex3[1];
+
+        if (surf->normal.x > 0.0f) {
+            if ((y1 - y) * (w2 - w1) - (w1 - -z) * (y2 - y1) > 0.0f
+                || (y2 - y) * (w3 - w2) - (w2 - -z) * (y3 - y2) > 0.0f
+                || (y3 - y) * (w1 - w3) - (w3 - -z) * (y1 - y3) > 0.0f) {
+                return FALSE;
+            }
+        } else {
+            if ((y1 - y) * (w2 - w1) - (w1 - -z) * (y2 - y1) < 0.0f
+                || (y2 - y) * (w3 - w2) - (w2 - -z) * (y3 - y2) < 0.0f
+                || (y3 - y) * (w1 - w3) - (w3 - -z) * (y1 - y3) < 0.0f) {
+                return FALSE;
+            }
+        }
+    } else {
+        w1 = surf->vertex1[0];            w2 = surf->vertex2[0];            w3 = surf->vertex3[0];
+        y1 = surf->vertex1[1];            y2 = surf->vertex2[1];            y3 = surf->vertex3[1];
+
+        if (surf->normal.z > 0.0f) {
+            if ((y1 - y) * (w2 - w1) - (w1 - x) * (y2 - y1) > 0.0f
+                || (y2 - y) * (w3 - w2) - (w2 - x) * (y3 - y2) > 0.0f
+                || (y3 - y) * (w1 - w3) - (w3 - x) * (y1 - y3) > 0.0f) {
+                return FALSE;
+            }
+        } else {
+            if ((y1 - y) * (w2 - w1) - (w1 - x) * (y2 - y1) < 0.0f
+                || (y2 - y) * (w3 - w2) - (w2 - x) * (y3 - y2) < 0.0f
+                || (y3 - y) * (w1 - w3) - (w3 - x) * (y1 - y3) < 0.0f) {
+                return FALSE;
+            }
+        }
+    }
+
+    if (gCheckingSurfaceCollisionsForCamera) {
+        if (surf->flags & SURFACE_FLAG_NO_CAM_COLLISION) {
+            return FALSE;
+        }
+    } else {
+        if (surf->type == SURFACE_CAMERA_BOUNDARY) {
+            return FALSE;
+        }
+
+        if (surf->type == SURFACE_VANISH_CAP_WALLS) {
+            if (gCurrentObject != NULL
+                && (gCurrentObject->activeFlags & ACTIVE_FLAG_MOVE_THROUGH_GRATE)) {
+                return FALSE;
+            }
+
+            if (gCurrentObject != NULL && gCurrentObject == gMarioObject
+                && (gMarioState->flags & MARIO_VANISH_CAP)) {
+                return FALSE;
+            }
+        }
+    }
+
+    data->x += surf->normal.x * (radius - offset);
+    data->z += surf->normal.z * (radius - offset);
+
+    if (data->numWalls < 4) {
+        data->walls[data->numWalls++] = surf;
+    }
+
+    return TRUE;
+}
+
+/**
+ * find_wall_collisions_from_list for a group of probes. Like there, each probe
+ * is checked where it was before this list pushed it.
+ */
+static void find_wall_collisions_from_list_batch(struct SurfaceNode *surfaceNode, struct WallCollisionData *colData,
+                                                 s32 *group, s32 numProbes, s32 *numCollisions) {
+    f32 x[PROBE_BATCH_MAX], y[PROBE_BATCH_MAX], z[PROBE_BATCH_MAX], radius[PROBE_BATCH_MAX];
+    struct Surface *surf;
+    s32 i;
+
+    for (i = 0; i < numProbes; i++) {
+        struct WallCollisionData *data = &colData[group[i]];
+        radius[i] = (data->radius > 200.0f) ? 200.0f : data->radius;
+        x[i] = data->x;
+        y[i] = data->y + data->offsetY;
+        z[i] = data->z;
+    }
+
+    while (surfaceNode != NULL) {
+        surf = surfaceNode->surface;
+        surfaceNode = surfaceNode->next;
+
+        for (i = 0; i < numProbes; i++) {
+            numCollisions[group[i]] += check_wall_collision(surf, &colData[group[i]], x[i], y[i], z[i], radius[i]);
+        }
+    }
+}
+
+/**
+ * find_wall_collisions for `count` probes, with the return value of each in `numCollisions`.
+ */
+void find_wall_collisions_batch(struct WallCollisionData *colData, s32 count, s32 *numCollisions) {
+    s16 cells[PROBE_BATCH_MAX];
+    s32 group[PROBE_BATCH_MAX];
+    s32 base, num, i, n, cellX, cellZ;
+
+    PROFILER_ZONE_BEGIN(ZONE_COLLISION);
+    for (base = 0; base < count; base += PROBE_BATCH_MAX) {
+        num = (count - base < PROBE_BATCH_MAX) ? count - base : PROBE_BATCH_MAX;
+
+        for (i = 0; i < num; i++) {
+            colData[base + i].numWalls = 0;
+            numCollisions[base + i] = 0;
+            cells[i] = probe_cell((s16) colData[base + i].x, (s16) colData[base + i].z);
+        }
+
+        for (i = 0; i < num; i++) {
+            if (cells[i] < 0) {
+                continue;
+            }
+            cellX = cells[i] & 0x0F;
+            cellZ = cells[i] >> 4;
+            n = probe_group(cells, i, num, group);
+
+            find_wall_collisions_from_list_batch(gDynamicSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WALLS].next,
+                                                 colData + base, group, n, numCollisions + base);
+            find_wall_collisions_from_list_batch(gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WALLS].next,
+                                                 colData + base, group, n, numCollisions + base);
+
+            gNumCalls.wall += n;
+        }
+    }
+    PROFILER_ZONE_END(ZONE_COLLISION);
+}
+
+/**
+ * The loop body of find_floor_from_list (floor) or find_ceil_from_list (ceiling)
+ * for one surface.
+ */
+static s32 check_floor_or_ceil(struct Surface *surf, s32 x, s32 y, s32 z, s32 floor, f32 *pheight) {
+    s32 x1, z1, x2, z2, x3, z3;
+    f32 height;
+
+    x1 = surf->vertex1[0];
+    z1 = surf->vertex1[2];
+    x2 = surf->vertex2[0];
+    z2 = surf->vertex2[2];
+    x3 = surf->vertex3[0];
+    z3 = surf->vertex3[2];
+
+    if (floor) {
+        if ((z1 - z) * (x2 - x1) - (x1 - x) * (z2 - z1) < 0
+            || (z2 - z) * (x3 - x2) - (x2 - x) * (z3 - z2) < 0
+            || (z3 - z) * (x1 - x3) - (x3 - x) * (z1 - z3) < 0) {
+            return FALSE;
+        }
+    } else {
+        if ((z1 - z) * (x2 - x1) - (x1 - x) * (z2 - z1) > 0
+            || (z2 - z) * (x3 - x2) - (x2 - x) * (z3 - z2) > 0
+            || (z3 - z) * (x1 - x3) - (x3 - x) * (z1 - z3) > 0) {
+            return FALSE;
+        }
+    }
+
+    if (gCheckingSurfaceCollisionsForCamera != 0) {
+        if (surf->flags & SURFACE_FLAG_NO_CAM_COLLISION) {
+            return FALSE;
+        }
+    } else if (surf->type == SURFACE_CAMERA_BOUNDARY) {
+        return FALSE;
+    }
+
+    if (surf->normal.y == 0.0f) {
+        return FALSE;
+    }
+
+    height = -(x * surf->normal.x + surf->normal.z * z + surf->originOffset) / surf->normal.y;
+    if (floor ? (y - (height + -78.0f) < 0.0f) : (y - (height - -78.0f) > 0.0f)) {
+        return FALSE;
+    }
+
+    *pheight = height;
+    return TRUE;
+}
+
+/**
+ * find_floor_from_list or find_ceil_from_list for a group of probes. Each probe
+ * stops at the first surface it hits, the list is walked until all have.
+ */
+static void find_floor_or_ceil_from_list_batch(struct SurfaceNode *surfaceNode, s16 (*pos)[3], s32 *group,
+                                               s32 numProbes, s32 floor, f32 *heights, struct Surface **surfs) {
+    s32 left[PROBE_BATCH_MAX];
+    struct Surface *surf;
+    s32 numLeft = numProbes;
+    s32 i, p;
+
+    for (i = 0; i < numProbes; i++) {
+        left[i] = group[i];
+    }
+
+    while (surfaceNode != NULL && numLeft > 0) {
+        surf = surfaceNode->surface;
+        surfaceNode = surfaceNode->next;
+
+        for (i = 0; i < numLeft; i++) {
+            p = left[i];
+            if (check_floor_or_ceil(surf, pos[p][0], pos[p][1], pos[p][2], floor, &heights[p])) {
+                surfs[p] = surf;
+                left[i--] = left[--numLeft];
+            }
+        }
+    }
+}
+
+/**
+ * find_floor (floor) or find_ceil (ceiling) for up to PROBE_BATCH_MAX probes.
+ */
+static void find_floor_or_ceil_batch(Vec3f *probes, s32 count, s32 floor, f32 *heights, struct Surface **surfs) {
+    s16 pos[PROBE_BATCH_MAX][3];
+    s16 cells[PROBE_BATCH_MAX];
+    s32 group[PROBE_BATCH_MAX];
+    f32 dynamicHeights[PROBE_BATCH_MAX];
+    struct Surface *dynamicSurfs[PROBE_BATCH_MAX];
+    s32 partition = floor ? SPATIAL_PARTITION_FLOORS : SPATIAL_PARTITION_CEILS;
+    f32 noHeight = floor ? -11000.0f : 20000.0f;
+    struct SurfaceNode *staticList;
+    s32 i, j, n, p, cellX, cellZ;
+
+    for (i = 0; i < count; i++) {
+        pos[i][0] = (s16) probes[i][0];
+        pos[i][1] = (s16) probes[i][1];
+        pos[i][2] = (s16) probes[i][2];
+        cells[i] = probe_cell(pos[i][0], pos[i][2]);
+        heights[i] = dynamicHeights[i] = noHeight;
+        surfs[i] = dynamicSurfs[i] = NULL;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (cells[i] < 0) {
+            continue;
+        }
+        cellX = cells[i] & 0x0F;
+        cellZ = cells[i] >> 4;
+        n = probe_group(cells, i, count, group);
+
+        find_floor_or_ceil_from_list_batch(gDynamicSurfacePartition[cellZ][cellX][partition].next,
+                                           pos, group, n, floor, dynamicHeights, dynamicSurfs);
+        staticList = gStaticSurfacePartition[cellZ][cellX][partition].next;
+        find_floor_or_ceil_from_list_batch(staticList, pos, group, n, floor, heights, surfs);
+
+        for (j = 0; j < n; j++) {
+            p = group[j];
+            if (floor) {
+                // The rest of find_floor, gFindFloorIncludeSurfaceIntangible is handled by the caller
+                if (surfs[p] != NULL && surfs[p]->type == SURFACE_INTANGIBLE) {
+                    surfs[p] = find_floor_from_list(staticList, pos[p][0], (s32)(heights[p] - 200.0f), pos[p][2],
+                                                    &heights[p]);
+                }
+                if (surfs[p] == NULL) {
+                    gNumFindFloorMisses += 1;
+                }
+                if (dynamicHeights[p] > heights[p]) {
+                    surfs[p] = dynamicSurfs[p];
+                    heights[p] = dynamicHeights[p];
+                }
+                gNumCalls.floor += 1;
+            } else {
+                if (dynamicHeights[p] < heights[p]) {
+                    surfs[p] = dynamicSurfs[p];
+                    heights[p] = dynamicHeights[p];
+                }
+                gNumCalls.ceil += 1;
+            }
+        }
+    }
+}
+
+/**
+ * find_floor for `count` probes.
+ */
+void find_floor_batch(Vec3f *probes, s32 count, f32 *heights, struct Surface **floors) {
+    s32 base, num;
+
+    // This only applies to the next floor found inside the level, so leave the probes up to
+    // that one to find_floor
+    while (gFindFloorIncludeSurfaceIntangible && count > 0) {
+        heights[0] = find_floor(probes[0][0], probes[0][1], probes[0][2], &floors[0]);
+        probes++;
+        heights++;
+        floors++;
+        count--;
+    }
+
+    PROFILER_ZONE_BEGIN(ZONE_COLLISION);
+    for (base = 0; base < count; base += PROBE_BATCH_MAX) {
+        num = (count - base < PROBE_BATCH_MAX) ? count - base : PROBE_BATCH_MAX;
+        find_floor_or_ceil_batch(probes + base, num, TRUE, heights + base, floors + base);
+    }
+    PROFILER_ZONE_END(ZONE_COLLISION);
+}
+
+/**
+ * find_ceil for `count` probes.
+ */
+void find_ceil_batch(Vec3f *probes, s32 count, f32 *heights, struct Surface **ceils) {
+    s32 base, num;
+
+    PROFILER_ZONE_BEGIN(ZONE_COLLISION);
+    for (base = 0; base < count; base += PROBE_BATCH_MAX) {
+        num = (count - base < PROBE_BATCH_MAX) ? count - base : PROBE_BATCH_MAX;
+        find_floor_or_ceil_batch(probes + base, num, FALSE, heights + base, ceils + base);
+    }
+    PROFILER_ZONE_END(ZONE_COLLISION);
+}
+
+/**
+ * Place `count` probes on the line through `from` and `to`, at `start` and then
+ * every `step` (1 being `to`). The position along the line is accumulated the
+ * way the camera's loops do it, so the probes land on the same points.
+ */
+void collision_probes_along_segment(Vec3f *probes, s32 count, Vec3f from, Vec3f to, f32 start, f32 step) {
+    f32 t = start;
+    s32 i;
+
+    for (i = 0; i < count; i++) {
+        probes[i][0] = from[0] + ((to[0] - from[0]) * t);
+        probes[i][1] = from[1] + ((to[1] - from[1]) * t);
+        probes[i][2] = from[2] + ((to[2] - from[2]) * t);
+        t += step;
+    }
+}
+
+/**************************************************
+ *                    RAYCASTS                    *
+ **************************************************/
+
+/**
+ * The cells only split the level in x and z, so the segment is walked through
+ * the columns it crosses, nearest first, and the y range it covers inside each
+ * column rejects surfaces by their lowerY and upperY. A surface is in every
+ * cell its bounds touch, so once the nearest hit so far is inside the current
+ * column nothing further along can be closer.
+ */
+
+/**
+ * Get the column a coordinate is in, with positions past the level boundary
+ * in the outer cells like surface_load puts the surfaces there.
+ */
+static s32 ray_cell_index(f32 coord) {
+    s32 index = (s32) ((coord + LEVEL_BOUNDARY_MAX) / CELL_SIZE);
+
+    if (index < 0) {
+        index = 0;
+    }
+    if (index > 15) {
+        index = 15;
+    }
+
+    return index;
+}
+
+/**
+ * Get the fraction of the segment where it leaves `cell` along one axis, or
+ * something above 1 if it never does. The outer cells have no outer edge.
+ */
+static f32 ray_cell_exit(s32 cell, s32 step, f32 orig, f32 dir) {
+    f32 edge;
+
+    if (step > 0 && cell < 15) {
+        edge = (cell + 1) * CELL_SIZE - LEVEL_BOUNDARY_MAX;
+    } else if (step < 0 && cell > 0) {
+        edge = cell * CELL_SIZE - LEVEL_BOUNDARY_MAX;
+    } else {
+        return 2.0f;
+    }
+
+    return (edge - orig) / dir;
+}
+
+/**
+ * Intersect the segment with a surface, from either side. Returns the fraction
+ * of the segment at the hit, or something above 1 for a miss.
+ */
+static f32 ray_surface_hit(struct Surface *surf, Vec3f orig, Vec3f dir) {
+    f32 e1x = surf->vertex2[0] - surf->vertex1[0];
+    f32 e1y = surf->vertex2[1] - surf->vertex1[1];
+    f32 e1z = surf->vertex2[2] - surf->vertex1[2];
+    f32 e2x = surf->vertex3[0] - surf->vertex1[0];
+    f32 e2y = surf->vertex3[1] - surf->vertex1[1];
+    f32 e2z = surf->vertex3[2] - surf->vertex1[2];
+    f32 px, py, pz;
+    f32 qx, qy, qz;
+    f32 sx, sy, sz;
+    f32 det, u, v, t;
+
+    px = dir[1] * e2z - dir[2] * e2y;
+    py = dir[2] * e2x - dir[0] * e2z;
+    pz = dir[0] * e2y - dir[1] * e2x;
+
+    det = e1x * px + e1y * py + e1z * pz;
+    if (det == 0.0f) {
+        return 2.0f;
+    }
+
+    sx = orig[0] - surf->vertex1[0];
+    sy = orig[1] - surf->vertex1[1];
+    sz = orig[2] - surf->vertex1[2];
+
+    // Barycentric coordinates, scaled by det to leave the division for last
+    u = sx * px + sy * py + sz * pz;
+
+    qx = sy * e1z - sz * e1y;
+    qy = sz * e1x - sx * e1z;
+    qz = sx * e1y - sy * e1x;
+
+    v = dir[0] * qx + dir[1] * qy + dir[2] * qz;
+    t = e2x * qx + e2y * qy + e2z * qz;
+
+    if (det < 0.0f) {
+        det = -det;
+        u = -u;
+        v = -v;
+        t = -t;
+    }
+
+    if (u < 0.0f || v < 0.0f || u + v > det || t < 0.0f || t > det) {
+        return 2.0f;
+    }
+
+    return t / det;
+}
+
+/**
+ * Find the nearest surface of a cell list that the segment hits before `*nearest`.
+ */
+static struct Surface *ray_hit_from_list(struct SurfaceNode *surfaceNode, Vec3f orig, Vec3f dir,
+                                         f32 minY, f32 maxY, f32 *nearest) {
+    struct Surface *surf;
+    struct Surface *hit = NULL;
+    f32 t;
+
+    while (surfaceNode != NULL) {
+        surf = surfaceNode->surface;
+        surfaceNode = surfaceNode->next;
+
+        if (surf->upperY < minY || surf->lowerY > maxY) {
+            continue;
+        }
+
+        if (gCheckingSurfaceCollisionsForCamera) {
+            if (surf->flags & SURFACE_FLAG_NO_CAM_COLLISION) {
+                continue;
+            }
+        } else if (surf->type == SURFACE_CAMERA_BOUNDARY) {
+            continue;
+        }
+
+        t = ray_surface_hit(surf, orig, dir);
+        if (t < *nearest) {
+            *nearest = t;
+            hit = surf;
+        }
+    }
+
+    return hit;
+}
+
+/**
+ * Find the first surface on the segment from `from` to `to`, out of the
+ * partition lists in `lists` (RAYCAST_FLOORS and so on), in both the static
+ * and dynamic partitions. Surfaces count from either side. Sets `hitPos` and
+ * `hitDist` to the hit, or to `to` and the segment length if nothing was hit.
+ * Like the other queries, this skips the surfaces the camera ignores while
+ * gCheckingSurfaceCollisionsForCamera is set and camera boundaries otherwise.
+ */
+struct Surface *find_surface_on_segment(Vec3f from, Vec3f to, s32 lists, Vec3f hitPos, f32 *hitDist) {
+    struct Surface *surf = NULL;
+    struct Surface *hit;
+    Vec3f dir;
+    f32 nearest = 2.0f;
+    f32 tEnter = 0.0f;
+    f32 tExit, tExitX, tExitZ, tEnd;
+    f32 y1, y2;
+    s32 cellX, cellZ, stepX, stepZ;
+    s32 list;
+
+    dir[0] = to[0] - from[0];
+    dir[1] = to[1] - from[1];
+    dir[2] = to[2] - from[2];
+
+    cellX = ray_cell_index(from[0]);
+    cellZ = ray_cell_index(from[2]);
+    stepX = (dir[0] > 0.0f) - (dir[0] < 0.0f);
+    stepZ = (dir[2] > 0.0f) - (dir[2] < 0.0f);
+    tExitX = ray_cell_exit(cellX, stepX, from[0], dir[0]);
+    tExitZ = ray_cell_exit(cellZ, stepZ, from[2], dir[2]);
+
+    PROFILER_ZONE_BEGIN(ZONE_COLLISION);
+    while (TRUE) {
+        tExit = MIN(MIN(tExitX, tExitZ), 1.0f);
+        tEnd = MIN(tExit, nearest);
+
+        y1 = from[1] + dir[1] * tEnter;
+        y2 = from[1] + dir[1] * tEnd;
+        if (y1 > y2) {
+            f32 swap = y1;
+            y1 = y2;
+            y2 = swap;
+        }
+
+        for (list = SPATIAL_PARTITION_FLOORS; list <= SPATIAL_PARTITION_WALLS; list++) {
+            if (!(lists & (1 << list))) {
+                continue;
+            }
+            hit = ray_hit_from_list(gDynamicSurfacePartition[cellZ][cellX][list].next, from, dir, y1, y2,
+                                    &nearest);
+            if (hit != NULL) {
+                surf = hit;
+            }
+            hit = ray_hit_from_list(gStaticSurfacePartition[cellZ][cellX][list].next, from, dir, y1, y2,
+                                    &nearest);
+            if (hit != NULL) {
+                surf = hit;
+            }
+        }
+
+        if (nearest <= tExit || tExit >= 1.0f) {
+            break;
+        }
+
+        // Step into the next column
+        if (tExitX < tExitZ) {
+            cellX += stepX;
+            tExitX = ray_cell_exit(cellX, stepX, from[0], dir[0]);
+        } else {
+            cellZ += stepZ;
+            tExitZ = ray_cell_exit(cellZ, stepZ, from[2], dir[2]);
+        }
+        tEnter = tExit;
+    }
+    PROFILER_ZONE_END(ZONE_COLLISION);
+
+    if (surf == NULL) {
+        nearest = 1.0f;
+    }
+
+    hitPos[0] = from[0] + dir[0] * nearest;
+    hitPos[1] = from[1] + dir[1] * nearest;
+    hitPos[2] = from[2] + dir[2] * nearest;
+    *hitDist = sqrtf(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]) * nearest;
+
+    return surf;
+}
+#endif
+
 /**************************************************
  *                      DEBUG                     *
  **************************************************/
@@ -8,6 +8,12 @@
 #define LEVEL_BOUNDARY_MAX 0x2000
 #define CELL_SIZE          0x400
 
+// Partition lists for find_surface_on_segment
+#define RAYCAST_FLOORS (1 << 0)
+#define RAYCAST_CEILS  (1 << 1)
+#define RAYCAST_WALLS  (1 << 2)
+#define RAYCAST_ALL    (RAYCAST_FLOORS | RAYCAST_CEILS | RAYCAST_WALLS)
+
 struct WallCollisionData
 {
     /*0x00*/ f32 x, y, z;
@@ -36,5 +42,12 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor);
 f32 find_water_level(f32 x, f32 z);
 f32 find_poison_gas_level(f32 x, f32 z);
 void debug_surface_list_info(f32 xPos, f32 zPos);
+#ifndef TARGET_N64
+void find_wall_collisions_batch(struct WallCollisionData *colData, s32 count, s32 *numCollisions);
+void find_floor_batch(Vec3f *probes, s32 count, f32 *heights, struct Surface **floors);
+void find_ceil_batch(Vec3f *probes, s32 count, f32 *heights, struct Surface **ceils);
+void collision_probes_along_segment(Vec3f *probes, s32 count, Vec3f from, Vec3f to, f32 start, f32 step);
+struct Surface *find_surface_on_segment(Vec3f from, Vec3f to, s32 lists, Vec3f hitPos, f32 *hitDist);
+#endif
 
 #endif // SURFACE_COLLISION_H
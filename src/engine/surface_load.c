@@ -1,4 +1,8 @@
 #include <PR/ultratypes.h>
+#ifndef TARGET_N64
+#include <stdlib.h>
+#include <string.h>
+#endif
 
 #include "prevent_bss_reordering.h"
 
@@ -14,6 +18,10 @@
 #include "game/mario.h"
 #include "game/object_list_processor.h"
 #include "surface_load.h"
+#ifndef TARGET_N64
+#include "game/area.h"
+#include "pc/configfile.h"
+#endif
 
 /**
  * Partitions for course and object surfaces. The arrays represent
@@ -33,6 +41,159 @@ struct Surface *sSurfacePool;
  */
 s16 sSurfacePoolSize;
 
+#ifndef TARGET_N64
+#define SURFACE_CACHE_SIZE 8
+
+/**
+ * The static surfaces and partition of an area after they were loaded. Node
+ * links are stored as pool indices (-1 for NULL) so that an entry can be
+ * restored into the surface pools wherever they were allocated.
+ */
+struct SurfaceCacheEntry {
+    s16 levelNum;
+    s16 areaIndex;
+    s16 *terrainData;
+    s8 *surfaceRooms;
+    u32 lastUse;
+    s16 numSurfaces;
+    s16 numNodes;
+    struct Surface *surfaces;
+    s16 *nodes; // pairs of next node and surface indices
+    s16 partition[16][16][3];
+};
+
+static struct SurfaceCacheEntry sSurfaceCache[SURFACE_CACHE_SIZE];
+static u32 sSurfaceCacheUseCounter;
+
+/**
+ * Set while load_area_terrain restores a cached area, so that the surface
+ * commands only skip over their data.
+ */
+static s8 sSurfaceCacheHit;
+
+/**
+ * Partitions baked by tools/collision_bake.py for the terrain of each area,
+ * and the one of the area being loaded.
+ */
+static const struct CollisionBake *sAreaCollisionBakes[8];
+static const struct CollisionBake *sCollisionBake;
+
+static s16 surface_cache_node_index(struct SurfaceNode *node) {
+    return node == NULL ? -1 : (s16)(node - sSurfaceNodePool);
+}
+
+static struct SurfaceNode *surface_cache_node_ptr(s16 index) {
+    return index < 0 ? NULL : &sSurfaceNodePool[index];
+}
+
+/**
+ * Rebuild the surface node pool and static partition from node indices, as
+ * stored by the surface cache and tools/collision_bake.py.
+ * @param nodes Pairs of next node and surface indices, in allocation order
+ * @param partition First node index of each [16][16][3] list
+ */
+static void link_static_surface_nodes(const s16 *nodes, s32 numNodes, const s16 *partition) {
+    struct SurfaceNode *lists = &gStaticSurfacePartition[0][0][0];
+    s32 i;
+
+    for (i = 0; i < numNodes; i++) {
+        sSurfaceNodePool[i].next = surface_cache_node_ptr(nodes[i * 2]);
+        sSurfaceNodePool[i].surface = &sSurfacePool[nodes[i * 2 + 1]];
+    }
+
+    for (i = 0; i < 16 * 16 * 3; i++) {
+        lists[i].next = surface_cache_node_ptr(partition[i]);
+    }
+
+    gSurfaceNodesAllocated = numNodes;
+}
+
+static struct SurfaceCacheEntry *surface_cache_find(s16 *terrainData, s8 *surfaceRooms) {
+    s32 i;
+
+    for (i = 0; i < SURFACE_CACHE_SIZE; i++) {
+        struct SurfaceCacheEntry *entry = &sSurfaceCache[i];
+
+        if (entry->surfaces != NULL && entry->levelNum == gCurrLevelNum
+            && entry->areaIndex == gCurrAreaIndex && entry->terrainData == terrainData
+            && entry->surfaceRooms == surfaceRooms) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Copy a cached area into the surface pools and static partition.
+ */
+static s32 surface_cache_restore(s16 *terrainData, s8 *surfaceRooms) {
+    struct SurfaceCacheEntry *entry = surface_cache_find(terrainData, surfaceRooms);
+
+    if (entry == NULL) {
+        return FALSE;
+    }
+
+    memcpy(sSurfacePool, entry->surfaces, entry->numSurfaces * sizeof(struct Surface));
+    link_static_surface_nodes(entry->nodes, entry->numNodes, &entry->partition[0][0][0]);
+    gSurfacesAllocated = entry->numSurfaces;
+    entry->lastUse = ++sSurfaceCacheUseCounter;
+    return TRUE;
+}
+
+/**
+ * Save the static surfaces that were just loaded, evicting the least recently
+ * used area if the cache is full.
+ */
+static void surface_cache_save(s16 *terrainData, s8 *surfaceRooms) {
+    struct SurfaceCacheEntry *entry = &sSurfaceCache[0];
+    s32 i;
+    s32 j;
+    s32 k;
+
+    for (i = 1; i < SURFACE_CACHE_SIZE && entry->surfaces != NULL; i++) {
+        if (sSurfaceCache[i].surfaces == NULL || sSurfaceCache[i].lastUse < entry->lastUse) {
+            entry = &sSurfaceCache[i];
+        }
+    }
+
+    free(entry->surfaces);
+    free(entry->nodes);
+    entry->surfaces = malloc(gSurfacesAllocated * sizeof(struct Surface) + 1);
+    entry->nodes = malloc(gSurfaceNodesAllocated * 2 * sizeof(s16) + 1);
+    if (entry->surfaces == NULL || entry->nodes == NULL) {
+        free(entry->surfaces);
+        free(entry->nodes);
+        entry->surfaces = NULL;
+        entry->nodes = NULL;
+        return;
+    }
+
+    memcpy(entry->surfaces, sSurfacePool, gSurfacesAllocated * sizeof(struct Surface));
+
+    for (i = 0; i < gSurfaceNodesAllocated; i++) {
+        entry->nodes[i * 2] = surface_cache_node_index(sSurfaceNodePool[i].next);
+        entry->nodes[i * 2 + 1] = (s16)(sSurfaceNodePool[i].surface - sSurfacePool);
+    }
+
+    for (i = 0; i < 16; i++) {
+        for (j = 0; j < 16; j++) {
+            for (k = 0; k < 3; k++) {
+                entry->partition[i][j][k] = surface_cache_node_index(gStaticSurfacePartition[i][j][k].next);
+            }
+        }
+    }
+
+    entry->levelNum = gCurrLevelNum;
+    entry->areaIndex = gCurrAreaIndex;
+    entry->terrainData = terrainData;
+    entry->surfaceRooms = surfaceRooms;
+    entry->numSurfaces = gSurfacesAllocated;
+    entry->numNodes = gSurfaceNodesAllocated;
+    entry->lastUse = ++sSurfaceCacheUseCounter;
+}
+#endif
+
 /**
  * Allocate the part of the surface node pool to contain a surface node.
  */
@@ -448,6 +609,16 @@ static void load_static_surfaces(s16 **data, s16 *vertexData, s16 surfaceType, s
     numSurfaces = *(*data);
     *data += 1;
 
+#ifndef TARGET_N64
+    if (sSurfaceCacheHit) {
+        *data += (3 + hasForce) * numSurfaces;
+        if (*surfaceRooms != NULL) {
+            *surfaceRooms += numSurfaces;
+        }
+        return;
+    }
+#endif
+
     for (i = 0; i < numSurfaces; i++) {
         if (*surfaceRooms != NULL) {
             room = *(*surfaceRooms);
@@ -466,7 +637,14 @@ static void load_static_surfaces(s16 **data, s16 *vertexData, s16 surfaceType, s
                 surface->force = 0;
             }
 
+#ifdef TARGET_N64
             add_surface(surface, FALSE);
+#else
+            // Baked partitions are linked once all surfaces are read
+            if (sCollisionBake == NULL) {
+                add_surface(surface, FALSE);
+            }
+#endif
         }
 
         *data += 3;
@@ -585,6 +763,71 @@ u32 get_area_terrain_size(s16 *data) {
 #endif
 
 
+#ifndef TARGET_N64
+/**
+ * Look up the baked partition of an area's terrain by the level data it was
+ * copied from.
+ */
+void set_area_collision_bake(s16 areaIndex, const Collision *terrain) {
+    const struct CollisionBake *bake;
+
+    sAreaCollisionBakes[areaIndex] = NULL;
+    for (bake = gCollisionBakes; bake->terrain != NULL; bake++) {
+        if (bake->terrain == terrain) {
+            sAreaCollisionBakes[areaIndex] = bake;
+            break;
+        }
+    }
+}
+
+/**
+ * Link the static surfaces that were just read into the partition using the
+ * baked node lists. Those are only valid if every surface falls into the same
+ * list as when it was baked, which depends on the float normals computed
+ * here, otherwise the partition is built the usual way.
+ */
+static void load_baked_partition(const struct CollisionBake *bake) {
+    struct Surface *surface;
+    s32 listIndex;
+    s32 i;
+
+    if (bake->numSurfaces == gSurfacesAllocated) {
+        for (i = 0; i < gSurfacesAllocated; i++) {
+            surface = &sSurfacePool[i];
+
+            if (surface->normal.y > 0.01) {
+                listIndex = SPATIAL_PARTITION_FLOORS;
+            } else if (surface->normal.y < -0.01) {
+                listIndex = SPATIAL_PARTITION_CEILS;
+            } else {
+                listIndex = SPATIAL_PARTITION_WALLS;
+            }
+
+            if (listIndex != bake->surfaceLists[i]) {
+                break;
+            }
+        }
+
+        if (i == gSurfacesAllocated) {
+            for (i = 0; i < gSurfacesAllocated; i++) {
+                surface = &sSurfacePool[i];
+                if (bake->surfaceLists[i] == SPATIAL_PARTITION_WALLS
+                    && (surface->normal.x < -0.707 || surface->normal.x > 0.707)) {
+                    surface->flags |= SURFACE_FLAG_X_PROJECTION;
+                }
+            }
+
+            link_static_surface_nodes(bake->nodes, bake->numNodes, bake->partition);
+            return;
+        }
+    }
+
+    for (i = 0; i < gSurfacesAllocated; i++) {
+        add_surface(&sSurfacePool[i], FALSE);
+    }
+}
+#endif
+
 /**
  * Process the level file, loading in vertices, surfaces, some objects, and environmental
  * boxes (water, gas, JRB fog).
@@ -592,6 +835,10 @@ u32 get_area_terrain_size(s16 *data) {
 void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects) {
     s16 terrainLoadType;
     s16 *vertexData;
+#ifndef TARGET_N64
+    s16 *terrainData = data;
+    s8 *terrainRooms = surfaceRooms;
+#endif
 
 
     // Initialize the data for this.
@@ -601,6 +848,12 @@ void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects
 
     clear_static_surfaces();
 
+#ifndef TARGET_N64
+    // Same terrain already partitioned once, skip straight to the objects.
+    sSurfaceCacheHit = configLevelCache && surface_cache_restore(terrainData, terrainRooms);
+    sCollisionBake = sSurfaceCacheHit ? NULL : sAreaCollisionBakes[index];
+#endif
+
     // A while loop iterating through each section of the level data. Sections of data
     // are prefixed by a terrain "type." This type is reused for surfaces as the surface
     // type.
@@ -626,6 +879,18 @@ void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects
         }
     }
 
+#ifndef TARGET_N64
+    if (sCollisionBake != NULL) {
+        load_baked_partition(sCollisionBake);
+        sCollisionBake = NULL;
+    }
+
+    if (configLevelCache && !sSurfaceCacheHit) {
+        surface_cache_save(terrainData, terrainRooms);
+    }
+    sSurfaceCacheHit = FALSE;
+#endif
+
     if (macroObjects != NULL && *macroObjects != -1) {
         // If the first macro object presetID is within the range [0, 29].
         // Generally an early spawning method, every object is in BBH (the first level).
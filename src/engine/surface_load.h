@@ -20,6 +20,21 @@ enum
 
 typedef struct SurfaceNode SpatialPartitionCell[3];
 
+#ifndef TARGET_N64
+// Static partition of an area terrain, generated by tools/collision_bake.py
+struct CollisionBake
+{
+    const Collision *terrain;
+    s16 numSurfaces;
+    s16 numNodes;
+    const u8 *surfaceLists; // partition list of each surface
+    const s16 *nodes;       // next node and surface index of each node
+    const s16 *partition;   // first node index of each [16][16][3] list
+};
+
+extern const struct CollisionBake gCollisionBakes[];
+#endif
+
 // Needed for bs bss reordering memes.
 
 extern SpatialPartitionCell gStaticSurfacePartition[16][16];
@@ -32,6 +47,9 @@ void alloc_surface_pools(void);
 #ifdef NO_SEGMENTED_MEMORY
 u32 get_area_terrain_size(s16 *data);
 #endif
+#ifndef TARGET_N64
+void set_area_collision_bake(s16 areaIndex, const Collision *terrain);
+#endif
 void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects);
 void clear_dynamic_surfaces(void);
 void load_object_collision_model(void);
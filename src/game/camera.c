@@ -1959,7 +1959,9 @@ s16 update_default_camera(struct Camera *c) {
     Vec3f cPos;
 
     struct Surface *marioFloor;
+#ifdef TARGET_N64
     struct Surface *cFloor;
+#endif
     struct Surface *tempFloor;
     struct Surface *ceil;
     f32 camFloorHeight;
@@ -1983,7 +1985,14 @@ s16 update_default_camera(struct Camera *c) {
 
     s16 nextYawVel;
     s16 yawVel = 0;
+#ifdef TARGET_N64
     f32 scale;
+#else
+    Vec3f floorProbes[6];
+    f32 floorHeights[6];
+    struct Surface *floorSurfs[6];
+    s32 i;
+#endif
     s32 avoidStatus = 0;
     s32 closeToMario = 0;
     f32 ceilHeight = find_ceil(gLakituState.goalPos[0],
@@ -2150,6 +2159,7 @@ s16 update_default_camera(struct Camera *c) {
 
     marioFloorHeight = 125.f + sMarioGeometry.currFloorHeight;
     marioFloor = sMarioGeometry.currFloor;
+#ifdef TARGET_N64
     camFloorHeight = find_floor(cPos[0], cPos[1] + 50.f, cPos[2], &cFloor) + 125.f;
     for (scale = 0.1f; scale < 1.f; scale += 0.2f) {
         scale_along_line(tempPos, cPos, sMarioCamState->pos, scale);
@@ -2159,6 +2169,21 @@ s16 update_default_camera(struct Camera *c) {
             marioFloor = tempFloor;
         }
     }
+#else
+    // The floor under the camera and 5 points from it to Mario, at scale 0.1, 0.3 ... 0.9
+    vec3f_set(floorProbes[0], cPos[0], cPos[1] + 50.f, cPos[2]);
+    collision_probes_along_segment(&floorProbes[1], 5, cPos, sMarioCamState->pos, 0.1f, 0.2f);
+    find_floor_batch(floorProbes, 6, floorHeights, floorSurfs);
+    camFloorHeight = floorHeights[0] + 125.f;
+    for (i = 1; i < 6; i++) {
+        tempFloorHeight = floorHeights[i] + 125.f;
+        tempFloor = floorSurfs[i];
+        if (tempFloor != NULL && tempFloorHeight > marioFloorHeight) {
+            marioFloorHeight = tempFloorHeight;
+            marioFloor = tempFloor;
+        }
+    }
+#endif
 
     // Lower the camera in Mario mode
     if (sSelectionFlags & CAM_MODE_MARIO_ACTIVE) {
@@ -6578,6 +6603,11 @@ s32 rotate_camera_around_walls(struct Camera *c, Vec3f cPos, s16 *avoidYaw, s16
     s32 status = 0;
     /// The current iteration. The algorithm takes 8 equal steps from Mario back to the camera.
     s32 step = 0;
+#ifndef TARGET_N64
+    struct WallCollisionData coarseData[8];
+    s32 coarseCollisions[8];
+    Vec3f coarsePos[8];
+#endif
 
 
     vec3f_get_dist_and_angle(sMarioCamState->pos, cPos, &dummyDist, &dummyPitch, &yawFromMario);
@@ -6591,7 +6621,22 @@ s32 rotate_camera_around_walls(struct Camera *c, Vec3f cPos, s16 *avoidYaw, s16
     /// This only increases when there is a wall collision found in the coarse pass
     fineRadius = 100.0f;
 
+#ifndef TARGET_N64
+    // The coarse pass doesn't depend on what it finds, so do all of its steps in one query
+    collision_probes_along_segment(coarsePos, 8, sMarioCamState->pos, cPos, 0.0f, 0.125f);
+    for (step = 0; step < 8; step++) {
+        coarseData[step].x = coarsePos[step][0];
+        coarseData[step].y = coarsePos[step][1];
+        coarseData[step].z = coarsePos[step][2];
+        coarseData[step].offsetY = 100.0f;
+        coarseData[step].radius = coarseRadius;
+        camera_approach_f32_symmetric_bool(&coarseRadius, 250.f, 30.f);
+    }
+    find_wall_collisions_batch(coarseData, 8, coarseCollisions);
+#endif
+
     for (step = 0; step < 8; step++) {
+#ifdef TARGET_N64
         // Start at Mario, move backwards to Lakitu's position
         colData.x = sMarioCamState->pos[0] + ((cPos[0] - sMarioCamState->pos[0]) * checkDist);
         colData.y = sMarioCamState->pos[1] + ((cPos[1] - sMarioCamState->pos[1]) * checkDist);
@@ -6601,6 +6646,11 @@ s32 rotate_camera_around_walls(struct Camera *c, Vec3f cPos, s16 *avoidYaw, s16
         camera_approach_f32_symmetric_bool(&coarseRadius, 250.f, 30.f);
 
         if (find_wall_collisions(&colData) != 0) {
+#else
+        colData = coarseData[step];
+
+        if (coarseCollisions[step] != 0) {
+#endif
             wall = colData.walls[colData.numWalls - 1];
 
             // If we're over halfway from Mario to Lakitu, then there's a wall near the camera, but
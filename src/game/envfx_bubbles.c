@@ -469,9 +469,26 @@ void append_bubble_vertex_buffer(Gfx *gfx, s32 index, Vec3s vertex1, Vec3s verte
  * for a specific particle. The display list is not passed as parameter but uses
  * the global sGfxCursor instead.
  */
+#ifdef G_PARTICLES
+static void *envfx_get_bubble_image(s32 mode, s16 index);
+
+void envfx_set_bubble_texture(s32 mode, s16 index) {
+    gDPSetTextureImage(sGfxCursor++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1, envfx_get_bubble_image(mode, index));
+    gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006D68);
+}
+
+/**
+ * Returns the texture of a specific particle, which envfx_set_bubble_texture
+ * loads. Groups of particles sharing it can be drawn as one batch.
+ */
+static void *envfx_get_bubble_image(s32 mode, s16 index) {
+    void **imageArr;
+    s16 frame = (gEnvFxBuffer + index)->animFrame;
+#else
 void envfx_set_bubble_texture(s32 mode, s16 index) {
     void **imageArr;
     s16 frame = (gEnvFxBuffer + index)->animFrame;
+#endif
 
     switch (mode) {
         case ENVFX_FLOWERS:
@@ -491,8 +508,12 @@ void envfx_set_bubble_texture(s32 mode, s16 index) {
             break;
     }
 
+#ifdef G_PARTICLES
+    return *(imageArr + frame);
+#else
     gDPSetTextureImage(sGfxCursor++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1, *(imageArr + frame));
     gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006D68);
+#endif
 }
 
 /**
@@ -501,6 +522,9 @@ void envfx_set_bubble_texture(s32 mode, s16 index) {
  */
 Gfx *envfx_update_bubble_particles(s32 mode, UNUSED Vec3s marioPos, Vec3s camFrom, Vec3s camTo) {
     s32 i;
+#ifdef G_PARTICLES
+    s32 count;
+#endif
     s16 radius, pitch, yaw;
 
     Vec3s vertex1;
@@ -523,6 +547,23 @@ Gfx *envfx_update_bubble_particles(s32 mode, UNUSED Vec3s marioPos, Vec3s camFro
 
     gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006D38);
 
+#ifdef G_PARTICLES
+    // each group of 5 still takes its texture from its first particle, but
+    // consecutive groups with the same texture go into the same batch
+    for (i = 0; i < sBubbleParticleMaxCount; i += count) {
+        void *image = envfx_get_bubble_image(mode, i);
+
+        for (count = 5; i + count < sBubbleParticleMaxCount; count += 5) {
+            if (envfx_get_bubble_image(mode, i + count) != image) {
+                break;
+            }
+        }
+
+        gDPPipeSync(sGfxCursor++);
+        envfx_set_bubble_texture(mode, i);
+        append_particle_batch(sGfxCursor++, i, count, vertex1, vertex2, vertex3, gBubbleTempVtx);
+    }
+#else
     for (i = 0; i < sBubbleParticleMaxCount; i += 5) {
         gDPPipeSync(sGfxCursor++);
         envfx_set_bubble_texture(mode, i);
@@ -533,6 +574,7 @@ Gfx *envfx_update_bubble_particles(s32 mode, UNUSED Vec3s marioPos, Vec3s camFro
         gSP1Triangle(sGfxCursor++, 9, 10, 11, 0);
         gSP1Triangle(sGfxCursor++, 12, 13, 14, 0);
     }
+#endif
 
     gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006AB0);
     gSPEndDisplayList(sGfxCursor++);
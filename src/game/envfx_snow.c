@@ -340,12 +340,51 @@ void append_snowflake_vertex_buffer(Gfx *gfx, s32 index, Vec3s vertex1, Vec3s ve
     gSPVertex(gfx, VIRTUAL_TO_PHYSICAL(vertBuf), 15, 0);
 }
 
+#ifdef G_PARTICLES
+/**
+ * Append a single command to 'gfx' drawing 'count' particles starting at
+ * 'index', which replaces a vertex buffer and 5 triangles per 5 particles.
+ * Like the vertex buffers, the template provides the texture coordinates and
+ * colors of the rotated triangle around (0,0,0).
+ */
+void append_particle_batch(Gfx *gfx, s32 index, s32 count, Vec3s vertex1, Vec3s vertex2, Vec3s vertex3,
+                           Vtx_t *template) {
+    Particles_t *batch = alloc_display_list(sizeof(Particles_t) + count * sizeof(*batch->pos));
+    s32 i;
+
+    if (batch == NULL) {
+        gSPNoOp(gfx);
+        return;
+    }
+
+    batch->tri[0] = template[0];
+    batch->tri[1] = template[1];
+    batch->tri[2] = template[2];
+    for (i = 0; i < 3; i++) {
+        batch->tri[0].ob[i] = vertex1[i];
+        batch->tri[1].ob[i] = vertex2[i];
+        batch->tri[2].ob[i] = vertex3[i];
+    }
+
+    batch->pos = (void *) (batch + 1);
+    for (i = 0; i < count; i++) {
+        batch->pos[i][0] = gEnvFxBuffer[index + i].xPos;
+        batch->pos[i][1] = gEnvFxBuffer[index + i].yPos;
+        batch->pos[i][2] = gEnvFxBuffer[index + i].zPos;
+    }
+
+    gSPParticles(gfx, batch, count);
+}
+#endif
+
 /**
  * Updates positions of snow particles and returns a pointer to a display list
  * drawing all snowflakes.
  */
 Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo) {
+#ifndef G_PARTICLES
     s32 i;
+#endif
     s16 radius, pitch, yaw;
     Vec3s snowCylinderPos;
     struct SnowFlakeVertex vertex1, vertex2, vertex3;
@@ -402,6 +441,11 @@ Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
         gSPDisplayList(gfx++, &tiny_bubble_dl_0B006CD8); // snowflake with blue edge
     }
 
+#ifdef G_PARTICLES
+    // the vertex buffers below always hold 5 snowflakes, so draw the same ones
+    append_particle_batch(gfx++, 0, (gSnowParticleCount + 4) / 5 * 5, (s16 *) &vertex1, (s16 *) &vertex2,
+                          (s16 *) &vertex3, &gSnowTempVtx[0].v);
+#else
     for (i = 0; i < gSnowParticleCount; i += 5) {
         append_snowflake_vertex_buffer(gfx++, i, (s16 *) &vertex1, (s16 *) &vertex2, (s16 *) &vertex3);
 
@@ -411,6 +455,7 @@ Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
         gSP1Triangle(gfx++, 9, 10, 11, 0);
         gSP1Triangle(gfx++, 12, 13, 14, 0);
     }
+#endif
 
     gSPDisplayList(gfx++, &tiny_bubble_dl_0B006AB0) gSPEndDisplayList(gfx++);
 
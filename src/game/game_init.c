@@ -638,7 +638,9 @@ void game_loop_one_iteration(void) {
         audio_game_loop_tick();
         config_gfx_pool();
         read_controller_inputs();
+        PROFILER_ZONE_BEGIN(ZONE_SCRIPT);
         levelCommandAddr = level_script_execute(levelCommandAddr);
+        PROFILER_ZONE_END(ZONE_SCRIPT);
         display_and_vsync();
 
         // when debug info is enabled, print the "BUF %d" information.
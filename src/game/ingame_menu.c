@@ -1,4 +1,7 @@
 #include <ultra64.h>
+#ifndef TARGET_N64
+#include <string.h>
+#endif
 
 #include "actors/common1.h"
 #include "area.h"
@@ -227,6 +230,30 @@ static u8 *alloc_ia8_text_from_i1(u16 *in, s16 width, s16 height) {
     return out;
 }
 
+#if !defined(TARGET_N64) && (defined(VERSION_JP) || defined(VERSION_SH))
+/**
+ * Unpacked font glyphs, filled in the first time each one is drawn. Unpacking
+ * into the gfx pool every frame gave glyphs a different address every time, and
+ * the renderer caches textures by address, so every character was imported
+ * again (or worse, hit a stale texture left at a reused pool address).
+ */
+static u8 sGlyphAtlas[256][8 * 16];
+static u8 sGlyphAtlasReady[256];
+
+static u8 *get_atlas_glyph_ia8(u8 c, u16 *packedTexture) {
+    u8 *unpacked;
+
+    if (!sGlyphAtlasReady[c]) {
+        if ((unpacked = alloc_ia8_text_from_i1(packedTexture, 8, 16)) == NULL) {
+            return NULL;
+        }
+        memcpy(sGlyphAtlas[c], unpacked, sizeof(sGlyphAtlas[c]));
+        sGlyphAtlasReady[c] = TRUE;
+    }
+    return sGlyphAtlas[c];
+}
+#endif
+
 void render_generic_char(u8 c) {
     void **fontLUT;
     void *packedTexture;
@@ -238,7 +265,11 @@ void render_generic_char(u8 c) {
     packedTexture = segmented_to_virtual(fontLUT[c]);
 
 #if defined(VERSION_JP) || defined(VERSION_SH)
+#ifndef TARGET_N64
+    unpackedTexture = get_atlas_glyph_ia8(c, packedTexture);
+#else
     unpackedTexture = alloc_ia8_text_from_i1(packedTexture, 8, 16);
+#endif
 
     gDPPipeSync(gDisplayListHead++);
     gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_IA, G_IM_SIZ_8b, 1, VIRTUAL_TO_PHYSICAL(unpackedTexture));
@@ -284,6 +315,26 @@ u8 *alloc_ia4_tex_from_i1(u8 *in, s16 width, s16 height) {
     return out;
 }
 
+#ifndef TARGET_N64
+// Unpacked font glyphs, filled in the first time each one is drawn so that
+// their texture addresses stay the same from frame to frame
+static u8 sGlyphAtlas[256][8 * 8];
+static u8 sGlyphAtlasReady[256];
+
+static u8 *get_atlas_glyph_ia4(u8 c, u8 *packedTexture) {
+    u8 *unpacked;
+
+    if (!sGlyphAtlasReady[c]) {
+        if ((unpacked = alloc_ia4_tex_from_i1(packedTexture, 8, 8)) == NULL) {
+            return NULL;
+        }
+        memcpy(sGlyphAtlas[c], unpacked, sizeof(sGlyphAtlas[c]));
+        sGlyphAtlasReady[c] = TRUE;
+    }
+    return sGlyphAtlas[c];
+}
+#endif
+
 void render_generic_char_at_pos(s16 xPos, s16 yPos, u8 c) {
     void **fontLUT;
     void *packedTexture;
@@ -291,7 +342,11 @@ void render_generic_char_at_pos(s16 xPos, s16 yPos, u8 c) {
 
     fontLUT = segmented_to_virtual(main_font_lut);
     packedTexture = segmented_to_virtual(fontLUT[c]);
+#ifndef TARGET_N64
+    unpackedTexture = get_atlas_glyph_ia4(c, packedTexture);
+#else
     unpackedTexture = alloc_ia4_tex_from_i1(packedTexture, 8, 8);
+#endif
 
     gDPPipeSync(gDisplayListHead++);
     gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_IA, G_IM_SIZ_16b, 1, VIRTUAL_TO_PHYSICAL(unpackedTexture));
@@ -1016,7 +1071,11 @@ void render_generic_dialog_char_at_pos(struct DialogEntry *dialog, s16 x, s16 y,
 
     fontLUT = segmented_to_virtual(main_font_lut);
     packedTexture = segmented_to_virtual(fontLUT[c]);
+#ifndef TARGET_N64
+    unpackedTexture = get_atlas_glyph_ia4(c, packedTexture);
+#else
     unpackedTexture = alloc_ia4_tex_from_i1(packedTexture, 8, 8);
+#endif
 
     gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_IA, G_IM_SIZ_16b, 1, VIRTUAL_TO_PHYSICAL(unpackedTexture));
     gSPDisplayList(gDisplayListHead++, dl_ia_text_tex_settings);
@@ -27,6 +27,9 @@
 #include "level_table.h"
 #include "course_table.h"
 #include "thread6.h"
+#ifdef LOAD_BENCHMARK
+#include "pc/load_benchmark.h"
+#endif
 
 #define PLAY_MODE_NORMAL 0
 #define PLAY_MODE_PAUSED 2
@@ -983,6 +986,16 @@ s32 play_mode_normal(void) {
     initiate_painting_warp();
     initiate_delayed_warp();
 
+#ifdef LOAD_BENCHMARK
+    {
+        s16 benchmarkLevel = load_benchmark_update();
+
+        if (benchmarkLevel != 0) {
+            initiate_warp(benchmarkLevel, 1, 0x0A, 0);
+        }
+    }
+#endif
+
     // If either initiate_painting_warp or initiate_delayed_warp initiated a
     // warp, change play mode accordingly.
     if (sCurrPlayMode == PLAY_MODE_NORMAL) {
@@ -1146,6 +1159,9 @@ s32 update_level(void) {
     if (changeLevel) {
         reset_volume();
         enable_background_sound();
+#ifdef LOAD_BENCHMARK
+        load_benchmark_start();
+#endif
     }
 
     return changeLevel;
@@ -1217,6 +1233,9 @@ s32 init_level(void) {
         sound_banks_disable(2, 0x0330);
     }
 
+#ifdef LOAD_BENCHMARK
+    load_benchmark_finish();
+#endif
     return 1;
 }
 
@@ -23,6 +23,10 @@
 #include "save_file.h"
 #include "skybox.h"
 #include "sound_init.h"
+#ifndef TARGET_N64
+#include "print.h"
+#include "pc/configfile.h"
+#endif
 
 #define TOAD_STAR_1_REQUIREMENT 12
 #define TOAD_STAR_2_REQUIREMENT 25
@@ -95,6 +99,12 @@ Gfx *geo_draw_mario_head_goddard(s32 callContext, struct GraphNode *node, Mat4 *
         D_8032C6A0 = gd_vblank;
         sfx = gd_sfx_to_play();
         play_menu_sounds(sfx);
+#ifndef TARGET_N64
+        if (configShowStats) {
+            print_text_fmt_int(22, 148, "GD MEM %d", get_alloc_mem_amt() / 1024);
+            print_text_fmt_int(22, 132, "GD GROW %d", get_gddl_grow_count());
+        }
+#endif
     }
     return gfx;
 }
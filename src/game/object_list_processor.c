@@ -590,6 +590,7 @@ void unload_deactivated_objects(void) {
  * and object surface management.
  */
 void update_objects(void) {
+    PROFILER_ZONE_BEGIN(ZONE_OBJECTS);
 
     gTimeStopState &= ~TIME_STOP_MARIO_OPENED_DOOR;
 
@@ -636,4 +637,5 @@ void update_objects(void) {
     }
 
     gPrevFrameObjectCount = gObjectCounter;
+    PROFILER_ZONE_END(ZONE_OBJECTS);
 }
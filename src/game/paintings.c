@@ -1,4 +1,7 @@
 #include <PR/ultratypes.h>
+#ifndef TARGET_N64
+#include <stdlib.h>
+#endif
 
 #include "sm64.h"
 #include "area.h"
@@ -189,6 +192,52 @@ struct Painting **sPaintingGroups[] = {
 s16 gPaintingUpdateCounter = 1;
 s16 gLastPaintingUpdateCounter = 0;
 
+#ifndef TARGET_N64
+#define PAINTING_CACHE_SIZE 4
+#define PAINTING_CACHE_IMAGES 2
+// Size of seg2_painting_triangle_mesh
+#define PAINTING_MESH_MAX_VTX 157
+#define PAINTING_MESH_MAX_TRIS 264
+
+/**
+ * The generated mesh and display lists of a rippling painting, kept across frames since each
+ * frame is drawn before the next one is generated.
+ *
+ * The distance from each vertex to the ripple's origin only changes when a new ripple starts,
+ * and the mesh only changes when the ripple is updated, so each is only regenerated when the
+ * state it was generated for changes.
+ */
+struct PaintingMeshCache {
+    struct Painting *painting;
+    u32 lastUse;
+    /// Distance from each vertex to the ripple origin, divided by the dispersion factor
+    f32 rippleDistance[PAINTING_MESH_MAX_VTX];
+    f32 originX;
+    f32 originY;
+    f32 originSize;
+    f32 originDispersion;
+    s8 distanceValid;
+    struct PaintingMeshVertex mesh[PAINTING_MESH_MAX_VTX];
+    Vec3f triNorms[PAINTING_MESH_MAX_TRIS];
+    f32 rippleTimer;
+    f32 rippleMag;
+    f32 rippleRate;
+    s8 meshValid;
+    /// Set if the mesh was regenerated this frame
+    s8 meshChanged;
+    /// The vertices and display list of each image, and the alpha they were made with
+    Vtx *verts[PAINTING_CACHE_IMAGES];
+    Gfx *dlists[PAINTING_CACHE_IMAGES];
+    s8 dlistValid[PAINTING_CACHE_IMAGES];
+    u8 dlistAlpha[PAINTING_CACHE_IMAGES];
+};
+
+static struct PaintingMeshCache sPaintingCaches[PAINTING_CACHE_SIZE];
+/// The cache entry of the painting being drawn, or NULL to generate the mesh in gEffectsMemoryPool
+static struct PaintingMeshCache *sCurrPaintingCache;
+static u32 sPaintingCacheUseCounter;
+#endif
+
 /**
  * Stop paintings in paintingGroup from rippling if their id is different from *idptr.
  */
@@ -606,27 +655,34 @@ void painting_update_ripple_state(struct Painting *painting) {
  * @return the ripple function at posX, posY
  * note that posX and posY correspond to a point on the face of the painting, not actual axes
  */
-s16 calculate_ripple_at_point(struct Painting *painting, f32 posX, f32 posY) {
-    /// Controls the peaks of the ripple.
-    f32 rippleMag = painting->currRippleMag;
-    /// Controls the ripple's frequency
-    f32 rippleRate = painting->currRippleRate;
+static f32 calculate_ripple_distance(struct Painting *painting, f32 posX, f32 posY) {
     /// Controls how fast the ripple spreads
     f32 dispersionFactor = painting->dispersionFactor;
-    /// How far the ripple has spread
-    f32 rippleTimer = painting->rippleTimer;
     /// x and y ripple origin
     f32 rippleX = painting->rippleX;
     f32 rippleY = painting->rippleY;
 
     f32 distanceToOrigin;
-    f32 rippleDistance;
 
     posX *= painting->size / PAINTING_SIZE;
     posY *= painting->size / PAINTING_SIZE;
     distanceToOrigin = sqrtf((posX - rippleX) * (posX - rippleX) + (posY - rippleY) * (posY - rippleY));
     // A larger dispersionFactor makes the ripple spread slower
-    rippleDistance = distanceToOrigin / dispersionFactor;
+    return distanceToOrigin / dispersionFactor;
+}
+
+/**
+ * @return the ripple function at a point rippleDistance away from the ripple's origin, as returned
+ * by calculate_ripple_distance
+ */
+static s16 calculate_ripple_at_distance(struct Painting *painting, f32 rippleDistance) {
+    /// Controls the peaks of the ripple.
+    f32 rippleMag = painting->currRippleMag;
+    /// Controls the ripple's frequency
+    f32 rippleRate = painting->currRippleRate;
+    /// How far the ripple has spread
+    f32 rippleTimer = painting->rippleTimer;
+
     if (rippleTimer < rippleDistance) {
         // if the ripple hasn't reached the point yet, make the point magnitude 0
         return 0;
@@ -640,6 +696,10 @@ s16 calculate_ripple_at_point(struct Painting *painting, f32 posX, f32 posY) {
     }
 }
 
+s16 calculate_ripple_at_point(struct Painting *painting, f32 posX, f32 posY) {
+    return calculate_ripple_at_distance(painting, calculate_ripple_distance(painting, posX, posY));
+}
+
 /**
  * If movable, return the ripple function at (posX, posY)
  * else return 0
@@ -672,9 +732,107 @@ s16 ripple_if_movable(struct Painting *painting, s16 movable, s16 posX, s16 posY
  *
  * The mesh used in game, seg2_painting_triangle_mesh, is in bin/segment2.c.
  */
+#ifndef TARGET_N64
+/**
+ * Find or claim the cache entry of a painting, and point gPaintingMesh and gPaintingTriNorms at it.
+ */
+static struct PaintingMeshCache *painting_get_mesh_cache(struct Painting *painting, s16 numVtx, s16 numTris) {
+    struct PaintingMeshCache *cache = NULL;
+    struct PaintingMeshCache *victim = &sPaintingCaches[0];
+    s16 i;
+
+    if (numVtx > PAINTING_MESH_MAX_VTX || numTris > PAINTING_MESH_MAX_TRIS) {
+        return NULL;
+    }
+
+    for (i = 0; i < PAINTING_CACHE_SIZE; i++) {
+        if (sPaintingCaches[i].painting == painting) {
+            cache = &sPaintingCaches[i];
+            break;
+        }
+        if (sPaintingCaches[i].lastUse < victim->lastUse) {
+            victim = &sPaintingCaches[i];
+        }
+    }
+
+    if (cache == NULL) {
+        // The display lists are sized for the previous painting's texture maps
+        cache = victim;
+        for (i = 0; i < PAINTING_CACHE_IMAGES; i++) {
+            free(cache->verts[i]);
+            free(cache->dlists[i]);
+            cache->verts[i] = NULL;
+            cache->dlists[i] = NULL;
+        }
+        cache->painting = painting;
+        cache->distanceValid = FALSE;
+        cache->meshValid = FALSE;
+    }
+
+    cache->lastUse = ++sPaintingCacheUseCounter;
+    gPaintingMesh = cache->mesh;
+    gPaintingTriNorms = cache->triNorms;
+    return cache;
+}
+
+/**
+ * Same as painting_generate_mesh, but reuses the cached vertex distances if the ripple's origin has
+ * not changed, and the whole mesh if the ripple has not been updated.
+ */
+static void painting_generate_cached_mesh(struct PaintingMeshCache *cache, struct Painting *painting,
+                                          s16 *mesh, s16 numVtx) {
+    s16 i;
+
+    if (!cache->distanceValid || cache->originX != painting->rippleX || cache->originY != painting->rippleY
+        || cache->originSize != painting->size || cache->originDispersion != painting->dispersionFactor) {
+        for (i = 0; i < numVtx; i++) {
+            if (mesh[i * 3 + 3]) {
+                cache->rippleDistance[i] = calculate_ripple_distance(painting, mesh[i * 3 + 1], mesh[i * 3 + 2]);
+            }
+        }
+        cache->originX = painting->rippleX;
+        cache->originY = painting->rippleY;
+        cache->originSize = painting->size;
+        cache->originDispersion = painting->dispersionFactor;
+        cache->distanceValid = TRUE;
+        cache->meshValid = FALSE;
+    }
+
+    cache->meshChanged = !cache->meshValid || cache->rippleTimer != painting->rippleTimer
+                         || cache->rippleMag != painting->currRippleMag
+                         || cache->rippleRate != painting->currRippleRate;
+    if (!cache->meshChanged) {
+        return;
+    }
+
+    for (i = 0; i < numVtx; i++) {
+        cache->mesh[i].pos[0] = mesh[i * 3 + 1];
+        cache->mesh[i].pos[1] = mesh[i * 3 + 2];
+        cache->mesh[i].pos[2] = 0;
+        if (mesh[i * 3 + 3]) {
+            cache->mesh[i].pos[2] = calculate_ripple_at_distance(painting, cache->rippleDistance[i]);
+        }
+    }
+
+    cache->rippleTimer = painting->rippleTimer;
+    cache->rippleMag = painting->currRippleMag;
+    cache->rippleRate = painting->currRippleRate;
+    cache->meshValid = TRUE;
+    for (i = 0; i < PAINTING_CACHE_IMAGES; i++) {
+        cache->dlistValid[i] = FALSE;
+    }
+}
+#endif
+
 void painting_generate_mesh(struct Painting *painting, s16 *mesh, s16 numTris) {
     s16 i;
 
+#ifndef TARGET_N64
+    if (sCurrPaintingCache != NULL) {
+        painting_generate_cached_mesh(sCurrPaintingCache, painting, mesh, numTris);
+        return;
+    }
+#endif
     gPaintingMesh = mem_pool_alloc(gEffectsMemoryPool, numTris * sizeof(struct PaintingMeshVertex));
     if (gPaintingMesh == NULL) {
     }
@@ -707,7 +865,17 @@ void painting_generate_mesh(struct Painting *painting, s16 *mesh, s16 numTris) {
 void painting_calculate_triangle_normals(s16 *mesh, s16 numVtx, s16 numTris) {
     s16 i;
 
+#ifndef TARGET_N64
+    if (sCurrPaintingCache != NULL) {
+        if (!sCurrPaintingCache->meshChanged) {
+            return;
+        }
+    } else {
+        gPaintingTriNorms = mem_pool_alloc(gEffectsMemoryPool, numTris * sizeof(Vec3f));
+    }
+#else
     gPaintingTriNorms = mem_pool_alloc(gEffectsMemoryPool, numTris * sizeof(Vec3f));
+#endif
     if (gPaintingTriNorms == NULL) {
     }
     for (i = 0; i < numTris; i++) {
@@ -775,6 +943,12 @@ void painting_average_vertex_normals(s16 *neighborTris, s16 numVtx) {
     s16 neighbors;
     s16 entry = 0;
 
+#ifndef TARGET_N64
+    if (sCurrPaintingCache != NULL && !sCurrPaintingCache->meshChanged) {
+        return;
+    }
+#endif
+
     for (i = 0; i < numVtx; i++) {
         f32 nx = 0.0f;
         f32 ny = 0.0f;
@@ -817,7 +991,8 @@ void painting_average_vertex_normals(s16 *neighborTris, s16 numVtx) {
  * If the textureMap doesn't describe the whole mesh, then multiple calls are needed to draw the whole
  * painting.
  */
-Gfx *render_painting(u8 *img, s16 tWidth, s16 tHeight, s16 *textureMap, s16 mapVerts, s16 mapTris, u8 alpha) {
+static Gfx *render_painting_to(Vtx *verts, Gfx *dlist, u8 *img, s16 tWidth, s16 tHeight,
+                               s16 *textureMap, s16 mapVerts, s16 mapTris, u8 alpha) {
     s16 group;
     s16 map;
     s16 triGroup;
@@ -825,21 +1000,10 @@ Gfx *render_painting(u8 *img, s16 tWidth, s16 tHeight, s16 *textureMap, s16 mapV
     s16 meshVtx;
     s16 tx;
     s16 ty;
-
-    // We can fit 15 (16 / 3) vertices in the RSP's vertex buffer.
-    // Group triangles by 5, with one remainder group.
     s16 triGroups = mapTris / 5;
     s16 remGroupTris = mapTris % 5;
-    s16 numVtx = mapTris * 3;
-
-    s16 commands = triGroups * 2 + remGroupTris + 7;
-    Vtx *verts = alloc_display_list(numVtx * sizeof(Vtx));
-    Gfx *dlist = alloc_display_list(commands * sizeof(Gfx));
     Gfx *gfx = dlist;
 
-    if (verts == NULL || dlist == NULL) {
-    }
-
     gLoadBlockTexture(gfx++, tWidth, tHeight, G_IM_FMT_RGBA, img);
 
     // Draw the groups of 5 first
@@ -894,6 +1058,60 @@ Gfx *render_painting(u8 *img, s16 tWidth, s16 tHeight, s16 *textureMap, s16 mapV
     return dlist;
 }
 
+Gfx *render_painting(u8 *img, s16 tWidth, s16 tHeight, s16 *textureMap, s16 mapVerts, s16 mapTris, u8 alpha) {
+    // We can fit 15 (16 / 3) vertices in the RSP's vertex buffer.
+    // Group triangles by 5, with one remainder group.
+    s16 triGroups = mapTris / 5;
+    s16 remGroupTris = mapTris % 5;
+    s16 numVtx = mapTris * 3;
+
+    s16 commands = triGroups * 2 + remGroupTris + 7;
+    Vtx *verts = alloc_display_list(numVtx * sizeof(Vtx));
+    Gfx *dlist = alloc_display_list(commands * sizeof(Gfx));
+
+    if (verts == NULL || dlist == NULL) {
+    }
+
+    return render_painting_to(verts, dlist, img, tWidth, tHeight, textureMap, mapVerts, mapTris, alpha);
+}
+
+#ifndef TARGET_N64
+/**
+ * Same as render_painting, but keeps the display list of each image of the painting being drawn
+ * and only rebuilds it when the mesh or alpha changed.
+ */
+static Gfx *render_cached_painting(s16 image, u8 *img, s16 tWidth, s16 tHeight, s16 *textureMap,
+                                   s16 mapVerts, s16 mapTris, u8 alpha) {
+    struct PaintingMeshCache *cache = sCurrPaintingCache;
+
+    if (cache == NULL || image >= PAINTING_CACHE_IMAGES) {
+        return render_painting(img, tWidth, tHeight, textureMap, mapVerts, mapTris, alpha);
+    }
+
+    if (cache->dlists[image] == NULL) {
+        cache->verts[image] = malloc(mapTris * 3 * sizeof(Vtx));
+        cache->dlists[image] = malloc((mapTris / 5 * 2 + mapTris % 5 + 7) * sizeof(Gfx));
+        cache->dlistValid[image] = FALSE;
+        if (cache->verts[image] == NULL || cache->dlists[image] == NULL) {
+            free(cache->verts[image]);
+            free(cache->dlists[image]);
+            cache->verts[image] = NULL;
+            cache->dlists[image] = NULL;
+            return render_painting(img, tWidth, tHeight, textureMap, mapVerts, mapTris, alpha);
+        }
+    }
+
+    if (!cache->dlistValid[image] || cache->dlistAlpha[image] != alpha) {
+        render_painting_to(cache->verts[image], cache->dlists[image], img, tWidth, tHeight, textureMap,
+                           mapVerts, mapTris, alpha);
+        cache->dlistValid[image] = TRUE;
+        cache->dlistAlpha[image] = alpha;
+    }
+
+    return cache->dlists[image];
+}
+#endif
+
 /**
  * Orient the painting mesh for rendering.
  */
@@ -952,7 +1170,11 @@ Gfx *painting_ripple_image(struct Painting *painting) {
         textureMap = segmented_to_virtual(textureMaps[i]);
         meshVerts = textureMap[0];
         meshTris = textureMap[meshVerts * 3 + 1];
+#ifndef TARGET_N64
+        gSPDisplayList(gfx++, render_cached_painting(i, textures[i], tWidth, tHeight, textureMap, meshVerts, meshTris, painting->alpha));
+#else
         gSPDisplayList(gfx++, render_painting(textures[i], tWidth, tHeight, textureMap, meshVerts, meshTris, painting->alpha));
+#endif
     }
 
     // Update the ripple, may automatically reset the painting's state.
@@ -990,7 +1212,11 @@ Gfx *painting_ripple_env_mapped(struct Painting *painting) {
     textureMap = segmented_to_virtual(textureMaps[0]);
     meshVerts = textureMap[0];
     meshTris = textureMap[meshVerts * 3 + 1];
+#ifndef TARGET_N64
+    gSPDisplayList(gfx++, render_cached_painting(0, tArray[0], tWidth, tHeight, textureMap, meshVerts, meshTris, painting->alpha));
+#else
     gSPDisplayList(gfx++, render_painting(tArray[0], tWidth, tHeight, textureMap, meshVerts, meshTris, painting->alpha));
+#endif
 
     // Update the ripple, may automatically reset the painting's state.
     painting_update_ripple_state(painting);
@@ -1003,7 +1229,8 @@ Gfx *painting_ripple_env_mapped(struct Painting *painting) {
 
 /**
  * Generates a mesh, calculates vertex normals for lighting, and renders a rippling painting.
- * The mesh and vertex normals are regenerated and freed every frame.
+ * The mesh and vertex normals are regenerated and freed every frame, except on PC where they are
+ * cached until the ripple changes.
  */
 Gfx *display_painting_rippling(struct Painting *painting) {
     s16 *mesh = segmented_to_virtual(seg2_painting_triangle_mesh);
@@ -1012,6 +1239,10 @@ Gfx *display_painting_rippling(struct Painting *painting) {
     s16 numTris = mesh[numVtx * 3 + 1];
     Gfx *dlist;
 
+#ifndef TARGET_N64
+    sCurrPaintingCache = painting_get_mesh_cache(painting, numVtx, numTris);
+#endif
+
     // Generate the mesh and its lighting data
     painting_generate_mesh(painting, mesh, numVtx);
     painting_calculate_triangle_normals(mesh, numVtx, numTris);
@@ -1027,6 +1258,13 @@ Gfx *display_painting_rippling(struct Painting *painting) {
             break;
     }
 
+#ifndef TARGET_N64
+    if (sCurrPaintingCache != NULL) {
+        sCurrPaintingCache = NULL;
+        return dlist;
+    }
+#endif
+
     // The mesh data is freed every frame.
     mem_pool_free(gEffectsMemoryPool, gPaintingMesh);
     mem_pool_free(gEffectsMemoryPool, gPaintingTriNorms);
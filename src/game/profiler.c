@@ -296,6 +296,11 @@ void draw_profiler_mode_0(void) {
 // Draw the Profiler per frame. Toggle the mode if the player presses L while this
 // renderer is active.
 void draw_profiler(void) {
+#ifdef ZONE_PROFILER
+    // PC builds time zones with the host clock instead of osGetTime
+    zone_profiler_draw();
+    return;
+#endif
     if (gPlayer1Controller->buttonPressed & L_TRIG) {
         gProfilerMode ^= 1;
     }
@@ -48,4 +48,11 @@ void profiler_log_gfx_time(enum ProfilerGfxEvent eventID);
 void profiler_log_vblank_time(void);
 void draw_profiler(void);
 
+#ifndef TARGET_N64
+#include "pc/zone_profiler.h"
+#else
+#define PROFILER_ZONE_BEGIN(zone)
+#define PROFILER_ZONE_END(zone)
+#endif
+
 #endif // PROFILER_H
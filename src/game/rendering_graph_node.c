@@ -11,6 +11,18 @@
 #include "shadow.h"
 #include "sm64.h"
 
+#ifndef TARGET_N64
+#include <stdlib.h>
+
+#include "pc/configfile.h"
+#include "pc/gfx/gfx_pc.h"
+#ifdef TARGET_DOS
+#include "pc/gfx/gfx_dos_api.h"
+#endif
+#include "pc/benchmark.h"
+#include "pc/zone_profiler.h"
+#endif
+
 /**
  * This file contains the code that processes the scene graph for rendering.
  * The scene graph is responsible for drawing everything except the HUD / text boxes.
@@ -129,6 +141,330 @@ u16 gAreaUpdateCounter = 0;
 LookAt lookAt;
 #endif
 
+#ifndef TARGET_N64
+struct GeoCullStats gGeoCullStats;
+
+/**
+ * Set while processing a frame that the renderer is going to drop (frameskip).
+ * The graph is still traversed, since node functions update the camera, advance
+ * animations, set the HOLP and even consume random numbers, but nothing that
+ * only produces output (display lists, shadows, the skybox) is generated.
+ */
+static u8 sGeoLogicOnly = FALSE;
+
+/**
+ * The view frustum of the current perspective node, in camera space. The side
+ * planes pass through the camera, so a point at (x, depth) is inside the right
+ * plane when x * hCos - depth * hSin <= 0, and likewise for the others.
+ */
+static struct {
+    f32 hCos, hSin;
+    f32 vCos, vSin;
+    f32 near, far;
+} sFrustum;
+
+/**
+ * One command of a flattened static subtree, see geo_compile_area.
+ */
+struct GeoCompiledCmd {
+    struct GraphNode *node;
+    Mat4 *transform; // local transformation of GEO_CMD_MATRIX
+    s32 op;
+    s32 end; // index of the command after this node's subtree
+};
+
+enum GeoCompiledOp {
+    GEO_CMD_GROUP,
+    GEO_CMD_DISPLAY_LIST,
+    GEO_CMD_MATRIX,
+    GEO_CMD_SCALE,
+    GEO_CMD_POP,
+    GEO_CMD_DYNAMIC,
+};
+
+static void geo_process_compiled(struct GeoCompiledCmd *cmds, s32 count);
+
+static void geo_update_frustum(f32 fov, f32 aspect, f32 near, f32 far) {
+    // Same one degree of slack as obj_is_in_view always had
+    s16 halfFov = (fov / 2.0f + 1.0f) * 32768.0f / 180.0f + 0.5f;
+    f32 vTan = sins(halfFov) / coss(halfFov);
+    f32 hTan = vTan * aspect;
+
+    sFrustum.vCos = 1.0f / sqrtf(1.0f + vTan * vTan);
+    sFrustum.vSin = vTan * sFrustum.vCos;
+    sFrustum.hCos = 1.0f / sqrtf(1.0f + hTan * hTan);
+    sFrustum.hSin = hTan * sFrustum.hCos;
+    sFrustum.near = near;
+    sFrustum.far = far;
+}
+
+/**
+ * Test a sphere given in camera space against the left and right planes of the frustum.
+ */
+static s32 geo_sphere_in_side_planes(f32 *center, f32 radius) {
+    f32 depth = -center[2];
+
+    return center[0] * sFrustum.hCos - depth * sFrustum.hSin <= radius
+           && -center[0] * sFrustum.hCos - depth * sFrustum.hSin <= radius;
+}
+
+/**
+ * Test a sphere given in camera space against all six planes of the frustum.
+ */
+static s32 geo_sphere_in_frustum(f32 *center, f32 radius) {
+    f32 depth = -center[2];
+
+    if (depth + radius < sFrustum.near || depth - radius > sFrustum.far) {
+        return FALSE;
+    }
+    if (!geo_sphere_in_side_planes(center, radius)) {
+        return FALSE;
+    }
+    if (center[1] * sFrustum.vCos - depth * sFrustum.vSin > radius
+        || -center[1] * sFrustum.vCos - depth * sFrustum.vSin > radius) {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Check whether the bounding sphere of a display list node, transformed by the
+ * top of the matrix stack, intersects the view frustum.
+ */
+static s32 geo_display_list_in_view(struct GraphNodeDisplayList *node) {
+    Mat4 *mtx = &gMatStack[gMatStackIndex];
+    Vec3f center;
+    f32 scale;
+    f32 axisScale;
+    s32 i;
+
+    if (!configFrustumCulling || node->boundsRadius < 0.0f || gCurGraphNodeCamera == NULL
+        || gCurGraphNodeCamFrustum == NULL) {
+        return TRUE;
+    }
+
+    scale = 0.0f;
+    for (i = 0; i < 3; i++) {
+        center[i] = node->boundsCenter[0] * (*mtx)[0][i] + node->boundsCenter[1] * (*mtx)[1][i]
+                    + node->boundsCenter[2] * (*mtx)[2][i] + (*mtx)[3][i];
+        axisScale = sqr((*mtx)[i][0]) + sqr((*mtx)[i][1]) + sqr((*mtx)[i][2]);
+        if (axisScale > scale) {
+            scale = axisScale;
+        }
+    }
+
+    return geo_sphere_in_frustum(center, node->boundsRadius * sqrtf(scale));
+}
+
+static void geo_append_display_list(void *displayList, s16 layer);
+
+// The level geometry node currently being appended, see geo_append_display_list
+static struct GraphNodeDisplayList *sGeoAppendNode = NULL;
+
+/**
+ * Append the display list of a display list node unless it is out of view.
+ */
+static void geo_cull_display_list(struct GraphNodeDisplayList *node) {
+    if (node->displayList != NULL && !sGeoLogicOnly) {
+        if (geo_display_list_in_view(node)) {
+            sGeoAppendNode = node;
+            geo_append_display_list(node->displayList, node->node.flags >> 8);
+            sGeoAppendNode = NULL;
+            gGeoCullStats.listsDrawn++;
+            gGeoCullStats.trianglesDrawn += node->numTriangles;
+        } else {
+            gGeoCullStats.listsCulled++;
+            gGeoCullStats.trianglesCulled += node->numTriangles;
+        }
+    }
+}
+#endif
+
+#ifndef TARGET_N64
+#define GEO_SORT_KEY_CACHE_SIZE 256
+#define GEO_SORT_KEY_MAX_CMDS 64
+
+/**
+ * A master list entry while its layer is being sorted.
+ */
+struct GeoSortEntry {
+    struct DisplayListNode *node;
+    uintptr_t texture;
+    uintptr_t combine;
+    f32 depth; // depth of the first entry of the object this entry belongs to
+    s32 group; // index of that first entry
+    s32 index;
+};
+
+static struct {
+    void *displayList;
+    uintptr_t texture;
+    uintptr_t combine;
+} sGeoSortKeyCache[GEO_SORT_KEY_CACHE_SIZE];
+
+/**
+ * Find the first texture image and combiner set by a display list, following
+ * calls and branches into other lists. These are what makes the renderer flush,
+ * so drawing lists with the same key next to each other saves state changes.
+ */
+static void geo_display_list_sort_key(void *displayList, s32 cacheable, uintptr_t *texture,
+                                      uintptr_t *combine) {
+    u32 slot = ((uintptr_t) displayList >> 3) % GEO_SORT_KEY_CACHE_SIZE;
+    Gfx *returnStack[4];
+    s32 depth = 0;
+    Gfx *cmd = displayList;
+    s32 i;
+
+    if (sGeoSortKeyCache[slot].displayList == displayList) {
+        *texture = sGeoSortKeyCache[slot].texture;
+        *combine = sGeoSortKeyCache[slot].combine;
+        return;
+    }
+
+    *texture = 0;
+    *combine = 0;
+    for (i = 0; i < GEO_SORT_KEY_MAX_CMDS && (*texture == 0 || *combine == 0); i++) {
+        u8 opcode = cmd->words.w0 >> 24;
+
+        if (opcode == G_SETTIMG && *texture == 0) {
+            *texture = cmd->words.w1;
+        } else if (opcode == G_SETCOMBINE && *combine == 0) {
+            *combine = (cmd->words.w0 & 0xFFFFFF) * 31 + cmd->words.w1;
+        } else if (opcode == G_DL) {
+            if (((cmd->words.w0 >> 16) & 1) == G_DL_NOPUSH) {
+                cmd = (Gfx *) cmd->words.w1;
+                continue;
+            } else if (depth < 4) {
+                returnStack[depth++] = cmd + 1;
+                cmd = (Gfx *) cmd->words.w1;
+                continue;
+            }
+        } else if (opcode == (u8) G_ENDDL) {
+            if (depth == 0) {
+                break;
+            }
+            cmd = returnStack[--depth];
+            continue;
+        }
+        cmd++;
+    }
+
+    // Generated lists live in the per frame pool and must not be remembered
+    if (!cacheable) {
+        return;
+    }
+    sGeoSortKeyCache[slot].displayList = displayList;
+    sGeoSortKeyCache[slot].texture = *texture;
+    sGeoSortKeyCache[slot].combine = *combine;
+}
+
+/**
+ * Opaque layers: level geometry first, grouped by texture and combiner, then
+ * everything else in the order it was added.
+ */
+static int geo_compare_opaque(const void *a, const void *b) {
+    const struct GeoSortEntry *e1 = a;
+    const struct GeoSortEntry *e2 = b;
+
+    if (e1->node->sortable != e2->node->sortable) {
+        return e1->node->sortable ? -1 : 1;
+    }
+    if (e1->node->sortable) {
+        if (e1->texture != e2->texture) {
+            return e1->texture < e2->texture ? -1 : 1;
+        }
+        if (e1->combine != e2->combine) {
+            return e1->combine < e2->combine ? -1 : 1;
+        }
+    }
+    return e1->index - e2->index;
+}
+
+/**
+ * Translucent layers: back to front, keeping the lists of one object together
+ * and in order, since the first of them may set up state for the others.
+ */
+static int geo_compare_translucent(const void *a, const void *b) {
+    const struct GeoSortEntry *e1 = a;
+    const struct GeoSortEntry *e2 = b;
+
+    if (e1->depth != e2->depth) {
+        return e1->depth > e2->depth ? -1 : 1;
+    }
+    if (e1->group != e2->group) {
+        return e1->group - e2->group;
+    }
+    return e1->index - e2->index;
+}
+
+/**
+ * Sort one layer of a master list and count the texture and combiner changes
+ * before and after. Generated lists outside objects (water, paintings, ...) may
+ * depend on or set up state in ways we can't see, so they are never moved and
+ * nothing is moved across them.
+ */
+static void geo_sort_master_list_layer(struct GraphNodeMasterList *node, s32 layer, s32 sort,
+                                       uintptr_t *lastKey, uintptr_t *lastSortedKey) {
+    struct GeoSortEntry *entries;
+    struct DisplayListNode *currList;
+    s32 count = 0;
+    s32 start = 0;
+    s32 i;
+
+    for (currList = node->listHeads[layer]; currList != NULL; currList = currList->next) {
+        count++;
+    }
+    entries = alloc_only_pool_alloc(gDisplayListHeap, count * sizeof(struct GeoSortEntry));
+    if (entries == NULL) {
+        return;
+    }
+
+    for (i = 0, currList = node->listHeads[layer]; i < count; i++, currList = currList->next) {
+        entries[i].node = currList;
+        entries[i].index = i;
+        geo_display_list_sort_key(currList->displayList, currList->sortable, &entries[i].texture,
+                                  &entries[i].combine);
+        if (i > 0 && currList->owner != NULL && currList->owner == entries[i - 1].node->owner) {
+            entries[i].depth = entries[i - 1].depth;
+            entries[i].group = entries[i - 1].group;
+        } else {
+            entries[i].depth = currList->depth;
+            entries[i].group = i;
+        }
+        if ((entries[i].texture ^ entries[i].combine) != *lastKey) {
+            gGeoCullStats.stateChanges++;
+            *lastKey = entries[i].texture ^ entries[i].combine;
+        }
+    }
+
+    if (sort) {
+        for (i = 0; i <= count; i++) {
+            if (i == count || (entries[i].node->owner == NULL && !entries[i].node->sortable)) {
+                if (i - start > 1) {
+                    qsort(&entries[start], i - start, sizeof(struct GeoSortEntry),
+                          (layer == LAYER_TRANSPARENT || layer == LAYER_TRANSPARENT_INTER)
+                              ? geo_compare_translucent : geo_compare_opaque);
+                }
+                start = i + 1;
+            }
+        }
+        node->listHeads[layer] = entries[0].node;
+        for (i = 0; i < count - 1; i++) {
+            entries[i].node->next = entries[i + 1].node;
+        }
+        entries[count - 1].node->next = NULL;
+        node->listTails[layer] = entries[count - 1].node;
+    }
+
+    for (i = 0; i < count; i++) {
+        if ((entries[i].texture ^ entries[i].combine) != *lastSortedKey) {
+            gGeoCullStats.stateChangesSorted++;
+            *lastSortedKey = entries[i].texture ^ entries[i].combine;
+        }
+    }
+}
+#endif
+
 /**
  * Process a master list node.
  */
@@ -138,6 +474,12 @@ static void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
     s32 enableZBuffer = (node->node.flags & GRAPH_RENDER_Z_BUFFER) != 0;
     struct RenderModeContainer *modeList = &renderModeTable_1Cycle[enableZBuffer];
     struct RenderModeContainer *mode2List = &renderModeTable_2Cycle[enableZBuffer];
+#ifndef TARGET_N64
+    uintptr_t lastKey = 0;
+    uintptr_t lastSortedKey = 0;
+    Mtx *lastTransform = NULL;
+    u8 lastSortable = FALSE;
+#endif
 
     // @bug This is where the LookAt values should be calculated but aren't.
     // As a result, environment mapping is broken on Fast3DEX2 without the
@@ -152,6 +494,36 @@ static void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
         gSPSetGeometryMode(gDisplayListHead++, G_ZBUFFER);
     }
 
+#ifndef TARGET_N64
+    // The LookAt is the same for every list, so it is loaded once here
+    // instead of once for every appended list
+    gSPLookAt(gDisplayListHead++, &lookAt);
+    gGeoCullStats.stateChangesSorted++;
+    for (i = 0; i < GFX_NUM_MASTER_LISTS; i++) {
+        if ((currList = node->listHeads[i]) != NULL) {
+            gDPSetRenderMode(gDisplayListHead++, modeList->modes[i], mode2List->modes[i]);
+            gGeoCullStats.stateChanges++;
+            gGeoCullStats.stateChangesSorted++;
+            geo_sort_master_list_layer(node, i,
+                                       configSortDisplayLists && enableZBuffer && i != LAYER_FORCE
+                                           && i != LAYER_OPAQUE_DECAL && i != LAYER_TRANSPARENT_DECAL,
+                                       &lastKey, &lastSortedKey);
+            for (currList = node->listHeads[i]; currList != NULL; currList = currList->next) {
+                // Before, every list loaded both the LookAt and its matrix. Level
+                // geometry doesn't touch the matrix, so the next list can reuse it
+                gGeoCullStats.stateChanges += 2;
+                if (!configSortDisplayLists || !lastSortable || currList->transform != lastTransform) {
+                    gSPMatrix(gDisplayListHead++, VIRTUAL_TO_PHYSICAL(currList->transform),
+                              G_MTX_MODELVIEW | G_MTX_LOAD | G_MTX_NOPUSH);
+                    gGeoCullStats.stateChangesSorted++;
+                }
+                gSPDisplayList(gDisplayListHead++, currList->displayList);
+                lastTransform = currList->transform;
+                lastSortable = currList->sortable;
+            }
+        }
+    }
+#else
     for (i = 0; i < GFX_NUM_MASTER_LISTS; i++) {
         if ((currList = node->listHeads[i]) != NULL) {
             gDPSetRenderMode(gDisplayListHead++, modeList->modes[i], mode2List->modes[i]);
@@ -163,6 +535,7 @@ static void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
             }
         }
     }
+#endif
     if (enableZBuffer != 0) {
         gDPPipeSync(gDisplayListHead++);
         gSPClearGeometryMode(gDisplayListHead++, G_ZBUFFER);
@@ -175,8 +548,13 @@ static void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
  * render modes of layers.
  */
 static void geo_append_display_list(void *displayList, s16 layer) {
+#ifndef TARGET_N64
+    if (sGeoLogicOnly) {
+        return;
+    }
+#endif
 
-#ifdef F3DEX_GBI_2
+#if defined(F3DEX_GBI_2) && defined(TARGET_N64)
     gSPLookAt(gDisplayListHead++, &lookAt);
 #endif
     if (gCurGraphNodeMasterList != 0) {
@@ -186,6 +564,19 @@ static void geo_append_display_list(void *displayList, s16 layer) {
         listNode->transform = gMatStackFixed[gMatStackIndex];
         listNode->displayList = displayList;
         listNode->next = 0;
+#ifndef TARGET_N64
+        listNode->owner = gCurGraphNodeObject;
+        listNode->sortable = sGeoAppendNode != NULL && gCurGraphNodeObject == NULL;
+        listNode->depth = -gMatStack[gMatStackIndex][3][2];
+        if (sGeoAppendNode != NULL && sGeoAppendNode->boundsRadius >= 0.0f) {
+            Mat4 *mtx = &gMatStack[gMatStackIndex];
+            Vec3f center;
+
+            vec3f_copy(center, sGeoAppendNode->boundsCenter);
+            listNode->depth = -(center[0] * (*mtx)[0][2] + center[1] * (*mtx)[1][2]
+                                + center[2] * (*mtx)[2][2] + (*mtx)[3][2]);
+        }
+#endif
         if (gCurGraphNodeMasterList->listHeads[layer] == 0) {
             gCurGraphNodeMasterList->listHeads[layer] = listNode;
         } else {
@@ -249,6 +640,13 @@ static void geo_process_perspective(struct GraphNodePerspective *node) {
 #endif
 
         guPerspective(mtx, &perspNorm, node->fov, aspect, node->near, node->far, 1.0f);
+#ifndef TARGET_N64
+#ifdef WIDESCREEN
+        geo_update_frustum(node->fov, GFX_DIMENSIONS_ASPECT_RATIO, node->near, node->far);
+#else
+        geo_update_frustum(node->fov, aspect, node->near, node->far);
+#endif
+#endif
         gSPPerspNormalize(gDisplayListHead++, perspNorm);
 
         gSPMatrix(gDisplayListHead++, VIRTUAL_TO_PHYSICAL(mtx), G_MTX_PROJECTION | G_MTX_LOAD | G_MTX_NOPUSH);
@@ -277,8 +675,11 @@ static void geo_process_level_of_detail(struct GraphNodeLevelOfDetail *node) {
 #endif
 
 #ifndef TARGET_N64
-    // We assume modern hardware is powerful enough to draw the most detailed variant
-    distanceFromCam = 0;
+    // Modern hardware is powerful enough to draw the most detailed variant,
+    // so distance based LOD is only used if enabled in the config
+    if (!configLevelOfDetail) {
+        distanceFromCam = 0;
+    }
 #endif
 
     if (node->minDistance <= distanceFromCam && distanceFromCam < node->maxDistance) {
@@ -331,7 +732,15 @@ static void geo_process_camera(struct GraphNodeCamera *node) {
     if (node->fnNode.node.children != 0) {
         gCurGraphNodeCamera = node;
         node->matrixPtr = &gMatStack[gMatStackIndex];
+#ifndef TARGET_N64
+        if (configGeoCompile && node->compiledCmds != NULL) {
+            geo_process_compiled(node->compiledCmds, node->numCompiledCmds);
+        } else {
+            geo_process_node_and_siblings(node->fnNode.node.children);
+        }
+#else
         geo_process_node_and_siblings(node->fnNode.node.children);
+#endif
         gCurGraphNodeCamera = NULL;
     }
     gMatStackIndex--;
@@ -473,9 +882,14 @@ static void geo_process_billboard(struct GraphNodeBillboard *node) {
  * parent node. It processes its children if it has them.
  */
 static void geo_process_display_list(struct GraphNodeDisplayList *node) {
+#ifndef TARGET_N64
+    // Children are still processed, since they may have their own transformations
+    geo_cull_display_list(node);
+#else
     if (node->displayList != NULL) {
         geo_append_display_list(node->displayList, node->node.flags >> 8);
     }
+#endif
     if (node->node.children != NULL) {
         geo_process_node_and_siblings(node->node.children);
     }
@@ -507,6 +921,15 @@ static void geo_process_generated_list(struct GraphNodeGenerated *node) {
 static void geo_process_background(struct GraphNodeBackground *node) {
     Gfx *list = NULL;
 
+#ifndef TARGET_N64
+    if (sGeoLogicOnly) {
+        if (node->fnNode.node.children != NULL) {
+            geo_process_node_and_siblings(node->fnNode.node.children);
+        }
+        return;
+    }
+#endif
+
     if (node->fnNode.func != NULL) {
         list = node->fnNode.func(GEO_CONTEXT_RENDER, &node->fnNode.node,
                                  (struct AllocOnlyPool *) gMatStack[gMatStackIndex]);
@@ -537,6 +960,64 @@ static void geo_process_background(struct GraphNodeBackground *node) {
     }
 }
 
+#ifndef TARGET_N64
+/**
+ * Rotations of animated parts. A part's rotation only depends on where its
+ * values are read from and the frame, so objects of the same kind playing the
+ * same animation at the same frame (and Mario's reflection) share them. Entries
+ * only last for the frame they were made in, since Mario's animations are all
+ * loaded into the same buffer.
+ */
+#define ANIM_CACHE_SIZE 512
+#define ANIM_CACHE_PROBES 4
+
+struct AnimCacheEntry {
+    u16 *attribute;
+    s16 *data;
+    s16 frame;
+    u32 stamp;
+    Mat4 matrix; // the translation is each part's own
+};
+
+static struct AnimCacheEntry sAnimCache[ANIM_CACHE_SIZE];
+static u32 sAnimCacheStamp = 0;
+
+/**
+ * Return the cache entry for the rotation the current part is about to read,
+ * which is valid if its stamp is the current one, or NULL if it can't be cached.
+ */
+static struct AnimCacheEntry *geo_anim_cache_lookup(void) {
+    struct AnimCacheEntry *victim = NULL;
+    u32 hash;
+    s32 i;
+
+    if (!configAnimCache) {
+        return NULL;
+    }
+
+    hash = (uintptr_t) gCurrAnimAttribute / sizeof(u16) * 31 + (u16) gCurrAnimFrame;
+    for (i = 0; i < ANIM_CACHE_PROBES; i++) {
+        struct AnimCacheEntry *probe = &sAnimCache[(hash + i) % ANIM_CACHE_SIZE];
+        if (probe->stamp == sAnimCacheStamp && probe->attribute == gCurrAnimAttribute
+            && probe->data == gCurAnimData && probe->frame == gCurrAnimFrame) {
+            return probe;
+        }
+        if (victim == NULL && probe->stamp != sAnimCacheStamp) {
+            victim = probe;
+        }
+    }
+
+    if (victim == NULL) {
+        victim = &sAnimCache[hash % ANIM_CACHE_SIZE];
+    }
+    victim->attribute = gCurrAnimAttribute;
+    victim->data = gCurAnimData;
+    victim->frame = gCurrAnimFrame;
+    victim->stamp = 0;
+    return victim;
+}
+#endif
+
 /**
  * Render an animated part. The current animation state is not part of the node
  * but set in global variables. If an animated part is skipped, everything afterwards desyncs.
@@ -546,6 +1027,9 @@ static void geo_process_animated_part(struct GraphNodeAnimatedPart *node) {
     Vec3s rotation;
     Vec3f translation;
     Mtx *matrixPtr = alloc_display_list(sizeof(*matrixPtr));
+#ifndef TARGET_N64
+    struct AnimCacheEntry *entry = NULL;
+#endif
 
     vec3s_copy(rotation, gVec3sZero);
     vec3f_set(translation, node->translation[0], node->translation[1], node->translation[2]);
@@ -582,12 +1066,31 @@ static void geo_process_animated_part(struct GraphNodeAnimatedPart *node) {
         }
     }
 
+#ifndef TARGET_N64
+    if (gCurAnimType == ANIM_TYPE_ROTATION) {
+        entry = geo_anim_cache_lookup();
+    }
+    if (entry != NULL && entry->stamp == sAnimCacheStamp) {
+        // Skip the three values the rotation would have been read from
+        gCurrAnimAttribute += 6;
+        mtxf_copy(matrix, entry->matrix);
+        vec3f_copy(matrix[3], translation);
+        gGeoCullStats.animPartsCached++;
+    } else {
+#endif
     if (gCurAnimType == ANIM_TYPE_ROTATION) {
         rotation[0] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
         rotation[1] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
         rotation[2] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
     }
     mtxf_rotate_xyz_and_translate(matrix, translation, rotation);
+#ifndef TARGET_N64
+        if (entry != NULL) {
+            mtxf_copy(entry->matrix, matrix);
+            entry->stamp = sAnimCacheStamp;
+        }
+    }
+#endif
     mtxf_mul(gMatStack[gMatStackIndex + 1], matrix, gMatStack[gMatStackIndex]);
     gMatStackIndex++;
     mtxf_to_mtx(matrixPtr, gMatStack[gMatStackIndex]);
@@ -651,6 +1154,15 @@ static void geo_process_shadow(struct GraphNodeShadow *node) {
     struct GraphNode *geo;
     Mtx *mtx;
 
+#ifndef TARGET_N64
+    if (sGeoLogicOnly) {
+        if (node->node.children != NULL) {
+            geo_process_node_and_siblings(node->node.children);
+        }
+        return;
+    }
+#endif
+
     if (gCurGraphNodeCamera != NULL && gCurGraphNodeObject != NULL) {
         if (gCurGraphNodeHeldObject != NULL) {
             get_pos_from_transform_mtx(shadowPos, gMatStack[gMatStackIndex],
@@ -742,6 +1254,9 @@ static void geo_process_shadow(struct GraphNodeShadow *node) {
  *        C       x+
  *
  * Since (0,0,0) is unaffected by rotation, columns 0, 1 and 2 are ignored.
+ *
+ * On PC, the horizontal check is replaced by a test against all side planes of
+ * the frustum (see geo_sphere_in_frustum) unless frustum culling is disabled.
  */
 static int obj_is_in_view(struct GraphNodeObject *node, Mat4 matrix) {
     s16 cullingRadius;
@@ -791,6 +1306,15 @@ static int obj_is_in_view(struct GraphNodeObject *node, Mat4 matrix) {
         return FALSE;
     }
 
+#ifndef TARGET_N64
+    // Check the left and right planes of the frustum, taking the aspect ratio
+    // into account. Like the check below, this leaves out the top and bottom:
+    // an object above the screen still has to process its shadow and the HOLP.
+    if (configFrustumCulling) {
+        return geo_sphere_in_side_planes(matrix[3], cullingRadius);
+    }
+#endif
+
     // Check whether the object is horizontally in view
     if (matrix[3][0] > hScreenEdge + cullingRadius) {
         return FALSE;
@@ -834,6 +1358,10 @@ static void geo_process_object(struct Object *node) {
         if (obj_is_in_view(&node->header.gfx, gMatStack[gMatStackIndex])) {
             Mtx *mtx = alloc_display_list(sizeof(*mtx));
 
+#ifndef TARGET_N64
+            gGeoCullStats.objectsDrawn++;
+#endif
+
             mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
             gMatStackFixed[gMatStackIndex] = mtx;
             if (node->header.gfx.sharedChild != NULL) {
@@ -847,6 +1375,11 @@ static void geo_process_object(struct Object *node) {
                 geo_process_node_and_siblings(node->header.gfx.node.children);
             }
         }
+#ifndef TARGET_N64
+        else {
+            gGeoCullStats.objectsCulled++;
+        }
+#endif
 
         gMatStackIndex--;
         gCurAnimType = ANIM_TYPE_NONE;
@@ -944,6 +1477,85 @@ void geo_try_process_children(struct GraphNode *node) {
     }
 }
 
+/**
+ * Process a single geo node by calling the function for its type.
+ */
+static void geo_process_node(struct GraphNode *curGraphNode) {
+    if (curGraphNode->flags & GRAPH_RENDER_ACTIVE) {
+        if (curGraphNode->flags & GRAPH_RENDER_CHILDREN_FIRST) {
+            geo_try_process_children(curGraphNode);
+        } else {
+            switch (curGraphNode->type) {
+                case GRAPH_NODE_TYPE_ORTHO_PROJECTION:
+                    geo_process_ortho_projection((struct GraphNodeOrthoProjection *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_PERSPECTIVE:
+                    geo_process_perspective((struct GraphNodePerspective *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_MASTER_LIST:
+                    geo_process_master_list((struct GraphNodeMasterList *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_LEVEL_OF_DETAIL:
+                    geo_process_level_of_detail((struct GraphNodeLevelOfDetail *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_SWITCH_CASE:
+                    geo_process_switch((struct GraphNodeSwitchCase *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_CAMERA:
+                    geo_process_camera((struct GraphNodeCamera *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_TRANSLATION_ROTATION:
+                    geo_process_translation_rotation(
+                        (struct GraphNodeTranslationRotation *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_TRANSLATION:
+                    geo_process_translation((struct GraphNodeTranslation *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_ROTATION:
+                    geo_process_rotation((struct GraphNodeRotation *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_OBJECT:
+                    geo_process_object((struct Object *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_ANIMATED_PART:
+                    geo_process_animated_part((struct GraphNodeAnimatedPart *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_BILLBOARD:
+                    geo_process_billboard((struct GraphNodeBillboard *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_DISPLAY_LIST:
+                    geo_process_display_list((struct GraphNodeDisplayList *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_SCALE:
+                    geo_process_scale((struct GraphNodeScale *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_SHADOW:
+                    geo_process_shadow((struct GraphNodeShadow *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_OBJECT_PARENT:
+                    geo_process_object_parent((struct GraphNodeObjectParent *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_GENERATED_LIST:
+                    geo_process_generated_list((struct GraphNodeGenerated *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_BACKGROUND:
+                    geo_process_background((struct GraphNodeBackground *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_HELD_OBJ:
+                    geo_process_held_object((struct GraphNodeHeldObject *) curGraphNode);
+                    break;
+                default:
+                    geo_try_process_children((struct GraphNode *) curGraphNode);
+                    break;
+            }
+        }
+    } else {
+        if (curGraphNode->type == GRAPH_NODE_TYPE_OBJECT) {
+            ((struct GraphNodeObject *) curGraphNode)->throwMatrix = NULL;
+        }
+    }
+}
+
 /**
  * Process a generic geo node and its siblings.
  * The first argument is the start node, and all its siblings will
@@ -961,81 +1573,190 @@ void geo_process_node_and_siblings(struct GraphNode *firstNode) {
     }
 
     do {
-        if (curGraphNode->flags & GRAPH_RENDER_ACTIVE) {
-            if (curGraphNode->flags & GRAPH_RENDER_CHILDREN_FIRST) {
-                geo_try_process_children(curGraphNode);
-            } else {
-                switch (curGraphNode->type) {
-                    case GRAPH_NODE_TYPE_ORTHO_PROJECTION:
-                        geo_process_ortho_projection((struct GraphNodeOrthoProjection *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_PERSPECTIVE:
-                        geo_process_perspective((struct GraphNodePerspective *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_MASTER_LIST:
-                        geo_process_master_list((struct GraphNodeMasterList *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_LEVEL_OF_DETAIL:
-                        geo_process_level_of_detail((struct GraphNodeLevelOfDetail *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_SWITCH_CASE:
-                        geo_process_switch((struct GraphNodeSwitchCase *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_CAMERA:
-                        geo_process_camera((struct GraphNodeCamera *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_TRANSLATION_ROTATION:
-                        geo_process_translation_rotation(
-                            (struct GraphNodeTranslationRotation *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_TRANSLATION:
-                        geo_process_translation((struct GraphNodeTranslation *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_ROTATION:
-                        geo_process_rotation((struct GraphNodeRotation *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_OBJECT:
-                        geo_process_object((struct Object *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_ANIMATED_PART:
-                        geo_process_animated_part((struct GraphNodeAnimatedPart *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_BILLBOARD:
-                        geo_process_billboard((struct GraphNodeBillboard *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_DISPLAY_LIST:
-                        geo_process_display_list((struct GraphNodeDisplayList *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_SCALE:
-                        geo_process_scale((struct GraphNodeScale *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_SHADOW:
-                        geo_process_shadow((struct GraphNodeShadow *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_OBJECT_PARENT:
-                        geo_process_object_parent((struct GraphNodeObjectParent *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_GENERATED_LIST:
-                        geo_process_generated_list((struct GraphNodeGenerated *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_BACKGROUND:
-                        geo_process_background((struct GraphNodeBackground *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_HELD_OBJ:
-                        geo_process_held_object((struct GraphNodeHeldObject *) curGraphNode);
-                        break;
-                    default:
-                        geo_try_process_children((struct GraphNode *) curGraphNode);
-                        break;
-                }
-            }
+        geo_process_node(curGraphNode);
+    } while (iterateChildren && (curGraphNode = curGraphNode->next) != firstNode);
+}
+
+#ifndef TARGET_N64
+/**
+ * Push the transformation of a compiled matrix or scale node on both matrix
+ * stacks, the same way geo_process_translation and friends do.
+ */
+static void geo_push_compiled_matrix(struct GeoCompiledCmd *cmd) {
+    struct GraphNodeScale *scaleNode = (struct GraphNodeScale *) cmd->node;
+    Mtx *mtx = alloc_display_list(sizeof(*mtx));
+    Vec3f scaleVec;
+
+    if (cmd->op == GEO_CMD_SCALE) {
+        vec3f_set(scaleVec, scaleNode->scale, scaleNode->scale, scaleNode->scale);
+        mtxf_scale_vec3f(gMatStack[gMatStackIndex + 1], gMatStack[gMatStackIndex], scaleVec);
+    } else {
+        mtxf_mul(gMatStack[gMatStackIndex + 1], *cmd->transform, gMatStack[gMatStackIndex]);
+    }
+    gMatStackIndex++;
+    mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
+    gMatStackFixed[gMatStackIndex] = mtx;
+
+    // Translation, rotation and scale nodes all keep their display list right after the node
+    if (scaleNode->displayList != NULL) {
+        geo_append_display_list(scaleNode->displayList, scaleNode->node.flags >> 8);
+    }
+}
+
+/**
+ * Run a command stream built by geo_compile_area. Static nodes are handled
+ * in place, dynamic ones are handed to geo_process_node as usual. The active
+ * flag is still checked every frame, an inactive node skips its subtree.
+ */
+static void geo_process_compiled(struct GeoCompiledCmd *cmds, s32 count) {
+    struct GeoCompiledCmd *cmd;
+    s32 i = 0;
+
+    while (i < count) {
+        cmd = &cmds[i];
+        if (cmd->op == GEO_CMD_POP) {
+            gMatStackIndex--;
+        } else if (cmd->op == GEO_CMD_DYNAMIC) {
+            geo_process_node(cmd->node);
+        } else if (!(cmd->node->flags & GRAPH_RENDER_ACTIVE)) {
+            i = cmd->end;
+            continue;
+        } else if (cmd->op == GEO_CMD_DISPLAY_LIST) {
+            geo_cull_display_list((struct GraphNodeDisplayList *) cmd->node);
+        } else if (cmd->op != GEO_CMD_GROUP) {
+            geo_push_compiled_matrix(cmd);
+        }
+        i++;
+    }
+}
+
+/**
+ * Flatten a node and its subtree into cmds starting at index pos, or only count
+ * the commands if cmds is NULL. Returns the index after the subtree.
+ */
+static s32 geo_compile_node(struct GeoCompiledCmd *cmds, s32 pos, struct GraphNode *node,
+                            struct AllocOnlyPool *pool) {
+    struct GeoCompiledCmd *cmd = cmds != NULL ? &cmds[pos] : NULL;
+    struct GraphNode *child;
+    Vec3f translation;
+    s32 op;
+
+    if (node->flags & GRAPH_RENDER_CHILDREN_FIRST) {
+        op = GEO_CMD_GROUP;
+    } else {
+        switch (node->type) {
+            case GRAPH_NODE_TYPE_START:
+            case GRAPH_NODE_TYPE_CULLING_RADIUS:
+                op = GEO_CMD_GROUP;
+                break;
+            case GRAPH_NODE_TYPE_DISPLAY_LIST:
+                op = GEO_CMD_DISPLAY_LIST;
+                break;
+            case GRAPH_NODE_TYPE_TRANSLATION_ROTATION:
+            case GRAPH_NODE_TYPE_TRANSLATION:
+            case GRAPH_NODE_TYPE_ROTATION:
+                op = GEO_CMD_MATRIX;
+                break;
+            case GRAPH_NODE_TYPE_SCALE:
+                op = GEO_CMD_SCALE;
+                break;
+            default:
+                op = GEO_CMD_DYNAMIC;
+                break;
+        }
+    }
+
+    if (cmd != NULL) {
+        cmd->node = node;
+        cmd->transform = NULL;
+        cmd->op = op;
+    }
+    if (cmd != NULL && op == GEO_CMD_MATRIX) {
+        if ((cmd->transform = alloc_only_pool_alloc(pool, sizeof(Mat4))) == NULL) {
+            return -1;
+        }
+        if (node->type == GRAPH_NODE_TYPE_ROTATION) {
+            mtxf_rotate_zxy_and_translate(*cmd->transform, gVec3fZero,
+                                          ((struct GraphNodeRotation *) node)->rotation);
+        } else if (node->type == GRAPH_NODE_TYPE_TRANSLATION) {
+            vec3s_to_vec3f(translation, ((struct GraphNodeTranslation *) node)->translation);
+            mtxf_rotate_zxy_and_translate(*cmd->transform, translation, gVec3sZero);
         } else {
-            if (curGraphNode->type == GRAPH_NODE_TYPE_OBJECT) {
-                ((struct GraphNodeObject *) curGraphNode)->throwMatrix = NULL;
+            vec3s_to_vec3f(translation, ((struct GraphNodeTranslationRotation *) node)->translation);
+            mtxf_rotate_zxy_and_translate(*cmd->transform, translation,
+                                          ((struct GraphNodeTranslationRotation *) node)->rotation);
+        }
+    }
+    pos++;
+
+    if (op != GEO_CMD_DYNAMIC && (child = node->children) != NULL) {
+        do {
+            if ((pos = geo_compile_node(cmds, pos, child, pool)) < 0) {
+                return -1;
             }
+        } while ((child = child->next) != node->children);
+    }
+    if (op == GEO_CMD_MATRIX || op == GEO_CMD_SCALE) {
+        if (cmds != NULL) {
+            cmds[pos].node = node;
+            cmds[pos].transform = NULL;
+            cmds[pos].op = GEO_CMD_POP;
+            cmds[pos].end = pos + 1;
         }
-    } while (iterateChildren && (curGraphNode = curGraphNode->next) != firstNode);
+        pos++;
+    }
+    if (cmd != NULL) {
+        cmd->end = pos;
+    }
+    return pos;
+}
+
+/**
+ * Flatten the static part of the subtree below every camera of an area into a
+ * linear command stream, allocated from pool. Level geometry under the camera
+ * (display lists and translation, rotation and scale nodes) produces the same
+ * sequence every frame, so it can be run without recursion or a switch on the
+ * node type, and with the local matrices computed once. Everything else
+ * (objects, switch cases, level of detail, generated lists, ...) stays a
+ * single command that processes its subtree recursively.
+ * This assumes the transformations of static nodes are not changed at runtime.
+ */
+void geo_compile_area(struct GraphNode *node, struct AllocOnlyPool *pool) {
+    struct GraphNodeCamera *camera;
+    struct GeoCompiledCmd *cmds;
+    struct GraphNode *child;
+    s32 count;
+    s32 pos;
+
+    if (node->type == GRAPH_NODE_TYPE_CAMERA && node->children != NULL) {
+        camera = (struct GraphNodeCamera *) node;
+        count = 0;
+        child = node->children;
+        do {
+            count = geo_compile_node(NULL, count, child, pool);
+        } while ((child = child->next) != node->children);
+
+        cmds = alloc_only_pool_alloc(pool, count * sizeof(struct GeoCompiledCmd));
+        pos = 0;
+        if (cmds != NULL) {
+            do {
+                pos = geo_compile_node(cmds, pos, child, pool);
+            } while (pos >= 0 && (child = child->next) != node->children);
+        }
+        // If the pool ran out, the camera keeps processing its children recursively
+        if (cmds != NULL && pos >= 0) {
+            camera->compiledCmds = cmds;
+            camera->numCompiledCmds = count;
+        }
+    }
+
+    if (node->type != GRAPH_NODE_TYPE_CAMERA && (child = node->children) != NULL) {
+        do {
+            geo_compile_area(child, pool);
+        } while ((child = child->next) != node->children);
+    }
 }
+#endif
 
 /**
  * Process a root node. This is the entry point for processing the scene graph.
@@ -1047,13 +1768,27 @@ void geo_process_root(struct GraphNodeRoot *node, Vp *b, Vp *c, s32 clearColor)
 
     if (node->node.flags & GRAPH_RENDER_ACTIVE) {
         Mtx *initialMatrix;
-        Vp *viewport = alloc_display_list(sizeof(*viewport));
+        Vp *viewport;
+
+#ifndef TARGET_N64
+        BENCHMARK_BEGIN(BENCHMARK_GEO);
+        PROFILER_ZONE_BEGIN(ZONE_GEO);
+#endif
+        viewport = alloc_display_list(sizeof(*viewport));
 
         gDisplayListHeap = alloc_only_pool_init(main_pool_available() - sizeof(struct AllocOnlyPool),
                                                 MEMORY_POOL_LEFT);
         initialMatrix = alloc_display_list(sizeof(*initialMatrix));
         gMatStackIndex = 0;
         gCurAnimType = 0;
+#ifndef TARGET_N64
+        sGeoLogicOnly = gfx_frame_dropped();
+        bzero(&gGeoCullStats, sizeof(gGeoCullStats));
+        // 0 is never current, so new entries stay invalid until filled
+        if (++sAnimCacheStamp == 0) {
+            sAnimCacheStamp = 1;
+        }
+#endif
         vec3s_set(viewport->vp.vtrans, node->x * 4, node->y * 4, 511);
         vec3s_set(viewport->vp.vscale, node->width * 4, node->height * 4, 511);
         if (b != NULL) {
@@ -1082,6 +1817,31 @@ void geo_process_root(struct GraphNodeRoot *node, Vp *b, Vp *c, s32 clearColor)
             print_text_fmt_int(180, 36, "MEM %d",
                                gDisplayListHeap->totalSpace - gDisplayListHeap->usedSpace);
         }
+#ifndef TARGET_N64
+        sGeoLogicOnly = FALSE;
+        if (configShowStats) {
+            print_text_fmt_int(22, 180, "STATE %d", gGeoCullStats.stateChanges);
+            print_text_fmt_int(22, 196, "STATE SORT %d", gGeoCullStats.stateChangesSorted);
+#ifdef TARGET_DOS
+            print_text_fmt_int(22, 212, "VRAM KB %d", gfx_dos_vram_bytes / 1024);
+#endif
+            print_text_fmt_int(180, 180, "TEX UP %d", gfx_frame_stats.uploads);
+            print_text_fmt_int(180, 164, "TEX KB %d", gfx_frame_stats.resident_bytes / 1024);
+            print_text_fmt_int(180, 148, "PASS %d", gfx_frame_stats.passes);
+            print_text_fmt_int(180, 132, "ANIM HIT %d", gGeoCullStats.animPartsCached);
+            print_text_fmt_int(22, 116, "SHADOW HIT %d", gGeoCullStats.shadowsCached);
+            print_text_fmt_int(22, 100, "OBJ %d", gGeoCullStats.objectsDrawn);
+            print_text_fmt_int(22, 84, "OBJ CULL %d", gGeoCullStats.objectsCulled);
+            print_text_fmt_int(22, 68, "DL %d", gGeoCullStats.listsDrawn);
+            print_text_fmt_int(22, 52, "DL CULL %d", gGeoCullStats.listsCulled);
+            print_text_fmt_int(22, 36, "TRI %d", gGeoCullStats.trianglesDrawn);
+            print_text_fmt_int(22, 20, "TRI CULL %d", gGeoCullStats.trianglesCulled);
+        }
+#endif
         main_pool_free(gDisplayListHeap);
+#ifndef TARGET_N64
+        PROFILER_ZONE_END(ZONE_GEO);
+        BENCHMARK_END(BENCHMARK_GEO);
+#endif
     }
 }
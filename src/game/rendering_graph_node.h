@@ -13,6 +13,24 @@ extern struct GraphNodeObject *gCurGraphNodeObject;
 extern struct GraphNodeHeldObject *gCurGraphNodeHeldObject;
 extern u16 gAreaUpdateCounter;
 
+#ifndef TARGET_N64
+// Frustum culling counters for the last processed frame
+struct GeoCullStats {
+    s32 objectsDrawn;
+    s32 objectsCulled;
+    s32 listsDrawn;
+    s32 listsCulled;
+    s32 trianglesDrawn;
+    s32 trianglesCulled;
+    s32 shadowsCached;
+    s32 animPartsCached;
+    s32 stateChanges; // matrix, render mode and texture changes in the order lists were added
+    s32 stateChangesSorted; // the same after sorting and dropping redundant matrix loads
+};
+
+extern struct GeoCullStats gGeoCullStats;
+#endif
+
 // after processing an object, the type is reset to this
 #define ANIM_TYPE_NONE                  0
 
@@ -29,5 +47,8 @@ extern u16 gAreaUpdateCounter;
 
 void geo_process_node_and_siblings(struct GraphNode *firstNode);
 void geo_process_root(struct GraphNodeRoot *node, Vp *b, Vp *c, s32 clearColor);
+#ifndef TARGET_N64
+void geo_compile_area(struct GraphNode *node, struct AllocOnlyPool *pool);
+#endif
 
 #endif // RENDERING_GRAPH_NODE_H
@@ -14,8 +14,89 @@
 #include "sm64.h"
 
 #ifndef TARGET_N64
+#include "game_init.h"
+#include "pc/configfile.h"
+
+static s8 sShadowOnDynamicFloor;
+static struct FloorGeometry sShadowFloorGeo;
+
+/**
+ * Same as find_floor_height_and_data, but remembers whether any of the floors
+ * a shadow was built from can move, which keeps it out of the shadow cache.
+ */
+static f32 find_shadow_floor_height_and_data(f32 xPos, f32 yPos, f32 zPos, struct FloorGeometry **floorGeo) {
+    struct Surface *floor;
+    f32 floorHeight = find_floor(xPos, yPos, zPos, &floor);
+
+    *floorGeo = NULL;
+
+    if (floor != NULL) {
+        if (floor->flags & SURFACE_FLAG_DYNAMIC) {
+            sShadowOnDynamicFloor = TRUE;
+        }
+        sShadowFloorGeo.normalX = floor->normal.x;
+        sShadowFloorGeo.normalY = floor->normal.y;
+        sShadowFloorGeo.normalZ = floor->normal.z;
+        sShadowFloorGeo.originOffset = floor->originOffset;
+
+        *floorGeo = &sShadowFloorGeo;
+    }
+    return floorHeight;
+}
+
 // Avoid Z-fighting
-#define find_floor_height_and_data 0.4 + find_floor_height_and_data
+#define find_floor_height_and_data 0.4 + find_shadow_floor_height_and_data
+
+/**
+ * Shadow meshes are kept per object and reused for as long as everything they
+ * were built from stays the same, since most shadowed objects (coins, enemies
+ * standing still) sit on static floors and rebuilding one takes a floor and
+ * water query per vertex. Entries used in the current frame are never evicted,
+ * as the display list may still reference them.
+ */
+#define SHADOW_CACHE_SIZE 128
+#define SHADOW_CACHE_PROBES 4
+
+struct ShadowCacheEntry {
+    struct GraphNodeObject *obj;
+    s8 shadowType;
+    s8 valid;
+    s8 aboveWaterOrLava;
+    u8 solidity;
+    s16 shadowScale;
+    s16 yaw;
+    s16 levelNum;
+    s16 areaIndex;
+    f32 pos[3];
+    f32 waterLevel;
+    struct Surface *floor;
+    u32 lastUse;
+    Gfx *displayList;
+    u32 bufferUsed;
+    u64 buffer[(9 * sizeof(Vtx) + 5 * sizeof(Gfx)) / sizeof(u64)];
+};
+
+static struct ShadowCacheEntry sShadowCache[SHADOW_CACHE_SIZE];
+static struct ShadowCacheEntry *sShadowCacheFill;
+
+/**
+ * While a cache entry is being filled, the shadow's vertices and display list
+ * go into it instead of the display list pool.
+ */
+static void *alloc_shadow_display_list(u32 size) {
+    struct ShadowCacheEntry *entry = sShadowCacheFill;
+    void *ptr;
+
+    if (entry == NULL || entry->bufferUsed + size > sizeof(entry->buffer)) {
+        return alloc_display_list(size);
+    }
+
+    ptr = (u8 *) entry->buffer + entry->bufferUsed;
+    entry->bufferUsed += (size + 7) & ~7;
+    return ptr;
+}
+
+#define alloc_display_list alloc_shadow_display_list
 #endif
 
 /**
@@ -796,6 +877,76 @@ Gfx *create_shadow_hardcoded_rectangle(f32 xPos, f32 yPos, f32 zPos, u8 solidity
     return create_shadow_rectangle(halfWidth, halfLength, -distFromShadow, solidity);
 }
 
+#ifndef TARGET_N64
+/**
+ * Return the cache entry for the current object's shadow, which is valid if
+ * the cached shadow can be drawn as-is, or NULL if it can't be cached.
+ */
+static struct ShadowCacheEntry *shadow_cache_lookup(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale,
+                                                    u8 shadowSolidity, s8 shadowType,
+                                                    struct Surface *floor) {
+    struct GraphNodeObject *obj = gCurGraphNodeObject;
+    struct ShadowCacheEntry *entry = NULL;
+    struct ShadowCacheEntry *victim = NULL;
+    u32 hash;
+    s32 i;
+
+    // Mario's shadow depends on his animation and is different every frame anyway
+    if (!configShadowCache || obj == NULL || shadowType == SHADOW_CIRCLE_PLAYER
+        || (floor != NULL && (floor->flags & SURFACE_FLAG_DYNAMIC))) {
+        return NULL;
+    }
+
+    hash = (uintptr_t) obj / sizeof(struct Object);
+    for (i = 0; i < SHADOW_CACHE_PROBES; i++) {
+        struct ShadowCacheEntry *probe = &sShadowCache[(hash + i) % SHADOW_CACHE_SIZE];
+        if (probe->obj == obj && probe->shadowType == shadowType) {
+            entry = probe;
+            break;
+        }
+        if (probe->lastUse != gGlobalTimer && (victim == NULL || probe->lastUse < victim->lastUse)) {
+            victim = probe;
+        }
+    }
+
+    if (entry == NULL) {
+        if (victim == NULL) {
+            return NULL;
+        }
+        entry = victim;
+        entry->obj = obj;
+        entry->shadowType = shadowType;
+        entry->valid = FALSE;
+    } else if (entry->lastUse == gGlobalTimer) {
+        // Drawn twice in a frame (e.g. held objects), the first display list is still in use
+        return NULL;
+    }
+
+    entry->lastUse = gGlobalTimer;
+    if (entry->valid && entry->pos[0] == xPos && entry->pos[1] == yPos && entry->pos[2] == zPos
+        && entry->shadowScale == shadowScale && entry->solidity == shadowSolidity
+        && entry->floor == floor && entry->yaw == ((struct Object *) obj)->oFaceAngleYaw
+        && entry->levelNum == gCurrLevelNum && entry->areaIndex == gCurrAreaIndex
+        && entry->waterLevel == find_water_level(xPos, zPos)) {
+        return entry;
+    }
+
+    entry->valid = FALSE;
+    entry->pos[0] = xPos;
+    entry->pos[1] = yPos;
+    entry->pos[2] = zPos;
+    entry->shadowScale = shadowScale;
+    entry->solidity = shadowSolidity;
+    entry->floor = floor;
+    entry->yaw = ((struct Object *) obj)->oFaceAngleYaw;
+    entry->levelNum = gCurrLevelNum;
+    entry->areaIndex = gCurrAreaIndex;
+    entry->waterLevel = find_water_level(xPos, zPos);
+    entry->bufferUsed = 0;
+    return entry;
+}
+#endif
+
 /**
  * Create a shadow at the absolute position given, with the given parameters.
  * Return a pointer to the display list representing the shadow.
@@ -804,6 +955,9 @@ Gfx *create_shadow_below_xyz(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale, u8 s
                              s8 shadowType) {
     Gfx *displayList = NULL;
     struct Surface *pfloor;
+#ifndef TARGET_N64
+    struct ShadowCacheEntry *entry;
+#endif
     find_floor(xPos, yPos, zPos, &pfloor);
 
     gShadowAboveWaterOrLava = FALSE;
@@ -815,6 +969,16 @@ Gfx *create_shadow_below_xyz(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale, u8 s
         }
         sSurfaceTypeBelowShadow = pfloor->type;
     }
+#ifndef TARGET_N64
+    entry = shadow_cache_lookup(xPos, yPos, zPos, shadowScale, shadowSolidity, shadowType, pfloor);
+    if (entry != NULL && entry->valid) {
+        gShadowAboveWaterOrLava = entry->aboveWaterOrLava;
+        gGeoCullStats.shadowsCached++;
+        return entry->displayList;
+    }
+    sShadowCacheFill = entry;
+    sShadowOnDynamicFloor = FALSE;
+#endif
     switch (shadowType) {
         case SHADOW_CIRCLE_9_VERTS:
             displayList = create_shadow_circle_9_verts(xPos, yPos, zPos, shadowScale, shadowSolidity);
@@ -841,5 +1005,13 @@ Gfx *create_shadow_below_xyz(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale, u8 s
             displayList = create_shadow_hardcoded_rectangle(xPos, yPos, zPos, shadowSolidity, shadowType);
             break;
     }
+#ifndef TARGET_N64
+    if (entry != NULL) {
+        sShadowCacheFill = NULL;
+        entry->valid = !sShadowOnDynamicFloor;
+        entry->aboveWaterOrLava = gShadowAboveWaterOrLava;
+        entry->displayList = displayList;
+    }
+#endif
     return displayList;
 }
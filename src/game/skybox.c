@@ -15,6 +15,11 @@
 # if !defined(TARGET_DOS) && !defined(ENABLE_SOFTRAST)
 #  define BETTER_SKYBOX_POSITION_PRECISION
 # endif
+# if (defined(TARGET_DOS) || defined(ENABLE_SOFTRAST) || defined(ENABLE_OPENGL_LEGACY)) && !defined(WIDESCREEN)
+// Draw the tiles as screen space texture rectangles, which these renderers blit without any transform
+// or depth test, instead of projecting 9 quads through the ortho matrix
+#  define SKYBOX_SCREEN_SPACE
+# endif
 #endif
 
 /**
@@ -273,6 +278,57 @@ void draw_skybox_tile_grid(Gfx **dlist, s8 background, s8 player, s8 colorIndex)
     }
 }
 
+#ifdef SKYBOX_SCREEN_SPACE
+/**
+ * Texture rectangle steps matching the quads from make_skybox_rect, which map 31 texels across a tile.
+ * s and t are S10.5, dsdx and dtdy are S5.10 and screen coordinates are U10.2.
+ */
+#define G_CC_SKYBOX_MASK TEXEL0, 0, ENVIRONMENT, 0, 0, 0, 0, ENVIRONMENT
+
+#define SKYBOX_RECT_DSDX (31 * 1024 / SKYBOX_TILE_WIDTH)
+#define SKYBOX_RECT_DTDY (31 * 1024 / SKYBOX_TILE_HEIGHT)
+
+/**
+ * Draws the same 3x3 grid as draw_skybox_tile_grid, but as texture rectangles scrolled by the skybox's
+ * position and clipped to the screen.
+ */
+void draw_skybox_tile_rects(Gfx **dlist, s8 background, s8 player) {
+    s32 row;
+    s32 col;
+
+    for (row = 0; row < 3; row++) {
+        for (col = 0; col < 3; col++) {
+            s32 tileIndex = sSkyBoxInfo[player].upperLeftTile + row * SKYBOX_COLS + col;
+            s32 ulx = (s32) ((tileIndex % SKYBOX_COLS * SKYBOX_TILE_WIDTH - sSkyBoxInfo[player].scaledX) * 4);
+            s32 uly = (s32) ((sSkyBoxInfo[player].scaledY - SKYBOX_HEIGHT
+                              + tileIndex / SKYBOX_COLS * SKYBOX_TILE_HEIGHT) * 4);
+            s32 lrx = MIN(ulx + SKYBOX_TILE_WIDTH * 4, SCREEN_WIDTH * 4);
+            s32 lry = MIN(uly + SKYBOX_TILE_HEIGHT * 4, SCREEN_HEIGHT * 4);
+            s32 s = 0;
+            s32 t = 0;
+            const u8 *texture;
+
+            if (ulx < 0) {
+                s = -ulx * SKYBOX_RECT_DSDX >> 7;
+                ulx = 0;
+            }
+            if (uly < 0) {
+                t = -uly * SKYBOX_RECT_DTDY >> 7;
+                uly = 0;
+            }
+            if (ulx >= lrx || uly >= lry) {
+                continue;
+            }
+
+            texture = (*(SkyboxTexture *) segmented_to_virtual(sSkyboxTextures[background]))[tileIndex];
+            gLoadBlockTexture((*dlist)++, 32, 32, G_IM_FMT_RGBA, texture);
+            gSPTextureRectangle((*dlist)++, ulx, uly, lrx, lry, G_TX_RENDERTILE, s, t,
+                                SKYBOX_RECT_DSDX, SKYBOX_RECT_DTDY);
+        }
+    }
+}
+#endif
+
 void *create_skybox_ortho_matrix(s8 player) {
     f32 left = sSkyBoxInfo[player].scaledX;
     f32 right = sSkyBoxInfo[player].scaledX + SCREEN_WIDTH;
@@ -302,13 +358,35 @@ void *create_skybox_ortho_matrix(s8 player) {
  * Creates the skybox's display list, then draws the 3x3 grid of tiles.
  */
 Gfx *init_skybox_display_list(s8 player, s8 background, s8 colorIndex) {
+#ifdef SKYBOX_SCREEN_SPACE
+    s32 dlCommandCount = 7 + (3 * 3) * 8; // 7 for the start, end and colors, plus 9 skybox tiles
+#else
     s32 dlCommandCount = 5 + (3 * 3) * 7; // 5 for the start and end, plus 9 skybox tiles
+#endif
     void *skybox = alloc_display_list(dlCommandCount * sizeof(Gfx));
     Gfx *dlist = skybox;
 
     if (!configDrawSky || skybox == NULL) {
         return NULL;
     } else {
+#ifdef SKYBOX_SCREEN_SPACE
+        gSPDisplayList(dlist++, dl_skybox_begin);
+        gSPDisplayList(dlist++, dl_skybox_tile_tex_settings);
+        // Texture rectangles have no shade, so the color mask goes through the environment color
+        if (colorIndex == 1) {
+            gDPSetCombineMode(dlist++, G_CC_DECALRGBA, G_CC_DECALRGBA);
+        } else {
+            gDPSetCombineMode(dlist++, G_CC_SKYBOX_MASK, G_CC_SKYBOX_MASK);
+            gDPSetEnvColor(dlist++, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
+                           sSkyboxColors[colorIndex][2], 255);
+        }
+        draw_skybox_tile_rects(&dlist, background, player);
+        if (colorIndex != 1) {
+            gDPSetEnvColor(dlist++, 255, 255, 255, 255);
+        }
+        gSPDisplayList(dlist++, dl_skybox_end);
+        gSPEndDisplayList(dlist);
+#else
         Mtx *ortho = create_skybox_ortho_matrix(player);
 
         gSPDisplayList(dlist++, dl_skybox_begin);
@@ -317,6 +395,7 @@ Gfx *init_skybox_display_list(s8 player, s8 background, s8 colorIndex) {
         draw_skybox_tile_grid(&dlist, background, player, colorIndex);
         gSPDisplayList(dlist++, dl_skybox_end);
         gSPEndDisplayList(dlist);
+#endif
     }
     return skybox;
 }
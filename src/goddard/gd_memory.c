@@ -14,10 +14,46 @@
  * block lists.
  */
 
+#ifndef TARGET_N64
+#define GD_POOL_GRANULE 8
+#define GD_POOL_MAX_SIZE 256
+#define GD_POOL_CLASSES (GD_POOL_MAX_SIZE / GD_POOL_GRANULE)
+#define GD_POOL_SLAB_SIZE 0x1000
+#define GD_MAX_POOL_SLABS 1024
+#define GD_POOL_MAP_SIZE (GD_MAX_POOL_SLABS * 2)
+#define GD_POOL_PAGE(addr) ((uintptr_t)(addr) / GD_POOL_SLAB_SIZE)
+#define GD_TEMP_ARENA_SIZE DOUBLE_SIZE_ON_64_BIT(0x14000)
+
+/// A heap block holding equally sized slots of one pool size class.
+struct GdPoolSlab {
+    u8 *start;
+    u32 used;
+    u32 slotSize;
+};
+
+/// A stack of temporary allocations, carved from a single heap block.
+struct GdArena {
+    u8 *base;
+    u32 size;
+    u32 used;
+    u32 peak;
+    s32 live;
+};
+#endif
+
 /* bss */
 static struct GMemBlock *sFreeBlockListHead;
 static struct GMemBlock *sUsedBlockListHead;
 static struct GMemBlock *sEmptyBlockListHead;
+#ifndef TARGET_N64
+static struct GdPoolSlab sPoolSlabs[GD_MAX_POOL_SLABS];
+static s32 sPoolSlabCount;
+/// Index + 1 of the slab starting in each `GD_POOL_SLAB_SIZE` page of memory, hashed by page
+static s16 sPoolSlabMap[GD_POOL_MAP_SIZE];
+static struct GdPoolSlab *sPoolCurSlab[GD_POOL_CLASSES];
+static void *sPoolFreeLists[GD_POOL_CLASSES];
+static struct GdArena sTempArena;
+#endif
 
 /* Forward Declarations */
 void empty_mem_block(struct GMemBlock *);
@@ -238,13 +274,198 @@ struct GMemBlock *gd_add_mem_to_heap(u32 size, void *addr, u8 permanence) {
     return newBlock;
 }
 
+#ifndef TARGET_N64
+/**
+ * Add the newest slab to the slab map. A slab is exactly one page long, so no
+ * two slabs start in the same page.
+ */
+static void pool_map_slab(s32 index) {
+    u32 i = GD_POOL_PAGE(sPoolSlabs[index].start) & (GD_POOL_MAP_SIZE - 1);
+
+    while (sPoolSlabMap[i] != 0) {
+        i = (i + 1) & (GD_POOL_MAP_SIZE - 1);
+    }
+    sPoolSlabMap[i] = index + 1;
+}
+
+/**
+ * Find the slab that starts in memory page `page`.
+ *
+ * @retval NULL no slab starts there
+ */
+static struct GdPoolSlab *pool_find_slab(uintptr_t page) {
+    u32 i = page & (GD_POOL_MAP_SIZE - 1);
+    s16 entry;
+
+    while ((entry = sPoolSlabMap[i]) != 0) {
+        if (GD_POOL_PAGE(sPoolSlabs[entry - 1].start) == page) {
+            return &sPoolSlabs[entry - 1];
+        }
+        i = (i + 1) & (GD_POOL_MAP_SIZE - 1);
+    }
+    return NULL;
+}
+
+/**
+ * Allocate `size` bytes of permanent memory from the pool of small blocks.
+ * Slots of each size class are handed out from shared slabs, so that the many
+ * small goddard objects don't each need a `GMemBlock` and a walk of the free list.
+ *
+ * @param size size of the allocation, at most `GD_POOL_MAX_SIZE`
+ * @return pointer to the slot
+ * @retval NULL the request should be made to the heap instead
+ */
+void *gd_pool_alloc(u32 size) {
+    s32 sizeClass;
+    struct GdPoolSlab *slab;
+    void *slot;
+
+    if (size == 0 || size > GD_POOL_MAX_SIZE) {
+        return NULL;
+    }
+    sizeClass = (size - 1) / GD_POOL_GRANULE;
+
+    if ((slot = sPoolFreeLists[sizeClass]) != NULL) {
+        sPoolFreeLists[sizeClass] = *(void **) slot;
+        return slot;
+    }
+
+    slab = sPoolCurSlab[sizeClass];
+    if (slab == NULL || slab->used + slab->slotSize > GD_POOL_SLAB_SIZE) {
+        if (sPoolSlabCount >= GD_MAX_POOL_SLABS) {
+            return NULL;
+        }
+        slab = &sPoolSlabs[sPoolSlabCount];
+        if ((slab->start = gd_request_mem(GD_POOL_SLAB_SIZE, PERM_G_MEM_BLOCK)) == NULL) {
+            return NULL;
+        }
+        pool_map_slab(sPoolSlabCount++);
+        slab->used = 0;
+        slab->slotSize = (sizeClass + 1) * GD_POOL_GRANULE;
+        sPoolCurSlab[sizeClass] = slab;
+    }
+
+    slot = slab->start + slab->used;
+    slab->used += slab->slotSize;
+    return slot;
+}
+
+/**
+ * Return a slot from `gd_pool_alloc()` to the free list of its size class.
+ * The slot is in the slab starting in its own page or in the page before, so
+ * its size class is found with at most two slab map lookups.
+ *
+ * @returns size of the slot
+ * @retval  0    `ptr` is not in a pool slab
+ */
+u32 gd_pool_free(void *ptr) {
+    u8 *slot = ptr;
+    struct GdPoolSlab *slab;
+    s32 sizeClass;
+
+    slab = pool_find_slab(GD_POOL_PAGE(slot));
+    if (slab == NULL || slot < slab->start) {
+        slab = pool_find_slab(GD_POOL_PAGE(slot) - 1);
+        if (slab == NULL || slot >= slab->start + GD_POOL_SLAB_SIZE) {
+            return 0;
+        }
+    }
+
+    sizeClass = slab->slotSize / GD_POOL_GRANULE - 1;
+    *(void **) slot = sPoolFreeLists[sizeClass];
+    sPoolFreeLists[sizeClass] = slot;
+    return slab->slotSize;
+}
+
+/**
+ * Allocate temporary memory from the top of the temp arena. Temporary memory
+ * only lives while dynlists are processed, and is mostly freed in reverse
+ * order, so freeing the topmost allocation pops it, and freeing the last live
+ * one empties the whole arena.
+ *
+ * @param size eight-byte aligned size of the allocation
+ * @retval NULL the request should be made to the heap instead
+ */
+void *gd_arena_alloc(u32 size) {
+    u8 *block;
+
+    if (sTempArena.base == NULL) {
+        sTempArena.size = GD_TEMP_ARENA_SIZE;
+        if ((sTempArena.base = gd_request_mem(sTempArena.size, TEMP_G_MEM_BLOCK)) == NULL) {
+            sTempArena.size = 0;
+            return NULL;
+        }
+    }
+
+    size += 8;
+    if (sTempArena.used + size >= sTempArena.size) {
+        return NULL;
+    }
+
+    block = sTempArena.base + sTempArena.used;
+    *(u32 *) block = size;
+    sTempArena.used += size;
+    sTempArena.live++;
+    if (sTempArena.used > sTempArena.peak) {
+        sTempArena.peak = sTempArena.used;
+    }
+
+    return block + 8;
+}
+
+/**
+ * Free memory from `gd_arena_alloc()`.
+ *
+ * @returns size of memory freed
+ * @retval  0    `ptr` is not in the temp arena
+ */
+u32 gd_arena_free(void *ptr) {
+    u8 *block = (u8 *) ptr - 8;
+    u32 size;
+
+    if (sTempArena.base == NULL || (u8 *) ptr <= sTempArena.base
+        || (u8 *) ptr >= sTempArena.base + sTempArena.size) {
+        return 0;
+    }
+
+    size = *(u32 *) block;
+    if (block + size == sTempArena.base + sTempArena.used) {
+        sTempArena.used = block - sTempArena.base;
+    }
+    if (--sTempArena.live == 0) {
+        sTempArena.used = 0;
+    }
+
+    return size - 8;
+}
+#endif
+
 /**
  * NULL the various `GMemBlock` list heads
  */
 void init_mem_block_lists(void) {
+#ifndef TARGET_N64
+    s32 i;
+
+#endif
     sFreeBlockListHead = NULL;
     sUsedBlockListHead = NULL;
     sEmptyBlockListHead = NULL;
+#ifndef TARGET_N64
+    for (i = 0; i < GD_POOL_CLASSES; i++) {
+        sPoolCurSlab[i] = NULL;
+        sPoolFreeLists[i] = NULL;
+    }
+    for (i = 0; i < GD_POOL_MAP_SIZE; i++) {
+        sPoolSlabMap[i] = 0;
+    }
+    sPoolSlabCount = 0;
+    sTempArena.base = NULL;
+    sTempArena.size = 0;
+    sTempArena.used = 0;
+    sTempArena.peak = 0;
+    sTempArena.live = 0;
+#endif
 }
 
 /**
@@ -311,6 +532,13 @@ void mem_stats(void) {
     gd_printf("Empty blocks:\n");
     list = sEmptyBlockListHead;
     print_list_stats(list, FALSE, PERM_G_MEM_BLOCK | TEMP_G_MEM_BLOCK);
+#ifndef TARGET_N64
+    gd_printf("\n");
+
+    gd_printf("Pool slabs: %d (%dk)\n", sPoolSlabCount, sPoolSlabCount * GD_POOL_SLAB_SIZE / 1024);
+    gd_printf("Temp arena: %d/%d bytes, peak %d, %d live\n", sTempArena.used, sTempArena.size,
+              sTempArena.peak, sTempArena.live);
+#endif
 }
 
 /*
@@ -31,5 +31,11 @@ extern void *gd_request_mem(u32 size, u8 permanence);
 extern struct GMemBlock *gd_add_mem_to_heap(u32 size, void *addr, u8 permanence);
 extern void init_mem_block_lists(void);
 extern void mem_stats(void);
+#ifndef TARGET_N64
+extern void *gd_pool_alloc(u32 size);
+extern u32 gd_pool_free(void *ptr);
+extern void *gd_arena_alloc(u32 size);
+extern u32 gd_arena_free(void *ptr);
+#endif
 
 #endif // GD_MEMORY_H
@@ -210,6 +210,9 @@ struct ObjJoint {
     /* 0x20C */ struct GdObj *unk20C;       //attached object?
     /* 0x210 */ u8  pad210[0x228-0x210];
     /* 0x228 */ f32 unk228;
+#if defined(GD_FLOAT32) || defined(GD_BENCHMARK)
+    struct GdSkinWeights *skinWeights;  // unk1F4 gathered into flat arrays, see skin_movement.c
+#endif
 }; /* sizeof = 0x22C */
 
 /* Particle Types (+60)
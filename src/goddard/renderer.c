@@ -66,6 +66,9 @@ struct GdDisplayList {
     /*0x44*/ u32 number; // count
     /*0x48*/ u8 pad48[4];
     /*0x4C*/ struct GdDisplayList *parent; // not quite sure?
+#ifndef TARGET_N64
+    Gfx *gfxStart; // first command; `gfx` moves to a new block when the list grows
+#endif
 };                                         /* sizeof = 0x50 */
 // accessor macros for gd dl
 #define DL_CURRENT_VTX(dl) ((dl)->vtx[(dl)->curVtxIdx])
@@ -74,6 +77,16 @@ struct GdDisplayList {
 #define DL_LIGHT_IDX(dl, idx) ((dl)->unk20[(idx)])
 #define DL_CURRENT_GFX(dl) ((dl)->gfx[(dl)->curGfxIdx])
 #define DL_CURRENT_VP(dl) ((dl)->vp[(dl)->curVpIdx])
+#ifndef TARGET_N64
+#define DL_START_GFX(dl) ((dl)->gfxStart)
+#else
+#define DL_START_GFX(dl) ((dl)->gfx)
+#endif
+
+#ifndef TARGET_N64
+// Free vertices a batch of make_vtx_if_new() needs before it is flushed
+#define GD_VTX_BATCH_MAX 16
+#endif
 
 struct LightDirVec {
     s32 x, y, z;
@@ -161,7 +174,13 @@ static struct GdDisplayList *sGdDlStash;    // @ 801BD7B8
 static struct GdDisplayList
     *sMHeadMainDls[2]; // @ 801BD7C0; seem to be basic dls that branch to actual lists?
 static struct GdDisplayList *D_801BD7C8[3][2];       // I guess? 801BD7C8 -> 801BD7E0?
+#ifndef TARGET_N64
+static struct GdDisplayList **sGdDLArray; // indexed by dl number, grows from MAX_GD_DLS
+static u32 sGdDLArraySize;
+static u32 sGdDlGrowCount; // display list arrays grown since gd_init
+#else
 static struct GdDisplayList *sGdDLArray[MAX_GD_DLS]; // @ 801BD7E0; indexed by dl number (gddl+0x44)
+#endif
 static s32 sPickBufLen;                              // @ 801BE780
 static s32 sPickBufPosition;                         // @ 801BE784
 static s16 *sPickBuf;                                // @ 801BE788
@@ -721,6 +740,7 @@ void gddl_is_loading_shine_dl(s32);
 void func_801A3370(f32, f32, f32);
 void gd_put_sprite(u16 *, s32, s32, s32, s32);
 void reset_cur_dl_indices(void);
+void fatal_no_dl_mem(void);
 
 // TODO: make a gddl_num_t?
 
@@ -744,31 +764,120 @@ void dump_disp_list(void) {
               sCurrentGdDl->totalGfx);
 }
 
+#ifndef TARGET_N64
+u32 get_gddl_grow_count(void) {
+    return sGdDlGrowCount;
+}
+
+/**
+ * Moves the rest of one of the arrays of `dl` to a new block of at least twice
+ * the size. A list started with `gd_startdisplist()` writes into the space left
+ * in its parent, so the parent moves along with it. What was written before
+ * stays in the old block, as earlier commands point into it.
+ *
+ * @param cur   the `cur*Idx` field of the array in `dl`
+ * @param total the `total*` field of the array in `dl`
+ * @param array the array itself
+ */
+static void grow_gddl_array(struct GdDisplayList *dl, s32 *cur, s32 *total, void **array, u32 size) {
+    struct GdDisplayList *parent = dl->parent;
+    s32 offset;
+    s32 newTotal;
+    void *newArray;
+
+    newTotal = *total;
+    if (parent != NULL) {
+        // same field of the parent
+        offset = (u8 *) total - (u8 *) dl;
+        newTotal = *(s32 *) ((u8 *) parent + offset);
+    }
+    newTotal = MAX(newTotal * 2, 2 * GD_VTX_BATCH_MAX);
+
+    if ((newArray = gd_malloc_perm(newTotal * size)) == NULL) {
+        dump_disp_list();
+        fatal_no_dl_mem();
+    }
+
+    *array = newArray;
+    *cur = 0;
+    *total = newTotal;
+    if (parent != NULL) {
+        *(void **) ((u8 *) parent + ((u8 *) array - (u8 *) dl)) = newArray;
+        *(s32 *) ((u8 *) parent + ((u8 *) cur - (u8 *) dl)) = 0;
+        *(s32 *) ((u8 *) parent + offset) = newTotal;
+    }
+    sGdDlGrowCount++;
+}
+#endif
+
 Gfx *next_gfx(void) {
+#ifndef TARGET_N64
+    Gfx *gfx;
+    Gfx *branch;
+#endif
+
     if (sCurrentGdDl->curGfxIdx >= sCurrentGdDl->totalGfx) {
         dump_disp_list();
         fatal_printf("Gfx list overflow");
     }
 
+#ifndef TARGET_N64
+    // The last command of a block is kept for the branch to the next one
+    gfx = &sCurrentGdDl->gfx[sCurrentGdDl->curGfxIdx++];
+    if (sCurrentGdDl->curGfxIdx >= sCurrentGdDl->totalGfx - 1) {
+        branch = &sCurrentGdDl->gfx[sCurrentGdDl->curGfxIdx];
+        grow_gddl_array(sCurrentGdDl, &sCurrentGdDl->curGfxIdx, &sCurrentGdDl->totalGfx,
+                        (void **) &sCurrentGdDl->gfx, sizeof(Gfx));
+        gSPBranchList(branch, GD_VIRTUAL_TO_PHYSICAL(sCurrentGdDl->gfx));
+    }
+    return gfx;
+#else
     return &sCurrentGdDl->gfx[sCurrentGdDl->curGfxIdx++];
+#endif
 }
 
 Lights4 *next_light(void) {
+#ifndef TARGET_N64
+    Lights4 *light;
+#endif
+
     if (sCurrentGdDl->curLightIdx >= sCurrentGdDl->totalLights) {
         dump_disp_list();
         fatal_printf("Light list overflow");
     }
 
+#ifndef TARGET_N64
+    light = &sCurrentGdDl->light[sCurrentGdDl->curLightIdx++];
+    if (sCurrentGdDl->curLightIdx >= sCurrentGdDl->totalLights) {
+        grow_gddl_array(sCurrentGdDl, &sCurrentGdDl->curLightIdx, &sCurrentGdDl->totalLights,
+                        (void **) &sCurrentGdDl->light, sizeof(Lights4));
+    }
+    return light;
+#else
     return &sCurrentGdDl->light[sCurrentGdDl->curLightIdx++];
+#endif
 }
 
 Mtx *next_mtx(void) {
+#ifndef TARGET_N64
+    Mtx *mtx;
+#endif
+
     if (sCurrentGdDl->curMtxIdx >= sCurrentGdDl->totalMtx) {
         dump_disp_list();
         fatal_printf("Mtx list overflow");
     }
 
+#ifndef TARGET_N64
+    mtx = &sCurrentGdDl->mtx[sCurrentGdDl->curMtxIdx++];
+    if (sCurrentGdDl->curMtxIdx >= sCurrentGdDl->totalMtx) {
+        grow_gddl_array(sCurrentGdDl, &sCurrentGdDl->curMtxIdx, &sCurrentGdDl->totalMtx,
+                        (void **) &sCurrentGdDl->mtx, sizeof(Mtx));
+    }
+    return mtx;
+#else
     return &sCurrentGdDl->mtx[sCurrentGdDl->curMtxIdx++];
+#endif
 }
 
 Vtx *next_vtx(void) {
@@ -782,12 +891,25 @@ Vtx *next_vtx(void) {
 
 /* 249A20 -> 249AAC */
 Vp *next_vp(void) {
+#ifndef TARGET_N64
+    Vp *vp;
+#endif
+
     if (sCurrentGdDl->curVpIdx >= sCurrentGdDl->totalVp) {
         dump_disp_list();
         fatal_printf("Vp list overflow");
     }
 
+#ifndef TARGET_N64
+    vp = &sCurrentGdDl->vp[sCurrentGdDl->curVpIdx++];
+    if (sCurrentGdDl->curVpIdx >= sCurrentGdDl->totalVp) {
+        grow_gddl_array(sCurrentGdDl, &sCurrentGdDl->curVpIdx, &sCurrentGdDl->totalVp,
+                        (void **) &sCurrentGdDl->vp, sizeof(Vp));
+    }
+    return vp;
+#else
     return &sCurrentGdDl->vp[sCurrentGdDl->curVpIdx++];
+#endif
 }
 
 /* 249AAC -> 249AEC */
@@ -913,6 +1035,14 @@ void gd_exit(UNUSED s32 code) {
 
 /* 24A1D4 -> 24A220; orig name: func_8019BA04 */
 void gd_free(void *ptr) {
+#ifndef TARGET_N64
+    u32 size;
+
+    if ((size = gd_arena_free(ptr)) != 0 || (size = gd_pool_free(ptr)) != 0) {
+        sAllocMemory -= size;
+        return;
+    }
+#endif
     sAllocMemory -= gd_free_mem(ptr);
 }
 
@@ -939,7 +1069,21 @@ void *gd_allocblock(u32 size) {
 void *gd_malloc(u32 size, u8 perm) {
     void *ptr; // 1c
     size = ALIGN(size, 8);
+#ifndef TARGET_N64
+    // Temporary memory comes from the temp arena and small permanent blocks
+    // from the pool, and only what doesn't fit there from the block lists
+    ptr = NULL;
+    if (perm == TEMP_G_MEM_BLOCK) {
+        ptr = gd_arena_alloc(size);
+    } else if (perm & PERM_G_MEM_BLOCK) {
+        ptr = gd_pool_alloc(size);
+    }
+    if (ptr == NULL) {
+        ptr = gd_request_mem(size, perm);
+    }
+#else
     ptr = gd_request_mem(size, perm);
+#endif
 
     if (ptr == NULL) {
         gd_printf("gd_malloc(): Failed request: %dk (%d bytes)\n", size / 1024, size);
@@ -981,7 +1125,7 @@ void func_8019BD0C(s32 dlNum, s32 gfxIdx) {
     if (gfxIdx != 0) {
         dl = sGdDLArray[dlNum]->dlptr[gfxIdx - 1];
     } else {
-        dl = sGdDLArray[dlNum]->gfx;
+        dl = DL_START_GFX(sGdDLArray[dlNum]);
     }
     gSPDisplayList(next_gfx(), GD_VIRTUAL_TO_PHYSICAL(dl));
 }
@@ -990,13 +1134,13 @@ void func_8019BD0C(s32 dlNum, s32 gfxIdx) {
 void branch_cur_dl_to_num(s32 dlNum) {
     Gfx *dl; // 24
 
-    dl = sGdDLArray[dlNum]->gfx;
+    dl = DL_START_GFX(sGdDLArray[dlNum]);
     gSPDisplayList(next_gfx(), GD_VIRTUAL_TO_PHYSICAL(dl));
 }
 
 /* 24A610 -> 24A640 */
 Gfx *Unknown8019BE40(s32 num) {
-    return sGdDLArray[num]->gfx;
+    return DL_START_GFX(sGdDLArray[num]);
 }
 
 /* 24A640 -> 24A8D0; orig name: func_8019BE70 */
@@ -1298,7 +1442,7 @@ void *gdm_gettestdl(s32 id) {
         fatal_printf("no display list");
     }
     stop_timer("dlgen");
-    return (void *) osVirtualToPhysical(gddl->gfx);
+    return (void *) osVirtualToPhysical(DL_START_GFX(gddl));
 }
 
 /* 24B418 -> 24B4CC; not called */
@@ -1337,12 +1481,19 @@ void bound_on_active_view(f32 *x, f32 *y) {
 
 /* 24B5A8 -> 24B5D4; orig name: func_8019CDD8 */
 void fatal_no_dl_mem(void) {
+#ifndef TARGET_N64
+    mem_stats();
+#endif
     fatal_printf("Out of DL mem\n");
 }
 
 /* 24B5D4 -> 24B6AC */
 struct GdDisplayList *alloc_displaylist(u32 id) {
     struct GdDisplayList *gdDl;
+#ifndef TARGET_N64
+    struct GdDisplayList **newArray;
+    u32 i;
+#endif
 
     gdDl = gd_malloc_perm(sizeof(struct GdDisplayList));
     if (gdDl == NULL) {
@@ -1350,10 +1501,28 @@ struct GdDisplayList *alloc_displaylist(u32 id) {
     }
 
     gdDl->number = sGdDlCount++;
+#ifndef TARGET_N64
+    if (sGdDlCount >= sGdDLArraySize) {
+        newArray = gd_malloc_perm(MAX(sGdDLArraySize * 2, MAX_GD_DLS) * sizeof(struct GdDisplayList *));
+        if (newArray == NULL) {
+            fatal_no_dl_mem();
+        }
+        for (i = 0; i < sGdDLArraySize; i++) {
+            newArray[i] = sGdDLArray[i];
+        }
+        if (sGdDLArray != NULL) {
+            gd_free(sGdDLArray);
+            sGdDlGrowCount++;
+        }
+        sGdDLArray = newArray;
+        sGdDLArraySize = MAX(sGdDLArraySize * 2, MAX_GD_DLS);
+    }
+#else
     if (sGdDlCount >= MAX_GD_DLS) {
         fatal_printf("alloc_displaylist() too many display lists %d (MAX %d)", sGdDlCount + 1,
                      MAX_GD_DLS);
     }
+#endif
     sGdDLArray[gdDl->number] = gdDl;
     gdDl->id = id;
     return gdDl;
@@ -1365,6 +1534,9 @@ void cpy_remaining_gddl(struct GdDisplayList *dst, struct GdDisplayList *src) {
     dst->mtx = &DL_CURRENT_MTX(src);
     dst->light = &DL_CURRENT_LIGHT(src);
     dst->gfx = &DL_CURRENT_GFX(src);
+#ifndef TARGET_N64
+    dst->gfxStart = dst->gfx;
+#endif
     dst->vp = &DL_CURRENT_VP(src);
     dst->totalVtx = src->totalVtx - src->curVtxIdx;
     dst->totalMtx = src->totalMtx - src->curMtxIdx;
@@ -1434,6 +1606,9 @@ struct GdDisplayList *new_gd_dl(s32 id, s32 gfxs, s32 verts, s32 mtxs, s32 light
     if ((dl->gfx = gd_malloc_perm(gfxs * sizeof(Gfx))) == NULL) {
         fatal_no_dl_mem();
     }
+#ifndef TARGET_N64
+    dl->gfxStart = dl->gfx;
+#endif
 
     if (vps == 0) {
         vps = 1;
@@ -1529,12 +1704,18 @@ void gd_set_color_fb(void) {
 /* 24CF2C -> 24CFCC; orig name: func_8019E75C */
 void reset_cur_dl_indices(void) {
     sMHeadMainDls[gGdFrameBuf]->curGfxIdx = 0;
+#ifndef TARGET_N64
+    sMHeadMainDls[gGdFrameBuf]->gfxStart = sMHeadMainDls[gGdFrameBuf]->gfx;
+#endif
     sCurrentGdDl = sDynDlSet1[gGdFrameBuf];
     sCurrentGdDl->curVtxIdx = 0;
     sCurrentGdDl->curMtxIdx = 0;
     sCurrentGdDl->curLightIdx = 0;
     sCurrentGdDl->curGfxIdx = 0;
     sCurrentGdDl->curVpIdx = 0;
+#ifndef TARGET_N64
+    sCurrentGdDl->gfxStart = sCurrentGdDl->gfx;
+#endif
 }
 
 /* 24CFCC -> 24D044; orig name: func_8019E7FC */
@@ -1545,6 +1726,9 @@ void reset_dlnum_indices(s32 num) {
     sCurrentGdDl->curLightIdx = 0;
     sCurrentGdDl->curGfxIdx = 0;
     sCurrentGdDl->curVpIdx = 0;
+#ifndef TARGET_N64
+    sCurrentGdDl->gfxStart = sCurrentGdDl->gfx;
+#endif
 }
 
 /* 24D044 -> 24D064; orig name: func_8019E874 */
@@ -1610,6 +1794,9 @@ s32 gd_enddlsplist_parent(void) {
 /* 24D39C -> 24D3D8 */
 void Unknown8019EBCC(s32 num, uintptr_t gfxptr) {
     sGdDLArray[num]->gfx = (Gfx *) (GD_LOWER_24(gfxptr) + D_801BAF28);
+#ifndef TARGET_N64
+    sGdDLArray[num]->gfxStart = sGdDLArray[num]->gfx;
+#endif
 }
 
 /* 24D3D8 -> 24D458; orig name: func_8019EC08 */
@@ -1618,6 +1805,9 @@ u32 new_gddl_from() {
 
     gddl = new_gd_dl(0, 0, 0, 0, 0, 0);
     gddl->gfx = (Gfx *) (GD_LOWER_24((uintptr_t) NULL) + D_801BAF28);
+#ifndef TARGET_N64
+    gddl->gfxStart = gddl->gfx;
+#endif
     return gddl->number;
 }
 
@@ -1627,6 +1817,9 @@ u32 Unknown8019EC88(Gfx *dl, UNUSED s32 arg1) {
 
     gddl = new_gd_dl(0, 0, 0, 0, 0, 0);
     gddl->gfx = dl;
+#ifndef TARGET_N64
+    gddl->gfxStart = dl;
+#endif
     return gddl->number;
 }
 
@@ -1860,6 +2053,11 @@ void func_8019FEF0(void) {
 void add_tri_to_dl(f32 x1, f32 y1, f32 z1, f32 x2, f32 y2, f32 z2, f32 x3, f32 y3, f32 z3) {
     Vtx *vtx; // 24
 
+#ifndef TARGET_N64
+    if (sCurrentGdDl->totalVtx - sCurrentGdDl->curVtxIdx < 3) {
+        func_801A0070();
+    }
+#endif
     vtx = &DL_CURRENT_VTX(sCurrentGdDl);
     make_vtx_if_new(x1, y1, z1, 1.0f);
     make_vtx_if_new(x2, y2, z2, 1.0f);
@@ -1871,6 +2069,13 @@ void add_tri_to_dl(f32 x1, f32 y1, f32 z1, f32 x2, f32 y2, f32 z2, f32 x3, f32 y
 
 /* 24E808 -> 24E840 */
 void func_801A0038(void) {
+#ifndef TARGET_N64
+    // Vertices of a batch have to be in one block, so grow between batches
+    if (sCurrentGdDl->totalVtx - sCurrentGdDl->curVtxIdx < GD_VTX_BATCH_MAX) {
+        grow_gddl_array(sCurrentGdDl, &sCurrentGdDl->curVtxIdx, &sCurrentGdDl->totalVtx,
+                        (void **) &sCurrentGdDl->vtx, sizeof(Vtx));
+    }
+#endif
     D_801BB0BC = 0;
     D_801BB0C4 = 0;
     D_801BB0CC = sCurrentGdDl->curVtxIdx;
@@ -3075,6 +3280,11 @@ void gd_init(void) {
     D_801A86F0 = 0;
     sNewZPresses = 0;
     sGdDlCount = 0;
+#ifndef TARGET_N64
+    sGdDLArray = NULL;
+    sGdDLArraySize = 0;
+    sGdDlGrowCount = 0;
+#endif
     D_801A8674 = 0;
     sLightId = 0;
     sAmbScaleColour.r = 0.0f;
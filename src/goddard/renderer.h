@@ -29,6 +29,9 @@ extern s32 gGdFrameBuf;
 
 // functions
 u32 get_alloc_mem_amt(void);
+#ifndef TARGET_N64
+u32 get_gddl_grow_count(void);
+#endif
 s32 gd_get_ostime(void);
 f32 get_time_scale(void);
 f64 gd_sin_d(f64 x);
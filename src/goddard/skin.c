@@ -11,6 +11,9 @@
 #include "renderer.h"
 #include "skin.h"
 #include "skin_movement.h"
+#ifdef GD_BENCHMARK
+#include "pc/perf_timer.h"
+#endif
 
 // bss
 struct ObjNet *gGdSkinNet; // @ 801BAAF0
@@ -232,11 +235,20 @@ void func_80192AD0(struct ObjNet *net) {
 void move_bonesnet(struct ObjNet *net) {
     struct ObjGroup *sp24;
     UNUSED u32 pad18[3];
+#ifdef GD_BENCHMARK
+    u64 startTime;
+#endif
 
     add_to_stacktrace("move_bonesnet");
     gd_set_identity_mat4(&D_801B9DC8);
     if ((sp24 = net->unk1C8) != NULL) {
+#ifdef GD_BENCHMARK
+        startTime = perf_timer_ns();
+#endif
         apply_to_obj_types_in_group(OBJ_TYPE_JOINTS, (applyproc_t) func_801913C0, sp24);
+#ifdef GD_BENCHMARK
+        skin_benchmark_record(perf_timer_ns() - startTime);
+#endif
     }
     imout();
 }
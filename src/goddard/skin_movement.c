@@ -8,6 +8,35 @@
 #include "objects.h"
 #include "skin.h"
 #include "skin_movement.h"
+#include "renderer.h"
+#ifdef GD_BENCHMARK
+#include <stdio.h>
+#include "pc/perf_timer.h"
+#endif
+
+#if defined(GD_FLOAT32) || defined(GD_BENCHMARK)
+// The weights of one joint that have a nonzero influence, in SoA form so that
+// the per frame deformation is a flat single precision loop instead of a walk
+// over the weight objects of the joint's group.
+struct GdSkinWeights {
+    s32 count;
+    s32 capacity;
+    f32 *x;
+    f32 *y;
+    f32 *z;
+    f32 *weight;
+    struct ObjVertex **vtx;
+};
+#endif
+
+#ifdef GD_BENCHMARK
+#define GD_BENCHMARK_FRAMES 300
+
+static u64 sSkinBenchmarkNs[2];
+static u32 sSkinBenchmarkWeights;
+static u32 sSkinBenchmarkFrames;
+static s32 sSkinBenchmarkSoa; // which path the current window times
+#endif
 
 /* bss */
 struct ObjWeight *sSkinNetCurWeight;
@@ -73,6 +102,117 @@ void move_skin(struct ObjNet *net) {
     }
 }
 
+#if defined(GD_FLOAT32) || defined(GD_BENCHMARK)
+/**
+ * Gathers the weights of a joint into its GdSkinWeights after they have been
+ * reset. The arrays are kept when the joint is reset again with no more weights.
+ */
+static void gather_skin_weights(struct ObjJoint *joint) {
+    struct GdSkinWeights *sw;
+    struct ObjWeight *weight;
+    struct Links *link;
+    s32 count = 0;
+
+    if (joint->unk1F4 == NULL) {
+        return;
+    }
+    for (link = joint->unk1F4->link1C; link != NULL; link = link->next) {
+        if (link->obj->type == OBJ_TYPE_WEIGHTS) {
+            count++;
+        }
+    }
+
+    sw = joint->skinWeights;
+    if (sw == NULL || sw->capacity < count) {
+        if (sw == NULL && (sw = gd_malloc_perm(sizeof(struct GdSkinWeights))) == NULL) {
+            fatal_printf("gather_skin_weights(): Can't allocate skin weights");
+        }
+        sw->capacity = count;
+        sw->x = gd_malloc_perm(count * sizeof(f32));
+        sw->y = gd_malloc_perm(count * sizeof(f32));
+        sw->z = gd_malloc_perm(count * sizeof(f32));
+        sw->weight = gd_malloc_perm(count * sizeof(f32));
+        sw->vtx = gd_malloc_perm(count * sizeof(struct ObjVertex *));
+        if (sw->x == NULL || sw->y == NULL || sw->z == NULL || sw->weight == NULL || sw->vtx == NULL) {
+            fatal_printf("gather_skin_weights(): Can't allocate %d skin weights", count);
+        }
+        joint->skinWeights = sw;
+    }
+
+    sw->count = 0;
+    for (link = joint->unk1F4->link1C; link != NULL; link = link->next) {
+        weight = (struct ObjWeight *) link->obj;
+        if (weight->header.type == OBJ_TYPE_WEIGHTS && weight->unk38 > 0.0f) {
+            sw->x[sw->count] = weight->vec20.x;
+            sw->y[sw->count] = weight->vec20.y;
+            sw->z[sw->count] = weight->vec20.z;
+            sw->weight[sw->count] = weight->unk38;
+            sw->vtx[sw->count] = weight->unk3C;
+            sw->count++;
+        }
+    }
+}
+
+/**
+ * Same as func_80181894, on the gathered weights.
+ */
+static void apply_skin_weights(struct ObjJoint *joint) {
+    const struct GdSkinWeights *sw = joint->skinWeights;
+    const f32 m00 = joint->matE8[0][0], m01 = joint->matE8[0][1], m02 = joint->matE8[0][2];
+    const f32 m10 = joint->matE8[1][0], m11 = joint->matE8[1][1], m12 = joint->matE8[1][2];
+    const f32 m20 = joint->matE8[2][0], m21 = joint->matE8[2][1], m22 = joint->matE8[2][2];
+    const f32 m30 = joint->matE8[3][0], m31 = joint->matE8[3][1], m32 = joint->matE8[3][2];
+    struct ObjVertex *vtx;
+    f32 x, y, z, w;
+    s32 i;
+
+    for (i = 0; i < sw->count; i++) {
+        x = sw->x[i];
+        y = sw->y[i];
+        z = sw->z[i];
+        w = sw->weight[i];
+        vtx = sw->vtx[i];
+
+        vtx->pos.x += (m00 * x + m10 * y + m20 * z + m30) * w;
+        vtx->pos.y += (m01 * x + m11 * y + m21 * z + m31) * w;
+        vtx->pos.z += (m02 * x + m12 * y + m22 * z + m32) * w;
+    }
+}
+#endif
+
+#ifdef GD_BENCHMARK
+/**
+ * Accumulates the time of one pass of weight deformation over all joints, and
+ * switches between the reference and SoA paths every GD_BENCHMARK_FRAMES frames.
+ * The averages of both are printed once each has run for a full window.
+ */
+void skin_benchmark_record(u64 ns) {
+    struct ObjJoint *joint;
+
+    sSkinBenchmarkNs[sSkinBenchmarkSoa] += ns;
+    if (++sSkinBenchmarkFrames < GD_BENCHMARK_FRAMES) {
+        return;
+    }
+
+    sSkinBenchmarkFrames = 0;
+    sSkinBenchmarkSoa ^= 1;
+    if (sSkinBenchmarkSoa) {
+        return;
+    }
+
+    sSkinBenchmarkWeights = 0;
+    for (joint = gGdJointList; joint != NULL; joint = joint->nextjoint) {
+        if (joint->skinWeights != NULL) {
+            sSkinBenchmarkWeights += joint->skinWeights->count;
+        }
+    }
+    printf("gd skin: %u weights, reference %u ns/frame, float32 soa %u ns/frame\n", sSkinBenchmarkWeights,
+           (u32)(sSkinBenchmarkNs[0] / GD_BENCHMARK_FRAMES), (u32)(sSkinBenchmarkNs[1] / GD_BENCHMARK_FRAMES));
+    sSkinBenchmarkNs[0] = 0;
+    sSkinBenchmarkNs[1] = 0;
+}
+#endif
+
 /* @ 230064 for 0x13C*/
 void func_80181894(struct ObjJoint *joint) {
     register struct ObjGroup *weightGroup; // baseGroup? weights Only?
@@ -83,6 +223,18 @@ void func_80181894(struct ObjJoint *joint) {
     register f32 scaleFactor;
     struct GdObj *linkedObj;
 
+#ifdef GD_BENCHMARK
+    if (sSkinBenchmarkSoa && joint->skinWeights != NULL) {
+        apply_skin_weights(joint);
+        return;
+    }
+#elif defined(GD_FLOAT32)
+    if (joint->skinWeights != NULL) {
+        apply_skin_weights(joint);
+        return;
+    }
+#endif
+
     weightGroup = joint->unk1F4;
     if (weightGroup != NULL) {
         for (link = weightGroup->link1C; link != NULL; link = link->next) {
@@ -155,5 +307,8 @@ void func_80181B88(struct ObjJoint *joint) {
     D_801B9EE8 = joint;
     if ((group = joint->unk1F4) != NULL) {
         apply_to_obj_types_in_group(OBJ_TYPE_WEIGHTS, (applyproc_t) reset_weight, group);
+#if defined(GD_FLOAT32) || defined(GD_BENCHMARK)
+        gather_skin_weights(joint);
+#endif
     }
 }
@@ -7,5 +7,8 @@ void func_80181760(struct ObjGroup *a0);
 void move_skin(struct ObjNet *net);
 void func_80181894(struct ObjJoint *joint);
 void func_80181B88(struct ObjJoint *joint);
+#ifdef GD_BENCHMARK
+void skin_benchmark_record(u64 ns);
+#endif
 
 #endif // GD_SKIN_MOVEMENT_H
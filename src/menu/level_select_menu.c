@@ -13,6 +13,9 @@
 #include "level_table.h"
 #include "seq_ids.h"
 #include "sm64.h"
+#ifdef LOAD_BENCHMARK
+#include "pc/load_benchmark.h"
+#endif
 
 #define PRESS_START_DEMO_TIMER 800
 
@@ -77,6 +80,15 @@ int run_press_start_demo_timer(s32 timer) {
 s16 level_select_input_loop(void) {
     s32 stageChanged = FALSE;
 
+#ifdef LOAD_BENCHMARK
+    // Go straight to the first course of the benchmark
+    gCurrSaveFileNum = 4;
+    gCurrActNum = 6;
+    gCurrLevelNum = load_benchmark_next_level();
+    load_benchmark_start();
+    return gCurrLevelNum;
+#endif
+
     // perform the ID updates per each button press.
     if (gPlayer1Controller->buttonPressed & A_BUTTON) {
         ++gCurrLevelNum, stageChanged = TRUE;
@@ -149,6 +161,10 @@ int intro_default(void) {
 #endif
     print_intro_text();
 
+#ifdef LOAD_BENCHMARK
+    return 101; // level select
+#endif
+
     if (gPlayer1Controller->buttonPressed & START_BUTTON) {
 #ifdef VERSION_JP
         play_sound(SOUND_MENU_STAR_SOUND, gDefaultSoundArgs);
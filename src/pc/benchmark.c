@@ -0,0 +1,194 @@
+#ifdef HEADLESS
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sm64.h"
+#include "game/camera.h"
+#include "game/game_init.h"
+#include "game/level_update.h"
+#include "game/object_list_processor.h"
+
+#include "benchmark.h"
+#include "perf_timer.h"
+#include "controller/controller_recorded_tas.h"
+#include "common.h"
+
+// Frames to run when no cont.m64 is present
+#define BENCHMARK_DEFAULT_FRAMES 1800
+// Write a state hash every this many frames
+#define BENCHMARK_HASH_INTERVAL 30
+#define BENCHMARK_HASH_FILE "statehash.txt"
+
+struct BenchmarkFrame {
+    uint32_t total;
+    uint32_t timers[BENCHMARK_TIMER_COUNT];
+};
+
+static struct BenchmarkFrame *frames;
+static uint32_t num_frames;
+static uint32_t frames_capacity;
+
+static uint64_t timer_start[BENCHMARK_TIMER_COUNT];
+static uint64_t timer_total[BENCHMARK_TIMER_COUNT];
+
+static FILE *hash_file;
+static bool has_recording;
+
+void benchmark_begin(enum BenchmarkTimer timer) {
+    timer_start[timer] = perf_timer_ns();
+}
+
+void benchmark_end(enum BenchmarkTimer timer) {
+    timer_total[timer] += perf_timer_ns() - timer_start[timer];
+}
+
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    size_t i;
+
+    // FNV-1a
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * Hash the parts of the game state that any change in simulation shows up in.
+ * Pointers are left out so that hashes can be compared between builds.
+ */
+static uint32_t hash_game_state(void) {
+    struct MarioState *m = &gMarioStates[0];
+    uint32_t hash = 2166136261U;
+    int i;
+
+    hash = hash_bytes(hash, &gGlobalTimer, sizeof(gGlobalTimer));
+    hash = hash_bytes(hash, &m->action, sizeof(m->action));
+    hash = hash_bytes(hash, &m->actionState, sizeof(m->actionState));
+    hash = hash_bytes(hash, &m->actionTimer, sizeof(m->actionTimer));
+    hash = hash_bytes(hash, m->faceAngle, sizeof(m->faceAngle));
+    hash = hash_bytes(hash, m->pos, sizeof(m->pos));
+    hash = hash_bytes(hash, m->vel, sizeof(m->vel));
+    hash = hash_bytes(hash, &m->forwardVel, sizeof(m->forwardVel));
+    hash = hash_bytes(hash, &m->health, sizeof(m->health));
+    hash = hash_bytes(hash, &m->numCoins, sizeof(m->numCoins));
+    hash = hash_bytes(hash, gLakituState.curPos, sizeof(gLakituState.curPos));
+    hash = hash_bytes(hash, gLakituState.curFocus, sizeof(gLakituState.curFocus));
+
+    for (i = 0; i < OBJECT_POOL_CAPACITY; i++) {
+        struct Object *obj = &gObjectPool[i];
+
+        if (obj->activeFlags & ACTIVE_FLAG_ACTIVE) {
+            hash = hash_bytes(hash, &i, sizeof(i));
+            hash = hash_bytes(hash, &obj->oPosX, sizeof(f32) * 3);
+            hash = hash_bytes(hash, &obj->oVelX, sizeof(f32) * 3);
+            hash = hash_bytes(hash, &obj->oFaceAngleYaw, sizeof(s32));
+            hash = hash_bytes(hash, &obj->oAction, sizeof(s32));
+            hash = hash_bytes(hash, &obj->oTimer, sizeof(s32));
+        }
+    }
+
+    return hash;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_stats(const char *name, uint32_t *samples) {
+    qsort(samples, num_frames, sizeof(uint32_t), compare_u32);
+    printf("%-12s %10.3f %10.3f %10.3f\n", name, samples[0] / 1000000.0,
+           samples[num_frames / 2] / 1000000.0, samples[(uint32_t)(num_frames * 0.99)] / 1000000.0);
+}
+
+static void benchmark_report(void) {
+    static const char *names[] = { "logic", "geo", "gfx_run_dl", "raster", "total" };
+    uint32_t *samples = malloc(num_frames * sizeof(uint32_t));
+    uint32_t i, j;
+
+    printf("%u frames\n", num_frames);
+    printf("%-12s %10s %10s %10s\n", "ms/frame", "min", "median", "p99");
+    for (j = 0; j < 5; j++) {
+        for (i = 0; i < num_frames; i++) {
+            const struct BenchmarkFrame *f = &frames[i];
+            switch (j) {
+                case 0:
+                    samples[i] = f->total - f->timers[BENCHMARK_GEO] - f->timers[BENCHMARK_GFX];
+                    break;
+                case 1:
+                    samples[i] = f->timers[BENCHMARK_GEO];
+                    break;
+                case 2:
+                    samples[i] = f->timers[BENCHMARK_GFX] - f->timers[BENCHMARK_RASTER];
+                    break;
+                case 3:
+                    samples[i] = f->timers[BENCHMARK_RASTER];
+                    break;
+                default:
+                    samples[i] = f->total;
+                    break;
+            }
+        }
+        print_stats(names[j], samples);
+    }
+
+    free(samples);
+}
+
+/**
+ * Run one game iteration, timing it, and finish the benchmark once the
+ * recorded input runs out.
+ */
+void benchmark_run_frame(void (*run_one_game_iter)(void)) {
+    uint64_t start;
+    struct BenchmarkFrame *f;
+    int i;
+
+    if (num_frames == frames_capacity) {
+        frames_capacity = frames_capacity ? frames_capacity * 2 : 4096;
+        frames = realloc(frames, frames_capacity * sizeof(struct BenchmarkFrame));
+    }
+    f = &frames[num_frames++];
+
+    memset(timer_total, 0, sizeof(timer_total));
+    start = perf_timer_ns();
+    run_one_game_iter();
+    f->total = perf_timer_ns() - start;
+    for (i = 0; i < BENCHMARK_TIMER_COUNT; i++) {
+        f->timers[i] = timer_total[i];
+    }
+
+    if (num_frames % BENCHMARK_HASH_INTERVAL == 0) {
+        if (hash_file == NULL) {
+            hash_file = fopen(BENCHMARK_HASH_FILE, "w");
+        }
+        if (hash_file != NULL) {
+            fprintf(hash_file, "%u %08x\n", num_frames, hash_game_state());
+        }
+    }
+
+    if (num_frames == 1) {
+        FILE *fp = fopen("cont.m64", "rb");
+        has_recording = fp != NULL;
+        if (fp != NULL) {
+            fclose(fp);
+        } else {
+            printf("No cont.m64 found, running %d frames without input\n", BENCHMARK_DEFAULT_FRAMES);
+        }
+    }
+
+    if (has_recording ? controller_recorded_tas_finished() : num_frames >= BENCHMARK_DEFAULT_FRAMES) {
+        benchmark_report();
+        if (hash_file != NULL) {
+            fclose(hash_file);
+        }
+        game_exit();
+    }
+}
+
+#endif
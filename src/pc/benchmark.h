@@ -0,0 +1,24 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// Per-frame timers of the headless replay benchmark (HEADLESS=1)
+enum BenchmarkTimer {
+    BENCHMARK_GEO,    // geo_process_root
+    BENCHMARK_GFX,    // gfx_run, including rasterization
+    BENCHMARK_RASTER, // Rendering API draw calls
+    BENCHMARK_TIMER_COUNT
+};
+
+#ifdef HEADLESS
+void benchmark_begin(enum BenchmarkTimer timer);
+void benchmark_end(enum BenchmarkTimer timer);
+void benchmark_run_frame(void (*run_one_game_iter)(void));
+
+#define BENCHMARK_BEGIN(timer) benchmark_begin(timer)
+#define BENCHMARK_END(timer) benchmark_end(timer)
+#else
+#define BENCHMARK_BEGIN(timer)
+#define BENCHMARK_END(timer)
+#endif
+
+#endif
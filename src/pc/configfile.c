@@ -39,6 +39,27 @@ bool configDoubleResolution = false;
 unsigned int configScreenWidth   = 640;
 unsigned int configScreenHeight  = 480;
 unsigned int configFrameskip     = 30;
+bool configFrustumCulling        = true;
+#ifdef TARGET_DOS
+bool configLevelOfDetail         = true;
+#else
+bool configLevelOfDetail         = false;
+#endif
+bool configShowStats             = false;
+bool configShowProfiler          = false;
+bool configLevelCache            = true;
+bool configShadowCache           = true;
+bool configAnimCache             = true;
+bool configSimdMath              = true;
+bool configGeoCompile            = true;
+bool configSortDisplayLists      = true;
+bool configDirtyPresent          = true;
+bool configOptimizedPalette      = true;
+bool configTextureAtlas          = true;
+unsigned int configTextureBudget = 2048;
+#ifdef ZONE_PROFILER
+bool configProfilerTrace         = false;
+#endif
 // Keyboard mappings (scancode values)
 #ifdef TARGET_DOS
 // Allegro scancodes
@@ -83,6 +104,23 @@ static const struct ConfigOption options[] = {
     {.name = "screen_width",      .type = CONFIG_TYPE_UINT, .uintValue = &configScreenWidth},
     {.name = "screen_height",     .type = CONFIG_TYPE_UINT, .uintValue = &configScreenHeight},
     {.name = "frameskip",         .type = CONFIG_TYPE_UINT, .uintValue = &configFrameskip},
+    {.name = "frustum_culling",   .type = CONFIG_TYPE_BOOL, .boolValue = &configFrustumCulling},
+    {.name = "level_of_detail",   .type = CONFIG_TYPE_BOOL, .boolValue = &configLevelOfDetail},
+    {.name = "show_stats",        .type = CONFIG_TYPE_BOOL, .boolValue = &configShowStats},
+    {.name = "show_profiler",     .type = CONFIG_TYPE_BOOL, .boolValue = &configShowProfiler},
+    {.name = "level_cache",       .type = CONFIG_TYPE_BOOL, .boolValue = &configLevelCache},
+    {.name = "shadow_cache",      .type = CONFIG_TYPE_BOOL, .boolValue = &configShadowCache},
+    {.name = "anim_cache",        .type = CONFIG_TYPE_BOOL, .boolValue = &configAnimCache},
+    {.name = "simd_math",         .type = CONFIG_TYPE_BOOL, .boolValue = &configSimdMath},
+    {.name = "geo_compile",       .type = CONFIG_TYPE_BOOL, .boolValue = &configGeoCompile},
+    {.name = "sort_display_lists", .type = CONFIG_TYPE_BOOL, .boolValue = &configSortDisplayLists},
+    {.name = "dirty_present",     .type = CONFIG_TYPE_BOOL, .boolValue = &configDirtyPresent},
+    {.name = "optimized_palette", .type = CONFIG_TYPE_BOOL, .boolValue = &configOptimizedPalette},
+    {.name = "texture_atlas",     .type = CONFIG_TYPE_BOOL, .boolValue = &configTextureAtlas},
+    {.name = "texture_budget",    .type = CONFIG_TYPE_UINT, .uintValue = &configTextureBudget},
+#ifdef ZONE_PROFILER
+    {.name = "profiler_trace",    .type = CONFIG_TYPE_BOOL, .boolValue = &configProfilerTrace},
+#endif
     {.name = "key_a",             .type = CONFIG_TYPE_UINT, .uintValue = &configKeyA},
     {.name = "key_b",             .type = CONFIG_TYPE_UINT, .uintValue = &configKeyB},
     {.name = "key_start",         .type = CONFIG_TYPE_UINT, .uintValue = &configKeyStart},
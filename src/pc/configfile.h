@@ -10,6 +10,23 @@ extern bool         configFiltering;
 extern bool         configEnableSound;
 extern bool         configEnableFog;
 extern unsigned int configFrameskip;
+extern bool         configFrustumCulling;
+extern bool         configLevelOfDetail;
+extern bool         configShowStats;
+extern bool         configShowProfiler;
+extern bool         configLevelCache;
+extern bool         configShadowCache;
+extern bool         configAnimCache;
+extern bool         configSimdMath;
+extern bool         configGeoCompile;
+extern bool         configSortDisplayLists;
+extern bool         configDirtyPresent;
+extern bool         configOptimizedPalette;
+extern bool         configTextureAtlas;
+extern unsigned int configTextureBudget;
+#ifdef ZONE_PROFILER
+extern bool         configProfilerTrace;
+#endif
 extern bool         configDoubleResolution;
 extern unsigned int configScreenWidth;
 extern unsigned int configScreenHeight;
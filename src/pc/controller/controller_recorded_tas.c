@@ -1,9 +1,12 @@
 #include <stdio.h>
+#include <stdbool.h>
 #include <ultra64.h>
 
 #include "controller_api.h"
+#include "controller_recorded_tas.h"
 
 static FILE *fp;
+static bool finished;
 
 static void tas_init(void) {
     fp = fopen("cont.m64", "rb");
@@ -16,13 +19,19 @@ static void tas_init(void) {
 static void tas_read(OSContPad *pad) {
     if (fp != NULL) {
         uint8_t bytes[4] = {0};
-        fread(bytes, 1, 4, fp);
+        if (fread(bytes, 1, 4, fp) < 4) {
+            finished = true;
+        }
         pad->button = (bytes[0] << 8) | bytes[1];
         pad->stick_x = bytes[2];
         pad->stick_y = bytes[3];
     }
 }
 
+bool controller_recorded_tas_finished(void) {
+    return finished;
+}
+
 struct ControllerAPI controller_recorded_tas = {
     tas_init,
     tas_read
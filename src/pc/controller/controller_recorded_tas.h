@@ -1,8 +1,13 @@
 #ifndef CONTROLLER_RECORDED_TAS_H
 #define CONTROLLER_RECORDED_TAS_H
 
+#include <stdbool.h>
+
 #include "controller_api.h"
 
 extern struct ControllerAPI controller_recorded_tas;
 
+// True once every input in cont.m64 has been played back
+bool controller_recorded_tas_finished(void);
+
 #endif
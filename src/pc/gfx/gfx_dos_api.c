@@ -24,6 +24,8 @@
 #include <allegro.h>
 #include <dpmi.h>
 
+uint32_t gfx_dos_vram_bytes; // written to VRAM by the last present
+
 #ifdef ENABLE_DMESA
 
 #include <GL/gl.h>
@@ -121,6 +123,9 @@ void (*backbuffer_function)(void);
 uint8_t page = 0;
 //uint8_t *destscreen = (uint8_t *) (VGA_BASE + 0x4B00);
 
+#ifdef ENABLE_OSMESA
+// OSMesa always renders RGBA32, so these convert every pixel while presenting
+
 static void gfx_dos_swap_buffers_modex(void) {
     // we're gonna be only sending plane switch commands until the end of the function
     outportb(REG_SELECT, REG_MASK);
@@ -157,12 +162,16 @@ static void gfx_dos_swap_buffers_modex(void) {
 
 }
 
+#endif
+
 static void gfx_dos_swap_buffers_hercules(void) {
     const RGBA *inp = (RGBA *) GFX_BUFFER;
     uint8_t *vram = (uint8_t *) ptrscreen;
     uint32_t backbuffer_position = 0;
     uint8_t position = 0;
 
+    gfx_dos_vram_bytes = 0;
+
     for (unsigned y = 0; y < SCREEN_HEIGHT_200_2X; y++) {
         for (unsigned x = 0; x < SCREEN_WIDTH_2X / 8; x++, vram++, backbuffer_position++) {
             uint8_t value = 0;
@@ -185,6 +194,7 @@ static void gfx_dos_swap_buffers_hercules(void) {
             if (hercules_backbuffer[backbuffer_position] != value){
                     *vram = value;
                     hercules_backbuffer[backbuffer_position] = value;
+                    gfx_dos_vram_bytes++;
             }
 
         }
@@ -200,6 +210,7 @@ static void gfx_dos_swap_buffers_hercules(void) {
     }
 }
 
+#ifdef ENABLE_OSMESA
 static void gfx_dos_swap_buffers_vesa_lfb_8_native(void) {
     uint8_t *inp = GFX_BUFFER;
     uint16_t *vram = (uint16_t *) ptrscreen;
@@ -334,6 +345,201 @@ static void gfx_dos_swap_buffers_vesa_lfb_16(void) {
     }
 }
 
+#else
+// gfx_soft already renders in the format of these modes (see gfx_soft_set_output_format)
+// and flags the tiles it draws into. Those get compared against a copy of the last
+// presented frame, and a VRAM page only gets the tiles that changed since it was last
+// presented to. The rest of the screen is left alone, VRAM bandwidth is scarce.
+
+#define TILE_SIZE GFX_SOFT_TILE_SIZE
+
+static uint8_t *present_shadow;             // last presented frame, in the gfx_output format
+static uint32_t present_bpp;                // bytes per pixel in gfx_output
+static uint32_t present_frame;              // frames presented so far
+static uint32_t tile_frame[GFX_SOFT_TILES]; // frame each tile last changed in
+static uint32_t page_frame[3];              // frame each VRAM page was last presented in
+static uint32_t screen_bpp;                 // bytes per pixel in VRAM
+static uint32_t screen_scale;               // 2 with configDoubleResolution
+static void (*present_row)(const uint8_t *inp, uint8_t *vram); // writes one tile row
+
+static void present_row_copy_8(const uint8_t *inp, uint8_t *vram) {
+    memcpy(vram, inp, TILE_SIZE);
+}
+
+static void present_row_copy_16(const uint8_t *inp, uint8_t *vram) {
+    memcpy(vram, inp, TILE_SIZE * 2);
+}
+
+static void present_row_double_8(const uint8_t *inp, uint8_t *vram) {
+    uint16_t *out = (uint16_t *) vram;
+    for (unsigned x = 0; x < TILE_SIZE; x++)
+        out[x] = inp[x] | (inp[x] << 8);
+}
+
+static void present_row_double_16(const uint8_t *inp, uint8_t *vram) {
+    const uint16_t *in = (const uint16_t *) inp;
+    uint32_t *out = (uint32_t *) vram;
+    for (unsigned x = 0; x < TILE_SIZE; x++)
+        out[x] = in[x] | (in[x] << 16);
+}
+
+static void present_row_24(const uint8_t *inp, uint8_t *vram) {
+    for (unsigned x = 0; x < TILE_SIZE; x++, inp += 4, vram += 3) {
+        *(vram) = *(inp + 2);
+        *(vram + 1) = *(inp + 1);
+        *(vram + 2) = *(inp);
+    }
+}
+
+static void present_row_double_24(const uint8_t *inp, uint8_t *vram) {
+    for (unsigned x = 0; x < TILE_SIZE; x++, inp += 4, vram += 6) {
+        *(vram) = *(vram + 3) = *(inp + 2);
+        *(vram + 1) = *(vram + 4) = *(inp + 1);
+        *(vram + 2) = *(vram + 5) = *(inp);
+    }
+}
+
+static void present_row_32(const uint8_t *inp, uint8_t *vram) {
+    for (unsigned x = 0; x < TILE_SIZE; x++, inp += 4, vram += 4) {
+        *(vram) = *(inp + 2);
+        *(vram + 1) = *(inp + 1);
+        *(vram + 2) = *(inp);
+    }
+}
+
+static void present_row_double_32(const uint8_t *inp, uint8_t *vram) {
+    for (unsigned x = 0; x < TILE_SIZE; x++, inp += 4, vram += 8) {
+        *(vram) = *(vram + 4) = *(inp + 2);
+        *(vram + 1) = *(vram + 5) = *(inp + 1);
+        *(vram + 2) = *(vram + 6) = *(inp);
+    }
+}
+
+static void gfx_dos_present_init(enum GfxSoftFormat format, uint32_t bpp, void (*row)(const uint8_t *, uint8_t *)) {
+    gfx_soft_set_output_format(format);
+
+    present_bpp = (format == GFX_SOFT_FMT_RGBA32) ? 4 : (format == GFX_SOFT_FMT_RGB332 || format == GFX_SOFT_FMT_PAL8) ? 1 : 2;
+    screen_bpp = bpp;
+    screen_scale = configDoubleResolution ? 2 : 1;
+    present_row = row;
+
+    present_shadow = calloc(SCREEN_WIDTH * SCREEN_HEIGHT_240, present_bpp);
+
+    if (!present_shadow) {
+        fprintf(stderr, "present_shadow malloc failed!\n");
+        abort();
+    }
+
+    // VRAM holds garbage after the mode set, so every page needs every tile once
+    present_frame = 1;
+    for (unsigned t = 0; t < GFX_SOFT_TILES; t++)
+        tile_frame[t] = present_frame;
+    memset(page_frame, 0, sizeof(page_frame));
+}
+
+static void gfx_dos_load_palette(const uint8_t *rgb) {
+    outportb(PAL_LOAD, 0);
+    for (unsigned i = 0; i < 256 * 3; i++)
+        outportb(PAL_COLOR, rgb[i] >> 2);
+}
+
+// Finds the tiles that changed since the last present and updates the shadow copy
+static void gfx_dos_present_update(void) {
+    const uint8_t *in = (const uint8_t *) GFX_BUFFER;
+    const uint32_t pitch = SCREEN_WIDTH * present_bpp;
+    const uint32_t rowBytes = TILE_SIZE * present_bpp;
+    const uint8_t *palette = gfx_soft_get_new_palette();
+
+    // gfx_soft switches palettes between frames, and this frame already uses the new one
+    if (palette)
+        gfx_dos_load_palette(palette);
+
+    present_frame++;
+    gfx_dos_vram_bytes = 0;
+
+    for (unsigned t = 0; t < GFX_SOFT_TILES; t++) {
+        if (!configDirtyPresent) {
+            tile_frame[t] = present_frame;
+            continue;
+        }
+        if (!gfx_soft_dirty_tiles[t])
+            continue;
+        gfx_soft_dirty_tiles[t] = 0;
+
+        // most tiles get redrawn every frame, but with the same pixels
+        const uint32_t offset = (t / GFX_SOFT_TILES_X) * TILE_SIZE * pitch + (t % GFX_SOFT_TILES_X) * rowBytes;
+        for (unsigned y = 0; y < TILE_SIZE; y++) {
+            if (memcmp(present_shadow + offset + y * pitch, in + offset + y * pitch, rowBytes)) {
+                for (; y < TILE_SIZE; y++)
+                    memcpy(present_shadow + offset + y * pitch, in + offset + y * pitch, rowBytes);
+                tile_frame[t] = present_frame;
+                break;
+            }
+        }
+    }
+}
+
+static void gfx_dos_swap_buffers_modex(void) {
+    const uint8_t *in = (const uint8_t *) GFX_BUFFER;
+
+    gfx_dos_present_update();
+
+    outportb(REG_SELECT, REG_MASK);
+    // one plane holds every fourth pixel, so go through the tiles once per plane
+    for (unsigned plane = 0; plane < 4; ++plane) {
+        outportb(REG_VALUE, 1 << plane);
+        for (unsigned t = 0; t < GFX_SOFT_TILES; t++) {
+            if (tile_frame[t] <= page_frame[page])
+                continue;
+            const uint8_t *inp = in + (t / GFX_SOFT_TILES_X) * TILE_SIZE * SCREEN_WIDTH + (t % GFX_SOFT_TILES_X) * TILE_SIZE + plane;
+            uint8_t *outp = ptrscreen + (t / GFX_SOFT_TILES_X) * TILE_SIZE * (SCREEN_WIDTH / 4) + (t % GFX_SOFT_TILES_X) * (TILE_SIZE / 4);
+            for (unsigned y = 0; y < TILE_SIZE; ++y, inp += SCREEN_WIDTH, outp += SCREEN_WIDTH / 4) {
+                for (unsigned x = 0; x < TILE_SIZE / 4; ++x)
+                    outp[x] = inp[x << 2];
+            }
+            gfx_dos_vram_bytes += TILE_SIZE * TILE_SIZE / 4;
+        }
+    }
+
+    page_frame[page] = present_frame;
+
+    outportw(CRTC_INDEX, ((int)(ptrscreen - __djgpp_conventional_base) & 0xff00) + 0xC);
+
+    page++;
+
+    if (page == 3){
+        ptrscreen -= 0x4B00 * 2;
+        page = 0;
+    }else{
+        ptrscreen += 0x4B00;
+    }
+}
+
+static void gfx_dos_swap_buffers_vesa_lfb_tiles(void) {
+    const uint8_t *in = (const uint8_t *) GFX_BUFFER;
+    const uint32_t inPitch = SCREEN_WIDTH * present_bpp;
+    const uint32_t outPitch = SCREEN_WIDTH * screen_scale * screen_bpp;
+    const uint32_t outRowBytes = TILE_SIZE * screen_scale * screen_bpp;
+
+    gfx_dos_present_update();
+
+    for (unsigned t = 0; t < GFX_SOFT_TILES; t++) {
+        if (tile_frame[t] <= page_frame[0])
+            continue;
+        const uint8_t *inp = in + (t / GFX_SOFT_TILES_X) * TILE_SIZE * inPitch + (t % GFX_SOFT_TILES_X) * TILE_SIZE * present_bpp;
+        uint8_t *vram = ptrscreen + (t / GFX_SOFT_TILES_X) * TILE_SIZE * screen_scale * outPitch + (t % GFX_SOFT_TILES_X) * outRowBytes;
+        for (unsigned y = 0; y < TILE_SIZE; y++, inp += inPitch) {
+            // doubled rows are written twice, reading them back from VRAM would be slower
+            for (unsigned i = 0; i < screen_scale; i++, vram += outPitch)
+                present_row(inp, vram);
+        }
+        gfx_dos_vram_bytes += outRowBytes * TILE_SIZE * screen_scale;
+    }
+
+    page_frame[0] = present_frame;
+}
+#endif
+
 static void gfx_dos_swap_buffers_vesa_lfb_24_native(void) {
 
     uint8_t *inp = GFX_BUFFER;
@@ -439,6 +645,9 @@ static void gfx_dos_init_impl(void) {
             ptrscreen = VGA_BASE + __djgpp_conventional_base;
 
             backbuffer_function = gfx_dos_swap_buffers_modex;
+#ifndef ENABLE_OSMESA
+            gfx_dos_present_init(configOptimizedPalette ? GFX_SOFT_FMT_PAL8 : GFX_SOFT_FMT_RGB332, 1, NULL);
+#endif
 
             break;
 
@@ -458,6 +667,7 @@ static void gfx_dos_init_impl(void) {
 
             ptrscreen = (uint8_t *) (screen_base_addr + screen->line[0] - __djgpp_base_address);
 
+#ifdef ENABLE_OSMESA
             if (configDoubleResolution){
                 numLoops = configScreenWidth * configScreenHeight;
                 backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_8_native;
@@ -465,6 +675,11 @@ static void gfx_dos_init_impl(void) {
                 numLoops = (configScreenWidth * configScreenHeight) / 2;
                 backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_8;
             }
+#else
+            gfx_dos_present_init(configOptimizedPalette ? GFX_SOFT_FMT_PAL8 : GFX_SOFT_FMT_RGB332, 1,
+                                 configDoubleResolution ? present_row_double_8 : present_row_copy_8);
+            backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_tiles;
+#endif
 
             break;
 
@@ -484,6 +699,7 @@ static void gfx_dos_init_impl(void) {
 
             ptrscreen = (uint8_t *) (screen_base_addr + screen->line[0] - __djgpp_base_address);
 
+#ifdef ENABLE_OSMESA
             if (configDoubleResolution){
                 numLoops = configScreenWidth * configScreenHeight;
                 backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_15_native;
@@ -491,6 +707,10 @@ static void gfx_dos_init_impl(void) {
                 numLoops = (configScreenWidth * configScreenHeight) / 2;
                 backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_15;
             }
+#else
+            gfx_dos_present_init(GFX_SOFT_FMT_RGB555, 2, configDoubleResolution ? present_row_double_16 : present_row_copy_16);
+            backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_tiles;
+#endif
 
             break;
 
@@ -510,6 +730,7 @@ static void gfx_dos_init_impl(void) {
 
             ptrscreen = (uint8_t *) (screen_base_addr + screen->line[0] - __djgpp_base_address);
 
+#ifdef ENABLE_OSMESA
             if (configDoubleResolution){
                 numLoops = configScreenWidth * configScreenHeight;
                 backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_16_native;
@@ -517,6 +738,10 @@ static void gfx_dos_init_impl(void) {
                 numLoops = (configScreenWidth * configScreenHeight) / 2;
                 backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_16;
             }
+#else
+            gfx_dos_present_init(GFX_SOFT_FMT_RGB565, 2, configDoubleResolution ? present_row_double_16 : present_row_copy_16);
+            backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_tiles;
+#endif
 
             break;
 
@@ -536,6 +761,7 @@ static void gfx_dos_init_impl(void) {
 
             ptrscreen = (uint8_t *) (screen_base_addr + screen->line[0] - __djgpp_base_address);
 
+#ifdef ENABLE_OSMESA
             if (configDoubleResolution){
                 numLoops = configScreenWidth * configScreenHeight;
                 backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_24_native;
@@ -543,6 +769,10 @@ static void gfx_dos_init_impl(void) {
                 numLoops = configScreenWidth * configScreenHeight;
                 backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_24;
             }
+#else
+            gfx_dos_present_init(GFX_SOFT_FMT_RGBA32, 3, configDoubleResolution ? present_row_double_24 : present_row_24);
+            backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_tiles;
+#endif
 
             break;
 
@@ -563,6 +793,7 @@ static void gfx_dos_init_impl(void) {
             ptrscreen = (uint8_t *) (screen_base_addr + screen->line[0] - __djgpp_base_address);
 
 
+#ifdef ENABLE_OSMESA
             if (configDoubleResolution){
                 numLoops = configScreenWidth * configScreenHeight;
                 backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_32_native;
@@ -570,6 +801,10 @@ static void gfx_dos_init_impl(void) {
                 numLoops = configScreenWidth * configScreenHeight;
                 backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_32;
             }
+#else
+            gfx_dos_present_init(GFX_SOFT_FMT_RGBA32, 4, configDoubleResolution ? present_row_double_32 : present_row_32);
+            backbuffer_function = gfx_dos_swap_buffers_vesa_lfb_tiles;
+#endif
 
             break;
 
@@ -633,6 +868,13 @@ static void gfx_dos_init_impl(void) {
         abort();
     }
     OSMesaPixelStore(OSMESA_Y_UP, GL_FALSE);
+
+    // OSMesa can't tell what changed, so every present writes the whole screen
+    if (configVideomode == VM_X) {
+        gfx_dos_vram_bytes = SCREEN_WIDTH * SCREEN_HEIGHT_240;
+    } else if (configVideomode != VM_HERCULES) {
+        gfx_dos_vram_bytes = SCREEN_W * SCREEN_H * ((bitmap_color_depth(screen) + 7) / 8);
+    }
 #endif
 }
 
@@ -641,6 +883,9 @@ static void gfx_dos_shutdown_impl(void) {
     OSMesaDestroyContext(ctx);
     free(osmesa_buffer);
     osmesa_buffer = NULL;
+#else
+    free(present_shadow);
+    present_shadow = NULL;
 #endif
     // go back to default text mode
     set_gfx_mode(GFX_TEXT, 0, 0, 0, 0);
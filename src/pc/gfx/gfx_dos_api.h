@@ -4,6 +4,7 @@
 #include "gfx_window_manager_api.h"
 
 extern struct GfxWindowManagerAPI gfx_dos_api;
+extern uint32_t gfx_dos_vram_bytes;
 
 #define VM_X 1
 #define VM_VESA_LFB_8 2
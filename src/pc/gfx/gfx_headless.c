@@ -0,0 +1,201 @@
+#ifdef HEADLESS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "macros.h"
+#include "gfx_headless.h"
+#include "gfx_cc.h"
+#include "../benchmark.h"
+#include "../configfile.h"
+
+// Window manager without a window, which runs the replay benchmark
+
+static void gfx_headless_init(UNUSED const char *game_name, UNUSED bool start_in_fullscreen) {
+}
+
+static void gfx_headless_set_keyboard_callbacks(UNUSED bool (*on_key_down)(int scancode),
+                                                UNUSED bool (*on_key_up)(int scancode),
+                                                UNUSED void (*on_all_keys_up)(void)) {
+}
+
+static void gfx_headless_set_fullscreen_changed_callback(
+    UNUSED void (*on_fullscreen_changed)(bool is_now_fullscreen)) {
+}
+
+static void gfx_headless_set_fullscreen(UNUSED bool enable) {
+}
+
+static void gfx_headless_main_loop(void (*run_one_game_iter)(void)) {
+    benchmark_run_frame(run_one_game_iter);
+}
+
+static void gfx_headless_get_dimensions(uint32_t *width, uint32_t *height) {
+    *width = configScreenWidth;
+    *height = configScreenHeight;
+}
+
+static void gfx_headless_handle_events(void) {
+}
+
+static bool gfx_headless_start_frame(void) {
+    return true;
+}
+
+static void gfx_headless_swap_buffers_begin(void) {
+}
+
+static void gfx_headless_swap_buffers_end(void) {
+}
+
+static double gfx_headless_get_time(void) {
+    return 0.0;
+}
+
+static void gfx_headless_shutdown(void) {
+}
+
+struct GfxWindowManagerAPI gfx_headless_api = { gfx_headless_init,
+                                                gfx_headless_set_keyboard_callbacks,
+                                                gfx_headless_set_fullscreen_changed_callback,
+                                                gfx_headless_set_fullscreen,
+                                                gfx_headless_main_loop,
+                                                gfx_headless_get_dimensions,
+                                                gfx_headless_handle_events,
+                                                gfx_headless_start_frame,
+                                                gfx_headless_swap_buffers_begin,
+                                                gfx_headless_swap_buffers_end,
+                                                gfx_headless_get_time,
+                                                gfx_headless_shutdown };
+
+// Rendering API that draws nothing, so that gfx_pc.c can be timed on its own
+
+struct ShaderProgram {
+    uint32_t shader_id;
+    struct CCFeatures cc;
+};
+
+static struct ShaderProgram shader_program_pool[64];
+static uint8_t shader_program_pool_size;
+static uint32_t tex_num;
+
+static bool gfx_null_z_is_from_0_to_1(void) {
+    return false;
+}
+
+static void gfx_null_unload_shader(UNUSED struct ShaderProgram *old_prg) {
+}
+
+static void gfx_null_load_shader(UNUSED struct ShaderProgram *new_prg) {
+}
+
+static struct ShaderProgram *gfx_null_create_and_load_new_shader(uint32_t shader_id) {
+    if (shader_program_pool_size == sizeof(shader_program_pool) / sizeof(shader_program_pool[0])) {
+        printf("gfx_null: out of shader slots\n");
+        abort();
+    }
+
+    struct ShaderProgram *prg = &shader_program_pool[shader_program_pool_size++];
+    prg->shader_id = shader_id;
+    gfx_cc_get_features(shader_id, &prg->cc);
+    return prg;
+}
+
+static struct ShaderProgram *gfx_null_lookup_shader(uint32_t shader_id) {
+    for (size_t i = 0; i < shader_program_pool_size; i++)
+        if (shader_program_pool[i].shader_id == shader_id)
+            return &shader_program_pool[i];
+    return NULL;
+}
+
+static void gfx_null_shader_get_info(struct ShaderProgram *prg, uint8_t *num_inputs, bool used_textures[2]) {
+    *num_inputs = prg->cc.num_inputs;
+    used_textures[0] = prg->cc.used_textures[0];
+    used_textures[1] = prg->cc.used_textures[1];
+}
+
+static uint32_t gfx_null_new_texture(void) {
+    return tex_num++;
+}
+
+static void gfx_null_select_texture(UNUSED int tile, UNUSED uint32_t texture_id) {
+}
+
+static void gfx_null_upload_texture(UNUSED const uint8_t *rgba32_buf, UNUSED int width, UNUSED int height) {
+}
+
+static void gfx_null_set_sampler_parameters(UNUSED int tile, UNUSED bool linear_filter, UNUSED uint32_t cms,
+                                            UNUSED uint32_t cmt) {
+}
+
+static void gfx_null_set_depth_test(UNUSED bool depth_test) {
+}
+
+static void gfx_null_set_depth_mask(UNUSED bool z_upd) {
+}
+
+static void gfx_null_set_zmode_decal(UNUSED bool zmode_decal) {
+}
+
+static void gfx_null_set_viewport(UNUSED int x, UNUSED int y, UNUSED int width, UNUSED int height) {
+}
+
+static void gfx_null_set_scissor(UNUSED int x, UNUSED int y, UNUSED int width, UNUSED int height) {
+}
+
+static void gfx_null_set_use_alpha(UNUSED bool use_alpha) {
+}
+
+static void gfx_null_draw_triangles(UNUSED float buf_vbo[], UNUSED size_t buf_vbo_len,
+                                    UNUSED size_t buf_vbo_num_tris) {
+}
+
+static void gfx_null_init(void) {
+}
+
+static void gfx_null_on_resize(void) {
+}
+
+static void gfx_null_start_frame(void) {
+}
+
+static void gfx_null_end_frame(void) {
+}
+
+static void gfx_null_finish_render(void) {
+}
+
+struct GfxRenderingAPI gfx_null_api = {
+    gfx_null_z_is_from_0_to_1,
+    gfx_null_unload_shader,
+    gfx_null_load_shader,
+    gfx_null_create_and_load_new_shader,
+    gfx_null_lookup_shader,
+    gfx_null_shader_get_info,
+    gfx_null_new_texture,
+    gfx_null_select_texture,
+    gfx_null_upload_texture,
+    gfx_null_set_sampler_parameters,
+    gfx_null_set_depth_test,
+    gfx_null_set_depth_mask,
+    gfx_null_set_zmode_decal,
+    gfx_null_set_viewport,
+    gfx_null_set_scissor,
+    gfx_null_set_use_alpha,
+    gfx_null_draw_triangles,
+    gfx_null_init,
+    gfx_null_on_resize,
+    gfx_null_start_frame,
+    gfx_null_end_frame,
+    gfx_null_finish_render,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+};
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef GFX_HEADLESS_H
+#define GFX_HEADLESS_H
+
+#include "gfx_window_manager_api.h"
+#include "gfx_rendering_api.h"
+
+extern struct GfxWindowManagerAPI gfx_headless_api;
+extern struct GfxRenderingAPI gfx_null_api;
+
+#endif
@@ -540,6 +540,8 @@ struct GfxRenderingAPI gfx_opengl_api = {
     NULL,
     NULL,
     NULL,
+    NULL,
+    NULL,
     NULL
 };
 
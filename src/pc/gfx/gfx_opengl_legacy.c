@@ -2,6 +2,9 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #ifndef _LANGUAGE_C
@@ -26,9 +29,6 @@
 # include <SDL2/SDL.h>
 # include <SDL2/SDL_opengl.h>
 #else
-# include <stdio.h>
-# include <string.h>
-# include <stdlib.h>
 # include <GL/gl.h>
 # include <GL/glext.h>
 #endif
@@ -46,6 +46,10 @@
 typedef void (*PFNMGLFOGCOORDPOINTERPROC)(GLenum type, GLsizei stride, const void *pointer);
 static PFNMGLFOGCOORDPOINTERPROC mglFogCoordPointer = NULL;
 
+typedef void (APIENTRY *PFNMGLACTIVETEXTUREPROC)(GLenum texture);
+static PFNMGLACTIVETEXTUREPROC mglActiveTexture = NULL;
+static PFNMGLACTIVETEXTUREPROC mglClientActiveTexture = NULL;
+
 // since these can have different names, might as well redefine them to a single one
 #undef GL_FOG_COORD_SRC
 #undef GL_FOG_COORD
@@ -55,7 +59,9 @@ static PFNMGLFOGCOORDPOINTERPROC mglFogCoordPointer = NULL;
 #define GL_FOG_COORD_ARRAY 0x8457
 
 #include "gfx_cc.h"
+#include "gfx_pc.h"
 #include "macros.h"
+#include "pc/configfile.h"
 
 enum MixType {
     SH_MT_NONE,
@@ -81,14 +87,51 @@ struct SamplerState {
     GLenum mag_filter;
     GLenum wrap_s;
     GLenum wrap_t;
-    GLuint tex;
+    struct GLTexture *tex;
+};
+
+// Textures keep a copy of their pixels, so the GL objects can be dropped when the
+// budget runs out and small ones can share atlas pages. Either is made on first use.
+struct GLTexture {
+    GLuint id; // standalone texture object, 0 while not resident
+    int8_t page; // atlas page, -1 if not in one
+    uint16_t x, y; // position in the page, inside the border
+    uint16_t w, h;
+    uint32_t used; // frame last drawn with
+    uint32_t bytes; // size of the standalone object
+    uint32_t *pixels;
+    GLenum applied[3]; // filter and wraps last set on the object
 };
 
+struct AtlasPage {
+    GLuint id;
+    uint32_t used;
+    uint16_t shelf_x, shelf_y, shelf_h;
+    GLenum filter;
+};
+
+#define MAX_TEXTURES 1024
+
+// 256 is as big as a Voodoo can go, textures up to 32x32 go into pages
+#define ATLAS_PAGE_SIZE 256
+#define ATLAS_MAX_TEX 32
+#define ATLAS_MAX_PAGES 4
+#define ATLAS_PAGE_BYTES (ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * 4)
+
 static struct ShaderProgram shader_program_pool[64];
 static uint8_t shader_program_pool_size;
 static struct ShaderProgram *cur_shader = NULL;
 
 static struct SamplerState tmu_state[2];
+static bool tmu_atlas[2]; // tile is drawn from its atlas page
+
+static struct GLTexture textures[MAX_TEXTURES];
+static uint32_t num_textures;
+static struct GLTexture *upload_tex;
+static struct AtlasPage atlas_pages[ATLAS_MAX_PAGES];
+static int num_atlas_pages;
+static uint32_t own_bytes; // resident standalone textures
+static uint32_t frame_num = 1;
 
 static const float *cur_buf = NULL;
 static const float *cur_fog_ofs = NULL;
@@ -99,6 +142,19 @@ static bool gl_blend = false;
 
 static bool gl_npot = false;
 static bool gl_multitexture = false;
+static bool gl_combine = false;
+static int gl_units = 1;
+
+// what the texture units past the first one are set up for
+enum UnitRole {
+    UNIT_OFF,
+    UNIT_MIX, // mix(previous, texture, constant), the second texture of SH_MT_TEXTURE_TEXTURE
+    UNIT_FOG, // mix(previous, constant, texture alpha), with the fog factor as texcoord into a ramp
+};
+
+static uint8_t unit_role[3];
+static int units_on = 1; // units enabled for the current batch
+static GLuint fog_ramp;
 
 static float c_mix[] = { 0.f, 0.f, 0.f, 1.f };
 static float c_invmix[] = { 1.f, 1.f, 1.f, 1.f };
@@ -106,7 +162,8 @@ static const float c_white[] = { 1.f, 1.f, 1.f, 1.f };
 
 // from https://github.com/z2442/sm64-port
 
-static uint32_t scaled[64 * 64];
+static uint32_t *scaled;
+static size_t scaled_size;
 
 static void resample_32bit(const uint32_t *in, const int inwidth, const int inheight, uint32_t *out, const int outwidth, const int outheight) {
   int i, j;
@@ -330,31 +387,205 @@ static void gfx_opengl_shader_get_info(struct ShaderProgram *prg, uint8_t *num_i
     used_textures[1] = prg->texture_used[1];
 }
 
-static GLuint gfx_opengl_new_texture(void) {
-    GLuint ret;
-    glGenTextures(1, &ret);
-    return ret;
+static uint32_t gfx_opengl_new_texture(void) {
+    if (num_textures == MAX_TEXTURES) {
+        fprintf(stderr, "gfx_opengl_new_texture: out of texture slots\n");
+        abort();
+    }
+    struct GLTexture *tex = &textures[num_textures];
+    tex->page = -1;
+    return num_textures++;
+}
+
+static void gfx_opengl_select_texture(int tile, uint32_t texture_id) {
+    // bound when drawing, once it is known whether the atlas can be used
+    tmu_state[tile].tex = &textures[texture_id];
+    tmu_atlas[tile] = false;
+    upload_tex = tmu_state[tile].tex;
 }
 
-static void gfx_opengl_select_texture(int tile, GLuint texture_id) {
-    tmu_state[tile].tex = texture_id; // remember this for multitexturing later
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+static inline void gfx_opengl_count_upload(const uint32_t bytes) {
+    gfx_frame_stats.uploads++;
+    gfx_frame_stats.upload_bytes += bytes;
+    gfx_frame_stats.resident_bytes = own_bytes + num_atlas_pages * ATLAS_PAGE_BYTES;
 }
 
 static void gfx_opengl_upload_texture(const uint8_t *rgba32_buf, int width, int height) {
+    struct GLTexture *tex = upload_tex;
+    const size_t size = width * height * 4;
+
+    // the pool in gfx_pc reuses slots, so whatever was there before is gone
+    if (tex->id) {
+        glDeleteTextures(1, &tex->id);
+        tex->id = 0;
+        own_bytes -= tex->bytes;
+    }
+    tex->page = -1; // its space in the page is only reclaimed with the page
+
+    if (!tex->pixels || tex->w * tex->h != width * height) {
+        free(tex->pixels);
+        tex->pixels = malloc(size);
+    }
+    memcpy(tex->pixels, rgba32_buf, size);
+    tex->w = width;
+    tex->h = height;
+}
+
+// drops textures that haven't been drawn with for the longest time until the budget is met.
+// the textures of both tiles are kept, the draw in progress may have one bound already.
+static void gfx_opengl_evict_textures(void) {
+    const uint32_t budget = configTextureBudget * 1024;
+    while (budget && own_bytes + num_atlas_pages * ATLAS_PAGE_BYTES > budget) {
+        struct GLTexture *lru = NULL;
+        for (uint32_t i = 0; i < num_textures; i++) {
+            struct GLTexture *tex = &textures[i];
+            if (tex->id && tex != tmu_state[0].tex && tex != tmu_state[1].tex && (!lru || tex->used < lru->used))
+                lru = tex;
+        }
+        if (!lru) break;
+        glDeleteTextures(1, &lru->id);
+        lru->id = 0;
+        own_bytes -= lru->bytes;
+        gfx_frame_stats.evictions++;
+    }
+}
+
+static void gfx_opengl_bind_own(struct GLTexture *tex) {
+    if (tex->id) {
+        glBindTexture(GL_TEXTURE_2D, tex->id);
+        return;
+    }
+
+    const uint8_t *buf = (const uint8_t *)tex->pixels;
+    int width = tex->w;
+    int height = tex->h;
+
     if (!gl_npot) {
         // we don't support non power of two textures, scale to next power of two if necessary
         if (!is_pot(width) || !is_pot(height)) {
             const int pwidth = next_pot(width);
             const int pheight = next_pot(height);
-            resample_32bit((const uint32_t *)rgba32_buf, width, height, scaled, pwidth, pheight);
-            rgba32_buf = (const uint8_t *)scaled;
+            if (scaled_size < (size_t)pwidth * pheight) {
+                scaled_size = (size_t)pwidth * pheight;
+                scaled = realloc(scaled, scaled_size * 4);
+            }
+            resample_32bit(tex->pixels, width, height, scaled, pwidth, pheight);
+            buf = (const uint8_t *)scaled;
             width = pwidth;
             height = pheight;
         }
     }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba32_buf);
+    glGenTextures(1, &tex->id);
+    glBindTexture(GL_TEXTURE_2D, tex->id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, buf);
+    tex->applied[0] = tex->applied[1] = tex->applied[2] = 0;
+    tex->bytes = width * height * 4;
+    own_bytes += tex->bytes;
+    gfx_opengl_count_upload(tex->bytes);
+    gfx_opengl_evict_textures();
+}
+
+// textures are put next to each other in rows as tall as the tallest one in them
+static inline bool atlas_alloc(struct AtlasPage *page, const int w, const int h, uint16_t *x, uint16_t *y) {
+    int sx = page->shelf_x, sy = page->shelf_y, sh = page->shelf_h;
+    if (sx + w > ATLAS_PAGE_SIZE) {
+        sy += sh;
+        sx = 0;
+        sh = 0;
+    }
+    if (sy + h > ATLAS_PAGE_SIZE)
+        return false;
+    *x = sx;
+    *y = sy;
+    page->shelf_x = sx + w;
+    page->shelf_y = sy;
+    page->shelf_h = (h > sh) ? h : sh;
+    return true;
+}
+
+// empties the page least recently drawn from, unless it was already used this frame
+static int gfx_opengl_recycle_page(void) {
+    int lru = 0;
+    for (int i = 1; i < num_atlas_pages; i++)
+        if (atlas_pages[i].used < atlas_pages[lru].used)
+            lru = i;
+    if (atlas_pages[lru].used == frame_num)
+        return -1;
+
+    for (uint32_t i = 0; i < num_textures; i++)
+        if (textures[i].page == lru)
+            textures[i].page = -1;
+
+    atlas_pages[lru].shelf_x = atlas_pages[lru].shelf_y = atlas_pages[lru].shelf_h = 0;
+    gfx_frame_stats.evictions++;
+    return lru;
+}
+
+static bool gfx_opengl_place_in_atlas(struct GLTexture *tex) {
+    // one texel of border around each texture, so filtering doesn't pick up the neighbours
+    static uint32_t bordered[(ATLAS_MAX_TEX + 2) * (ATLAS_MAX_TEX + 2)];
+    const int bw = tex->w + 2, bh = tex->h + 2;
+    uint16_t x, y;
+    int p;
+
+    for (p = 0; p < num_atlas_pages; p++)
+        if (atlas_alloc(&atlas_pages[p], bw, bh, &x, &y))
+            break;
+
+    if (p == num_atlas_pages) {
+        if (num_atlas_pages < ATLAS_MAX_PAGES) {
+            struct AtlasPage *page = &atlas_pages[num_atlas_pages++];
+            glGenTextures(1, &page->id);
+            glBindTexture(GL_TEXTURE_2D, page->id);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            page->filter = 0;
+            gfx_opengl_evict_textures();
+        } else if ((p = gfx_opengl_recycle_page()) < 0) {
+            return false;
+        }
+        if (!atlas_alloc(&atlas_pages[p], bw, bh, &x, &y))
+            return false;
+    }
+
+    for (int j = 0; j < bh; j++) {
+        const int sy = (j == 0) ? 0 : (j > tex->h) ? tex->h - 1 : j - 1;
+        const uint32_t *src = tex->pixels + sy * tex->w;
+        uint32_t *dst = bordered + j * bw;
+        dst[0] = src[0];
+        memcpy(dst + 1, src, tex->w * 4);
+        dst[bw - 1] = src[tex->w - 1];
+    }
+
+    glBindTexture(GL_TEXTURE_2D, atlas_pages[p].id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, bw, bh, GL_RGBA, GL_UNSIGNED_BYTE, bordered);
+    gfx_opengl_count_upload(bw * bh * 4);
+
+    tex->page = p;
+    tex->x = x + 1;
+    tex->y = y + 1;
+    return true;
+}
+
+static bool gfx_opengl_bind_atlas(int tile, bool allow, float rect[4]) {
+    struct GLTexture *tex = tmu_state[tile].tex;
+
+    tmu_atlas[tile] = false;
+    if (!allow || !configTextureAtlas || tex->w > ATLAS_MAX_TEX || tex->h > ATLAS_MAX_TEX)
+        return false;
+    if (tex->page < 0 && !gfx_opengl_place_in_atlas(tex))
+        return false;
+
+    tex->used = frame_num;
+    atlas_pages[tex->page].used = frame_num;
+    rect[0] = (float)tex->x / ATLAS_PAGE_SIZE;
+    rect[1] = (float)tex->y / ATLAS_PAGE_SIZE;
+    rect[2] = (float)tex->w / ATLAS_PAGE_SIZE;
+    rect[3] = (float)tex->h / ATLAS_PAGE_SIZE;
+    tmu_atlas[tile] = true;
+    return true;
 }
 
 static inline GLenum gfx_cm_to_opengl(uint32_t val) {
@@ -362,26 +593,48 @@ static inline GLenum gfx_cm_to_opengl(uint32_t val) {
     return (val & G_TX_MIRROR) ? GL_MIRRORED_REPEAT : GL_REPEAT;
 }
 
-static inline void gfx_opengl_apply_tmu_state(const int tile) {
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, tmu_state[tile].min_filter);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, tmu_state[tile].mag_filter);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, tmu_state[tile].wrap_s);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, tmu_state[tile].wrap_t);
+// binds the texture of a tile with its sampler state, skipping what is already set on the object
+static void gfx_opengl_bind_tile(const int tile) {
+    const struct SamplerState *ss = &tmu_state[tile];
+    struct GLTexture *tex = ss->tex;
+
+    tex->used = frame_num;
+
+    if (tmu_atlas[tile]) {
+        struct AtlasPage *page = &atlas_pages[tex->page];
+        page->used = frame_num;
+        glBindTexture(GL_TEXTURE_2D, page->id);
+        if (page->filter != ss->min_filter) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, ss->min_filter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, ss->mag_filter);
+            page->filter = ss->min_filter;
+        }
+        return;
+    }
+
+    gfx_opengl_bind_own(tex);
+    if (tex->applied[0] != ss->min_filter) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, ss->min_filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, ss->mag_filter);
+        tex->applied[0] = ss->min_filter;
+    }
+    if (tex->applied[1] != ss->wrap_s) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, ss->wrap_s);
+        tex->applied[1] = ss->wrap_s;
+    }
+    if (tex->applied[2] != ss->wrap_t) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, ss->wrap_t);
+        tex->applied[2] = ss->wrap_t;
+    }
 }
 
 static void gfx_opengl_set_sampler_parameters(int tile, bool linear_filter, uint32_t cms, uint32_t cmt) {
     const GLenum filter = linear_filter ? GL_LINEAR : GL_NEAREST;
 
-    const GLenum wrap_s = gfx_cm_to_opengl(cms);
-    const GLenum wrap_t = gfx_cm_to_opengl(cmt);
-
     tmu_state[tile].min_filter = filter;
     tmu_state[tile].mag_filter = filter;
-    tmu_state[tile].wrap_s = wrap_s;
-    tmu_state[tile].wrap_t = wrap_t;
-
-    // set state for the first texture right away
-    if (!tile) gfx_opengl_apply_tmu_state(tile);
+    tmu_state[tile].wrap_s = gfx_cm_to_opengl(cms);
+    tmu_state[tile].wrap_t = gfx_cm_to_opengl(cmt);
 }
 
 static void gfx_opengl_set_depth_test(bool depth_test) {
@@ -449,8 +702,7 @@ static inline void gfx_opengl_pass_fog(void) {
 // result = mix(tex0.rgb, tex1.rgb, vertex.rgb)
 static inline void gfx_opengl_pass_mix_texture(void) {
     // set second texture
-    glBindTexture(GL_TEXTURE_2D, tmu_state[cur_shader->texture_ord[1]].tex);
-    gfx_opengl_apply_tmu_state(cur_shader->texture_ord[1]);
+    gfx_opengl_bind_tile(cur_shader->texture_ord[1]);
 
     if (!gl_blend) glEnable(GL_BLEND); // enable blending temporarily
     glBlendFunc(GL_ONE, GL_ONE); // additive blending
@@ -464,10 +716,78 @@ static inline void gfx_opengl_pass_mix_texture(void) {
     glDepthFunc(GL_LESS); // set back to default
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // same here
     if (!gl_blend) glDisable(GL_BLEND); // disable blending if it was disabled
+}
+
+static void gfx_opengl_set_unit_role(const int unit, const enum UnitRole role) {
+    mglActiveTexture(GL_TEXTURE0 + unit);
+    mglClientActiveTexture(GL_TEXTURE0 + unit);
+
+    if (role == UNIT_OFF) {
+        glDisable(GL_TEXTURE_2D);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    } else {
+        glEnable(GL_TEXTURE_2D);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    }
+
+    if (role != unit_role[unit] && role != UNIT_OFF) {
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+        glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_INTERPOLATE);
+        glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_RGB, (role == UNIT_MIX) ? GL_PREVIOUS : GL_CONSTANT);
+        glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE1_RGB, (role == UNIT_MIX) ? GL_TEXTURE : GL_PREVIOUS);
+        glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE2_RGB, (role == UNIT_MIX) ? GL_CONSTANT : GL_TEXTURE);
+        glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND2_RGB, (role == UNIT_MIX) ? GL_SRC_COLOR : GL_SRC_ALPHA);
+        glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_REPLACE);
+        glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_ALPHA, GL_PREVIOUS);
+        unit_role[unit] = role;
+    }
+}
+
+// Does the mix and/or fog pass in extra texture units instead of drawing everything again.
+// Returns which of the passes are left to do: bit 0 for the mix, bit 1 for fog.
+static int gfx_opengl_setup_units(void) {
+    const bool mix = cur_shader->texture_used[0] && cur_shader->texture_used[1];
+    const bool fog = cur_fog_ofs != NULL;
+    int left = (mix ? 1 : 0) | (fog ? 2 : 0);
+
+    if (!left || !gl_combine)
+        return left;
+
+    int unit = 1;
+
+    // the additive second pass only matches the combiner with the vertex color hack in apply_shader
+    if (mix) {
+        if (!cur_shader->cc.do_mix[0] || gl_units < 2)
+            return left; // fog has to be drawn over both passes then
+        gfx_opengl_set_unit_role(unit, UNIT_MIX);
+        gfx_opengl_bind_tile(cur_shader->texture_ord[1]);
+        glTexEnvfv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_COLOR, c_mix);
+        glTexCoordPointer(2, GL_FLOAT, cur_buf_stride, cur_buf + 4);
+        glColor3f(1.f, 1.f, 1.f); // the first unit gives the plain texel then
+        left &= ~1;
+        units_on = ++unit;
+    }
+
+    if (fog && unit < gl_units) {
+        gfx_opengl_set_unit_role(unit, UNIT_FOG);
+        glBindTexture(GL_TEXTURE_2D, fog_ramp);
+        glTexEnvfv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_COLOR, cur_fog_ofs); // same for every vertex
+        glTexCoordPointer(1, GL_FLOAT, cur_buf_stride, cur_fog_ofs + 3);
+        left &= ~2;
+        units_on = ++unit;
+    }
 
-    // set old texture
-    glBindTexture(GL_TEXTURE_2D, tmu_state[cur_shader->texture_ord[0]].tex);
-    gfx_opengl_apply_tmu_state(cur_shader->texture_ord[0]);
+    mglActiveTexture(GL_TEXTURE0);
+    mglClientActiveTexture(GL_TEXTURE0);
+    return left;
+}
+
+static void gfx_opengl_reset_units(void) {
+    for (int unit = 1; unit < units_on; unit++)
+        gfx_opengl_set_unit_role(unit, UNIT_OFF);
+    mglActiveTexture(GL_TEXTURE0);
+    mglClientActiveTexture(GL_TEXTURE0);
+    units_on = 1;
 }
 
 static void gfx_opengl_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
@@ -479,16 +799,29 @@ static void gfx_opengl_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_
     gfx_opengl_apply_shader(cur_shader);
 
     // if there's two textures, set primary texture first
-    if (cur_shader->texture_used[1])
-        glBindTexture(GL_TEXTURE_2D, tmu_state[cur_shader->texture_ord[0]].tex);
+    if (cur_shader->texture_used[0])
+        gfx_opengl_bind_tile(cur_shader->texture_ord[0]);
+    else if (cur_shader->texture_used[1])
+        gfx_opengl_bind_tile(1);
+
+    const int left = gfx_opengl_setup_units();
 
     glDrawArrays(GL_TRIANGLES, 0, 3 * cur_buf_num_tris);
 
+    if (units_on > 1)
+        gfx_opengl_reset_units();
+
     // if there's two textures, draw polys with the second texture
-    if (cur_shader->texture_used[1]) gfx_opengl_pass_mix_texture();
+    if (left & 1) {
+        gfx_opengl_pass_mix_texture();
+        gfx_frame_stats.passes++;
+    }
 
     // cur_fog_ofs is only set if GL_EXT_fog_coord isn't used
-    if (cur_fog_ofs) gfx_opengl_pass_fog();
+    if (left & 2) {
+        gfx_opengl_pass_fog();
+        gfx_frame_stats.passes++;
+    }
 }
 
 static inline bool gl_check_ext(const char *name) {
@@ -547,6 +880,35 @@ static void gfx_opengl_init(void) {
     // check if we support multitexturing
     gl_multitexture = vmajor > 1 || vminor > 3 || gl_check_ext("GL_ARB_multitexture");
 
+    // with a combiner in the extra units, the second texture and fog don't need passes of their own
+    if (gl_multitexture) {
+#ifdef TARGET_DOS
+        mglActiveTexture = glActiveTextureARB;
+        mglClientActiveTexture = glClientActiveTextureARB;
+#else
+        mglActiveTexture = (PFNMGLACTIVETEXTUREPROC)mglGetProcAddress("glActiveTextureARB");
+        mglClientActiveTexture = (PFNMGLACTIVETEXTUREPROC)mglGetProcAddress("glClientActiveTextureARB");
+#endif
+        glGetIntegerv(GL_MAX_TEXTURE_UNITS, &gl_units);
+        gl_combine = mglActiveTexture && mglClientActiveTexture && gl_units > 1
+            && (vmajor > 1 || vminor > 2 || gl_check_ext("GL_ARB_texture_env_combine") || gl_check_ext("GL_EXT_texture_env_combine"));
+    }
+
+    if (gl_combine) {
+        uint8_t ramp[256 * 4];
+        for (int i = 0; i < 256; i++) {
+            ramp[i * 4 + 0] = ramp[i * 4 + 1] = ramp[i * 4 + 2] = 0xFF;
+            ramp[i * 4 + 3] = i;
+        }
+        glGenTextures(1, &fog_ramp);
+        glBindTexture(GL_TEXTURE_2D, fog_ramp);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, ramp);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
    // printf("GL_VERSION = %s\n", glGetString(GL_VERSION));
    // printf("GL_EXTENSIONS =\n%s\n", glGetString(GL_EXTENSIONS));
 
@@ -562,6 +924,10 @@ static void gfx_opengl_init(void) {
 }
 
 static void gfx_opengl_start_frame(void) {
+    frame_num++;
+    tmu_atlas[0] = tmu_atlas[1] = false;
+    gfx_frame_stats.resident_bytes = own_bytes + num_atlas_pages * ATLAS_PAGE_BYTES;
+
     glDisable(GL_SCISSOR_TEST);
     glDepthMask(GL_TRUE); // Must be set to clear Z-buffer
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -569,6 +935,20 @@ static void gfx_opengl_start_frame(void) {
 }
 
 static void gfx_opengl_shutdown(void) {
+    for (uint32_t i = 0; i < num_textures; i++) {
+        if (textures[i].id) glDeleteTextures(1, &textures[i].id);
+        free(textures[i].pixels);
+    }
+    for (int i = 0; i < num_atlas_pages; i++)
+        glDeleteTextures(1, &atlas_pages[i].id);
+    if (fog_ramp) glDeleteTextures(1, &fog_ramp);
+    fog_ramp = 0;
+    num_textures = 0;
+    num_atlas_pages = 0;
+    own_bytes = 0;
+    free(scaled);
+    scaled = NULL;
+    scaled_size = 0;
 }
 
 static void gfx_opengl_on_resize(void) {
@@ -606,7 +986,9 @@ struct GfxRenderingAPI gfx_opengl_api = {
     NULL,
     NULL,
     NULL,
-    gfx_opengl_shutdown
+    gfx_opengl_shutdown,
+    NULL,
+    gfx_opengl_bind_atlas
 };
 
 #endif // ENABLE_OPENGL_LEGACY
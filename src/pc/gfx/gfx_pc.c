@@ -17,6 +17,9 @@
 #include "gfx_screen_config.h"
 
 #include "pc/configfile.h"
+#include "pc/benchmark.h"
+#include "pc/zone_profiler.h"
+#include "pc/mat4_simd.h"
 
 #define SUPPORT_CHECK(x) assert(x)
 
@@ -176,8 +179,23 @@ static struct RenderingState {
     struct XYWidthHeight viewport, scissor;
     struct ShaderProgram *shader_program;
     struct TextureHashmapNode *textures[2];
+    uint8_t atlas; // enum AtlasState of tile 0
+    float atlas_rect[4];
 } rendering_state;
 
+enum AtlasState {
+    ATLAS_UNKNOWN,
+    ATLAS_IN, // drawn from an atlas page, UVs go through atlas_rect
+    ATLAS_OUT, // could be in one, but is drawn on its own right now
+    ATLAS_NEVER, // the rendering API won't put it in one
+};
+
+// how far past its edges a triangle may sample a texture in an atlas page,
+// the border around it has the same texels the edges would clamp to
+#define ATLAS_SLACK 0.001f
+
+struct GfxFrameStats gfx_frame_stats;
+
 struct GfxDimensions gfx_current_dimensions;
 static float ratio_x = 1.f;
 static float ratio_y = 1.f;
@@ -187,6 +205,7 @@ static bool dropped_frame;
 static float buf_vbo[MAX_BUFFERED * (26 * 3)]; // 3 vertices in a triangle and 26 floats per vtx
 static size_t buf_vbo_len;
 static size_t buf_vbo_num_tris;
+static bool buf_vbo_particles; // buf_vbo only holds triangles from gfx_sp_particles
 
 static struct GfxWindowManagerAPI *gfx_wapi;
 static struct GfxRenderingAPI *gfx_rapi;
@@ -194,7 +213,16 @@ static struct GfxRenderingAPI *gfx_rapi;
 static void gfx_flush(void) {
     if (buf_vbo_len > 0) {
         int num = buf_vbo_num_tris;
-        gfx_rapi->draw_triangles(buf_vbo, buf_vbo_len, buf_vbo_num_tris);
+        BENCHMARK_BEGIN(BENCHMARK_RASTER);
+        PROFILER_ZONE_BEGIN(ZONE_RASTER);
+        gfx_frame_stats.passes++;
+        if (buf_vbo_particles && gfx_rapi->draw_particles) {
+            gfx_rapi->draw_particles(buf_vbo, buf_vbo_len, buf_vbo_num_tris);
+        } else {
+            gfx_rapi->draw_triangles(buf_vbo, buf_vbo_len, buf_vbo_num_tris);
+        }
+        PROFILER_ZONE_END(ZONE_RASTER);
+        BENCHMARK_END(BENCHMARK_RASTER);
         buf_vbo_len = 0;
         buf_vbo_num_tris = 0;
     }
@@ -571,6 +599,11 @@ static inline void calculate_normal_dir(const Light_t *light, float coeffs[3]) {
 
 static inline void gfx_matrix_mul_inplace(const float (*restrict a)[4], float (*restrict res)[4]) {
     float tmp[4][4];
+    if (gMat4Kernels.mul_full != NULL) {
+        // The kernels load all of b before writing dest
+        gMat4Kernels.mul_full(res, (float (*)[4]) a, res);
+        return;
+    }
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
             tmp[i][j] = a[i][0] * res[0][j] +
@@ -583,6 +616,10 @@ static inline void gfx_matrix_mul_inplace(const float (*restrict a)[4], float (*
 }
 
 static inline void gfx_matrix_mul(float (*restrict res)[4], const float (*restrict a)[4], const float (*restrict b)[4]) {
+    if (gMat4Kernels.mul_full != NULL) {
+        gMat4Kernels.mul_full(res, (float (*)[4]) a, (float (*)[4]) b);
+        return;
+    }
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
             res[i][j] = a[i][0] * b[0][j] +
@@ -644,6 +681,31 @@ static void gfx_sp_pop_matrix(uint32_t count) {
     }
 }
 
+static inline void gfx_finish_vertex(struct LoadedVertex *d, const uint8_t alpha) {
+    const float x = d->x, y = d->y, z = d->z;
+    float w = d->w;
+
+    // trivial clip rejection
+    d->clip_rej = 0;
+    if (x < -w) d->clip_rej |= CLIP_LEFT;
+    if (x >  w) d->clip_rej |= CLIP_RIGHT;
+    if (y < -w) d->clip_rej |= CLIP_BOTTOM;
+    if (y >  w) d->clip_rej |= CLIP_TOP;
+    if (z < -w) d->clip_rej |= CLIP_FAR;
+    if (z >  w) d->clip_rej |= CLIP_NEAR;
+
+    if (configEnableFog && (rsp.geometry_mode & G_FOG)) {
+        w = (w == 0.f) ? 1.f / 0.001f : 1.f / w;
+        const float winv = w < 0.0f ? 32767.0f : w;
+        float fog_z = z * winv * rsp.fog_mul + rsp.fog_offset;
+        if (fog_z < 0) fog_z = 0;
+        if (fog_z > 255) fog_z = 255;
+        d->color.a = fog_z; // Use alpha variable to store fog factor
+    } else {
+        d->color.a = alpha;
+    }
+}
+
 static void gfx_sp_vertex(size_t n_vertices, size_t dest_index, const Vtx *vertices) {
     for (size_t i = 0; i < n_vertices; i++, dest_index++) {
         const Vtx_t *v = &vertices[i].v;
@@ -711,31 +773,12 @@ static void gfx_sp_vertex(size_t n_vertices, size_t dest_index, const Vtx *verti
 
         d->u = U;
         d->v = V;
-
-        // trivial clip rejection
-        d->clip_rej = 0;
-        if (x < -w) d->clip_rej |= CLIP_LEFT;
-        if (x >  w) d->clip_rej |= CLIP_RIGHT;
-        if (y < -w) d->clip_rej |= CLIP_BOTTOM;
-        if (y >  w) d->clip_rej |= CLIP_TOP;
-        if (z < -w) d->clip_rej |= CLIP_FAR;
-        if (z >  w) d->clip_rej |= CLIP_NEAR;
-
         d->x = x;
         d->y = y;
         d->z = z;
         d->w = w;
 
-        if (configEnableFog && (rsp.geometry_mode & G_FOG)) {
-            w = (w == 0.f) ? 1.f / 0.001f : 1.f / w;
-            const float winv = w < 0.0f ? 32767.0f : w;
-            float fog_z = z * winv * rsp.fog_mul + rsp.fog_offset;
-            if (fog_z < 0) fog_z = 0;
-            if (fog_z > 255) fog_z = 255;
-            d->color.a = fog_z; // Use alpha variable to store fog factor
-        } else {
-            d->color.a = v->cn[3];
-        }
+        gfx_finish_vertex(d, v->cn[3]);
     }
 }
 
@@ -785,8 +828,11 @@ static inline bool gfx_update_textures(const bool used_textures[2], const bool l
         if (used_textures[i]) {
             if (rdp.textures_changed[i]) {
                 gfx_flush();
+                PROFILER_ZONE_BEGIN(ZONE_TEXTURE);
                 import_texture(i);
+                PROFILER_ZONE_END(ZONE_TEXTURE);
                 rdp.textures_changed[i] = false;
+                rendering_state.atlas = ATLAS_UNKNOWN;
             }
             if (linear_filter != rendering_state.textures[i]->linear_filter || rdp.texture_tile.cms != rendering_state.textures[i]->cms || rdp.texture_tile.cmt != rendering_state.textures[i]->cmt) {
                 gfx_flush();
@@ -800,6 +846,29 @@ static inline bool gfx_update_textures(const bool used_textures[2], const bool l
     return used_textures[0] || used_textures[1];
 }
 
+// Textures in an atlas page can only be drawn from there if the triangle doesn't wrap
+// around them and there is no second texture using the same UVs.
+static inline const float *gfx_update_atlas(const float uv[3][2], const bool used_textures[2]) {
+    bool inside = used_textures[0] && !used_textures[1];
+    for (int i = 0; i < 3 && inside; i++) {
+        inside = uv[i][0] >= -ATLAS_SLACK && uv[i][0] <= 1.f + ATLAS_SLACK
+              && uv[i][1] >= -ATLAS_SLACK && uv[i][1] <= 1.f + ATLAS_SLACK;
+    }
+
+    if (rendering_state.atlas == ATLAS_UNKNOWN
+        || (rendering_state.atlas == ATLAS_IN && !inside)
+        || (rendering_state.atlas == ATLAS_OUT && inside)) {
+        gfx_flush();
+        if (gfx_rapi->bind_atlas(0, inside, rendering_state.atlas_rect)) {
+            rendering_state.atlas = ATLAS_IN;
+        } else {
+            rendering_state.atlas = inside ? ATLAS_NEVER : ATLAS_OUT;
+        }
+    }
+
+    return (rendering_state.atlas == ATLAS_IN) ? rendering_state.atlas_rect : NULL;
+}
+
 static inline void gfx_push_triangle(const struct LoadedVertex *restrict v1, const struct LoadedVertex *restrict v2, const struct LoadedVertex *restrict v3) {
     const struct LoadedVertex *v_arr[3] = {v1, v2, v3};
 
@@ -848,6 +917,25 @@ static inline void gfx_push_triangle(const struct LoadedVertex *restrict v1, con
     const bool use_texture = gfx_update_textures(used_textures, linear_filter);
     const uint32_t tex_width = (rdp.texture_tile.lrs - rdp.texture_tile.uls + 4) / 4;
     const uint32_t tex_height = (rdp.texture_tile.lrt - rdp.texture_tile.ult + 4) / 4;
+    const float *atlas_rect = NULL;
+    float uv[3][2];
+
+    if (use_texture) {
+        for (int i = 0; i < 3; i++) {
+            float u = (v_arr[i]->u - rdp.texture_tile.uls * 8) / 32.0f;
+            float v = (v_arr[i]->v - rdp.texture_tile.ult * 8) / 32.0f;
+            if ((rdp.other_mode_h & (3U << G_MDSFT_TEXTFILT)) != G_TF_POINT) {
+                // Linear filter adds 0.5f to the coordinates
+                u += 0.5f;
+                v += 0.5f;
+            }
+            uv[i][0] = u / tex_width;
+            uv[i][1] = v / tex_height;
+        }
+        if (gfx_rapi->bind_atlas) {
+            atlas_rect = gfx_update_atlas(uv, used_textures);
+        }
+    }
 
 #ifndef GFX_W_PREMULT
     const bool z_is_from_0_to_1 = gfx_rapi->z_is_from_0_to_1();
@@ -873,15 +961,13 @@ static inline void gfx_push_triangle(const struct LoadedVertex *restrict v1, con
 #endif
 
         if (use_texture) {
-            float u = (v_arr[i]->u - rdp.texture_tile.uls * 8) / 32.0f;
-            float v = (v_arr[i]->v - rdp.texture_tile.ult * 8) / 32.0f;
-            if ((rdp.other_mode_h & (3U << G_MDSFT_TEXTFILT)) != G_TF_POINT) {
-                // Linear filter adds 0.5f to the coordinates
-                u += 0.5f;
-                v += 0.5f;
+            float u = uv[i][0], v = uv[i][1];
+            if (atlas_rect) {
+                u = atlas_rect[0] + u * atlas_rect[2];
+                v = atlas_rect[1] + v * atlas_rect[3];
             }
-            buf_vbo[buf_vbo_len++] = GFX_OUT_PROP(u / tex_width);
-            buf_vbo[buf_vbo_len++] = GFX_OUT_PROP(v / tex_height);
+            buf_vbo[buf_vbo_len++] = GFX_OUT_PROP(u);
+            buf_vbo[buf_vbo_len++] = GFX_OUT_PROP(v);
         }
 
         if (use_fog) {
@@ -1087,6 +1173,66 @@ static void gfx_sp_tri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx) {
     gfx_push_triangle(v1, v2, v3);
 }
 
+#ifdef G_PARTICLES
+static void gfx_sp_particles(const Particles_t *p, const uint16_t count) {
+    struct LoadedVertex corners[3];
+    struct LoadedVertex *d = rsp.loaded_vertices;
+
+    if (rsp.geometry_mode & G_LIGHTING) {
+        // lit particles need the full vertex path, there are none in the game anyway
+        Vtx vtx[3] = { { .v = p->tri[0] }, { .v = p->tri[1] }, { .v = p->tri[2] } };
+        for (uint16_t i = 0; i < count; i++) {
+            for (int k = 0; k < 3; k++) {
+                vtx[k].v.ob[0] = p->tri[k].ob[0] + p->pos[i][0];
+                vtx[k].v.ob[1] = p->tri[k].ob[1] + p->pos[i][1];
+                vtx[k].v.ob[2] = p->tri[k].ob[2] + p->pos[i][2];
+            }
+            gfx_sp_vertex(3, 0, vtx);
+            gfx_sp_tri1(0, 1, 2);
+        }
+        return;
+    }
+
+    // the triangle is the same for every particle, so only its origin has to be transformed each time
+    for (int k = 0; k < 3; k++) {
+        const Vtx_t *v = &p->tri[k];
+        corners[k].x = v->ob[0] * rsp.MP_matrix[0][0] + v->ob[1] * rsp.MP_matrix[1][0] + v->ob[2] * rsp.MP_matrix[2][0];
+        corners[k].y = v->ob[0] * rsp.MP_matrix[0][1] + v->ob[1] * rsp.MP_matrix[1][1] + v->ob[2] * rsp.MP_matrix[2][1];
+        corners[k].z = v->ob[0] * rsp.MP_matrix[0][2] + v->ob[1] * rsp.MP_matrix[1][2] + v->ob[2] * rsp.MP_matrix[2][2];
+        corners[k].w = v->ob[0] * rsp.MP_matrix[0][3] + v->ob[1] * rsp.MP_matrix[1][3] + v->ob[2] * rsp.MP_matrix[2][3];
+        corners[k].u = (short)(v->tc[0] * rsp.texture_scaling_factor.s >> 16);
+        corners[k].v = (short)(v->tc[1] * rsp.texture_scaling_factor.t >> 16);
+        corners[k].color.r = v->cn[0];
+        corners[k].color.g = v->cn[1];
+        corners[k].color.b = v->cn[2];
+    }
+
+    // everything buffered from here on is particles, let the rendering API draw them as one batch
+    gfx_flush();
+    buf_vbo_particles = true;
+
+    for (uint16_t i = 0; i < count; i++) {
+        const float px = p->pos[i][0], py = p->pos[i][1], pz = p->pos[i][2];
+        const float x = px * rsp.MP_matrix[0][0] + py * rsp.MP_matrix[1][0] + pz * rsp.MP_matrix[2][0] + rsp.MP_matrix[3][0];
+        const float y = px * rsp.MP_matrix[0][1] + py * rsp.MP_matrix[1][1] + pz * rsp.MP_matrix[2][1] + rsp.MP_matrix[3][1];
+        const float z = px * rsp.MP_matrix[0][2] + py * rsp.MP_matrix[1][2] + pz * rsp.MP_matrix[2][2] + rsp.MP_matrix[3][2];
+        const float w = px * rsp.MP_matrix[0][3] + py * rsp.MP_matrix[1][3] + pz * rsp.MP_matrix[2][3] + rsp.MP_matrix[3][3];
+        for (int k = 0; k < 3; k++) {
+            d[k] = corners[k];
+            d[k].x += x;
+            d[k].y += y;
+            d[k].z += z;
+            d[k].w += w;
+            gfx_finish_vertex(&d[k], p->tri[k].cn[3]);
+        }
+        gfx_sp_tri1(0, 1, 2);
+    }
+
+    gfx_flush();
+    buf_vbo_particles = false;
+}
+#endif
+
 static void gfx_sp_geometry_mode(uint32_t clear, uint32_t set) {
     rsp.geometry_mode &= ~clear;
     rsp.geometry_mode |= set;
@@ -1460,7 +1606,11 @@ static void gfx_dp_texture_rectangle(int32_t ulx, int32_t uly, int32_t lrx, int3
         lrxf = HALF_SCREEN_WIDTH + (lrxf / 4.0f - HALF_SCREEN_WIDTH);
         ulyf = ulyf / 4.0f;
         lryf = lryf / 4.0f;
+        BENCHMARK_BEGIN(BENCHMARK_RASTER);
+        PROFILER_ZONE_BEGIN(ZONE_RASTER);
         gfx_rapi->tex_rect(ulxf, ulyf, lrxf, lryf, uls / 32.f, ult / 32.f, dudx / 8.f, dvdy / 8.f, &rdp.env_color.r);
+        PROFILER_ZONE_END(ZONE_RASTER);
+        BENCHMARK_END(BENCHMARK_RASTER);
     } else {
         struct LoadedVertex* ul = &rsp.loaded_vertices[MAX_VERTICES + 0];
         struct LoadedVertex* ll = &rsp.loaded_vertices[MAX_VERTICES + 1];
@@ -1513,7 +1663,11 @@ static void gfx_dp_fill_rectangle(int32_t ulx, int32_t uly, int32_t lrx, int32_t
         lrxf = HALF_SCREEN_WIDTH + (lrxf / 4.0f - HALF_SCREEN_WIDTH);
         ulyf = ulyf / 4.0f;
         lryf = lryf / 4.0f;
+        BENCHMARK_BEGIN(BENCHMARK_RASTER);
+        PROFILER_ZONE_BEGIN(ZONE_RASTER);
         gfx_rapi->fill_rect(ulxf, ulyf, lrxf, lryf, &rdp.fill_color.r);
+        PROFILER_ZONE_END(ZONE_RASTER);
+        BENCHMARK_END(BENCHMARK_RASTER);
     } else {
         for (int i = MAX_VERTICES; i < MAX_VERTICES + 4; i++) {
             struct LoadedVertex* v = &rsp.loaded_vertices[i];
@@ -1635,6 +1789,11 @@ static void gfx_run_dl(Gfx* cmd) {
                 gfx_sp_tri1(C0(16, 8) / 2, C0(8, 8) / 2, C0(0, 8) / 2);
                 gfx_sp_tri1(C1(16, 8) / 2, C1(8, 8) / 2, C1(0, 8) / 2);
                 break;
+#endif
+#ifdef G_PARTICLES
+            case G_PARTICLES:
+                gfx_sp_particles((const Particles_t *) seg_addr(cmd->words.w1), C0(0, 16));
+                break;
 #endif
             case (uint8_t)G_SETOTHERMODE_L:
 #ifdef F3DEX_GBI_2
@@ -1824,6 +1983,13 @@ void gfx_start_frame(void) {
     }
     ratio_x = (float)gfx_current_dimensions.width / (float)SCREEN_WIDTH;
     ratio_y = (float)gfx_current_dimensions.height / (float)SCREEN_HEIGHT;
+
+    // Decided before the game runs, so it can skip building the frame altogether
+    dropped_frame = !gfx_wapi->start_frame();
+}
+
+bool gfx_frame_dropped(void) {
+    return dropped_frame;
 }
 
 void gfx_run(Gfx *commands) {
@@ -1831,16 +1997,31 @@ void gfx_run(Gfx *commands) {
 
     //puts("New frame");
 
-    if (!gfx_wapi->start_frame()) {
-        dropped_frame = true;
+    if (dropped_frame) {
         return;
     }
-    dropped_frame = false;
 
+    BENCHMARK_BEGIN(BENCHMARK_GFX);
+    PROFILER_ZONE_BEGIN(ZONE_GFX);
+    gfx_frame_stats.uploads = 0;
+    gfx_frame_stats.upload_bytes = 0;
+    gfx_frame_stats.evictions = 0;
+    gfx_frame_stats.passes = 0;
+    rendering_state.atlas = ATLAS_UNKNOWN; // pages may be recycled between frames
+    BENCHMARK_BEGIN(BENCHMARK_RASTER);
+    PROFILER_ZONE_BEGIN(ZONE_RASTER);
     gfx_rapi->start_frame();
+    PROFILER_ZONE_END(ZONE_RASTER);
+    BENCHMARK_END(BENCHMARK_RASTER);
     gfx_run_dl(commands);
     gfx_flush();
+    BENCHMARK_BEGIN(BENCHMARK_RASTER);
+    PROFILER_ZONE_BEGIN(ZONE_RASTER);
     gfx_rapi->end_frame();
+    PROFILER_ZONE_END(ZONE_RASTER);
+    BENCHMARK_END(BENCHMARK_RASTER);
+    PROFILER_ZONE_END(ZONE_GFX);
+    BENCHMARK_END(BENCHMARK_GFX);
     gfx_wapi->swap_buffers_begin();
 }
 
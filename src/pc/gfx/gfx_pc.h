@@ -18,6 +18,17 @@ struct GfxDimensions {
 
 extern struct GfxDimensions gfx_current_dimensions;
 
+// Work done for the current frame, mostly filled in by the rendering API
+struct GfxFrameStats {
+    uint32_t uploads; // textures
+    uint32_t upload_bytes;
+    uint32_t evictions;
+    uint32_t resident_bytes; // not reset every frame
+    uint32_t passes; // times triangles were drawn, including extra passes some combiners need
+};
+
+extern struct GfxFrameStats gfx_frame_stats;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -26,6 +37,7 @@ void gfx_init(struct GfxWindowManagerAPI *wapi, struct GfxRenderingAPI *rapi, co
 void gfx_shutdown(void);
 struct GfxRenderingAPI *gfx_get_current_rendering_api(void);
 void gfx_start_frame(void);
+bool gfx_frame_dropped(void);
 void gfx_run(Gfx *commands);
 void gfx_end_frame(void);
 
@@ -34,6 +34,8 @@ struct GfxRenderingAPI {
     void (*tex_rect)(int x0, int y0, int x1, int y1, const float u0, const float v0, const float dudx, const float dvdy, const uint8_t *rgba); // optional; draw 2d rect textured with tile 0
     void (*set_fog_color)(const uint8_t *rgb); // optional; set global fog color
     void (*shutdown)(void); // optional
+    void (*draw_particles)(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris); // optional; draw_triangles for a batch of small camera-facing triangles
+    bool (*bind_atlas)(int tile, bool allow, float rect[4]); // optional; draw the tile from an atlas page if allowed and possible, rect gets its UV offset and scale there
 };
 
 #endif
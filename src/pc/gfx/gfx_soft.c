@@ -100,6 +100,7 @@ struct Texture {
     int wrap_w, wrap_h; // size - 1 for wrapping
     bool filter;        // linear filter
     uint32_t addr;      // offset into texcache
+    uint32_t used;      // frame the texture was last selected in
     sample_fn_t sample; // sampling function (does wrapping/clamping)
 };
 
@@ -116,6 +117,8 @@ struct ClipRect {
 };
 
 uint32_t *gfx_output;
+uint8_t gfx_soft_dirty_tiles[GFX_SOFT_TILES];
+static enum GfxSoftFormat out_format = GFX_SOFT_FMT_RGBA32; // what gfx_output actually holds
 
 // this is set in the drawing functions
 static draw_fn_t draw_fn;
@@ -127,6 +130,7 @@ static struct ShaderProgram *cur_shader = NULL;
 static struct Texture *cur_tex[2]; // currently selected textures for both tiles
 static struct Texture tex_hdr[MAX_TEXTURES];
 static uint32_t tex_num = 0; // amount of textures in cache
+static uint32_t frame_num = 0; // frames started so far
 static int cur_tmu = 0; // select tile (used only for uploading)
 
 // texture cache: linearly stores RGBA data of every cached texture
@@ -158,6 +162,16 @@ static uint8_t lerp_tab[256][256 * 2 + 1];
 // color component multiplication table: [x][y] = (x * y) / 256;
 static uint8_t mult_tab[256][256];
 
+// GFX_SOFT_FMT_PAL8 output: each channel gets the ordered dither offset of its pixel
+// and is cut to 5 bits by pal_dither, then pal_lookup gives the closest palette entry
+static Color4 pal_colors[256];
+static uint8_t pal_dac[256 * 3]; // pal_colors as handed out by gfx_soft_get_new_palette
+static bool pal_changed;
+static uint8_t pal_lookup_buf[2][32768];
+static uint8_t *pal_lookup = pal_lookup_buf[0]; // RGB555 -> closest entry of pal_colors
+static uint8_t pal_dither[4][4 * 256];          // [row & 3][(column & 3) * 256 + channel]
+static const uint8_t *pal_dither_row = pal_dither[0]; // set by whatever plots the current row
+
 /* math shit */
 
 static inline uint16_t u16clamp(const int v) {
@@ -212,6 +226,17 @@ static inline int imax(const int a, const int b) {
     return (a > b) ? a : b;
 }
 
+// flags every tile that the rect from x0, y0 to x1, y1 (exclusive) in gfx_output overlaps
+static inline void mark_tiles(int x0, int y0, int x1, int y1) {
+    x0 = imax(0, x0) >> GFX_SOFT_TILE_SHIFT;
+    y0 = imax(0, y0) >> GFX_SOFT_TILE_SHIFT;
+    x1 = (imin(scr_width, x1) + GFX_SOFT_TILE_SIZE - 1) >> GFX_SOFT_TILE_SHIFT;
+    y1 = (imin(scr_height, y1) + GFX_SOFT_TILE_SIZE - 1) >> GFX_SOFT_TILE_SHIFT;
+    for (int y = y0; y < y1; ++y)
+        for (int x = x0; x < x1; ++x)
+            gfx_soft_dirty_tiles[y * GFX_SOFT_TILES_X + x] = 1;
+}
+
 static inline void viewport_transform(Vector4 *v) {
     // gfx_pc.c with ENABLE_SOFTRAST defined will feed us with everything already pre-multiplied by inverse of w
     v->x = v->x * r_view.hw + r_view.cx + 0.5f;
@@ -424,6 +449,80 @@ static void draw_pixel_blend_edge_zwrite(const int idx, const uint16_t z, Color4
     }
 }
 
+/* fragment plotters for the narrow output formats, see gfx_soft_set_output_format */
+
+#define DEFINE_NATIVE_PACK_FUNCS(fmt, type) \
+    static inline Color4 unpack_##fmt(const type p) { \
+        Color4 c; \
+        gfx_soft_unpack_##fmt(p, &c.r, &c.g, &c.b); \
+        return c; \
+    } \
+    static inline type pack_##fmt(UNUSED const int idx, const uint8_t r, const uint8_t g, const uint8_t b) { \
+        return gfx_soft_pack_##fmt(r, g, b); \
+    }
+
+DEFINE_NATIVE_PACK_FUNCS(rgb332, uint8_t)
+DEFINE_NATIVE_PACK_FUNCS(rgb555, uint16_t)
+DEFINE_NATIVE_PACK_FUNCS(rgb565, uint16_t)
+
+static inline Color4 unpack_pal8(const uint8_t p) {
+    return pal_colors[p];
+}
+
+// the screen is a multiple of 4 pixels wide, so the column of idx is as good as x here
+static inline uint8_t pack_pal8(const int idx, const uint8_t r, const uint8_t g, const uint8_t b) {
+    const uint8_t *d = pal_dither_row + ((idx & 3) << 8);
+    return pal_lookup[(d[r] << 10) | (d[g] << 5) | d[b]];
+}
+
+#define DEFINE_NATIVE_DRAW_FUNCS(fmt, type) \
+    static inline void blend_##fmt(const int idx, const Color4 src) { \
+        const uint8_t a = src.a; \
+        const uint8_t ia = 255 - a; \
+        const Color4 dst = unpack_##fmt(((type *)gfx_output)[idx]); \
+        ((type *)gfx_output)[idx] = pack_##fmt(idx, mult_tab[src.r][a] + mult_tab[dst.r][ia], \
+                                                    mult_tab[src.g][a] + mult_tab[dst.g][ia], \
+                                                    mult_tab[src.b][a] + mult_tab[dst.b][ia]); \
+    } \
+    static void draw_pixel_##fmt(const int idx, UNUSED const uint16_t z, Color4 src) { \
+        ((type *)gfx_output)[idx] = pack_##fmt(idx, src.r, src.g, src.b); \
+    } \
+    static void draw_pixel_zwrite_##fmt(const int idx, const uint16_t z, Color4 src) { \
+        ((type *)gfx_output)[idx] = pack_##fmt(idx, src.r, src.g, src.b); \
+        z_buffer[idx] = z; \
+    } \
+    static void draw_pixel_blend_##fmt(const int idx, UNUSED const uint16_t z, Color4 src) { \
+        blend_##fmt(idx, src); \
+    } \
+    static void draw_pixel_blend_zwrite_##fmt(const int idx, const uint16_t z, Color4 src) { \
+        blend_##fmt(idx, src); \
+        z_buffer[idx] = z; \
+    } \
+    static void draw_pixel_blend_edge_##fmt(const int idx, UNUSED const uint16_t z, Color4 src) { \
+        if (src.a > 0x80) \
+            blend_##fmt(idx, src); \
+    } \
+    static void draw_pixel_blend_edge_zwrite_##fmt(const int idx, const uint16_t z, Color4 src) { \
+        if (src.a > 0x80) { \
+            blend_##fmt(idx, src); \
+            z_buffer[idx] = z; \
+        } \
+    }
+
+DEFINE_NATIVE_DRAW_FUNCS(rgb332, uint8_t)
+DEFINE_NATIVE_DRAW_FUNCS(rgb555, uint16_t)
+DEFINE_NATIVE_DRAW_FUNCS(rgb565, uint16_t)
+DEFINE_NATIVE_DRAW_FUNCS(pal8, uint8_t)
+
+#define NATIVE_DRAW_FUNCS(fmt) { \
+    draw_pixel_##fmt, \
+    draw_pixel_zwrite_##fmt, \
+    draw_pixel_blend_##fmt, \
+    draw_pixel_blend_zwrite_##fmt, \
+    draw_pixel_blend_edge_##fmt, \
+    draw_pixel_blend_edge_zwrite_##fmt, \
+}
+
 /* rasterizers */
 
 #define R_RASTERIZE_TRI_SEG(y_a, y_b, nprops) \
@@ -442,6 +541,7 @@ static void draw_pixel_blend_edge_zwrite(const int idx, const uint16_t z, Color4
         dx = 1.f - (x_a - x); \
         for (i = 2; i < nprops; ++i) p[i] = p_a[i] + dx * dp[i].x; \
         idx = scr_width * (scr_height - y - 1) + x; \
+        pal_dither_row = pal_dither[(scr_height - y - 1) & 3]; \
         /* draw scanline from current x_a to current x_b */ \
         while (x++ < x_end) { \
             uz = u16clamp(p[2] * 65535.f + z_offset); \
@@ -573,16 +673,81 @@ static inline void pop_triangle(const float *buf, const int stride) {
     if (v0->y > v2->y) { vt = v0; v0 = v2; v2 = vt; }
     if (v1->y > v2->y) { vt = v1; v1 = v2; v2 = vt; }
 
+    // rows are flipped when plotting, and a pixel of slack covers the float to int rounding
+    mark_tiles((int)fminf(v0->x, fminf(v1->x, v2->x)) - 1, scr_height - (int)v2->y - 1,
+               (int)fmaxf(v0->x, fmaxf(v1->x, v2->x)) + 2, scr_height - (int)v0->y + 1);
+
     const struct Tri out = (struct Tri) { (float *)v0, (float *)v1, (float *)v2 };
     cur_shader->rast(out);
 }
 
+// particles are a few pixels big and face the camera, so instead of the perspective correct rasterizer
+// they get splatted at a single depth with their props interpolated linearly across the screen
+static inline void splat_triangle(float *buf, const int stride) {
+    Vector4 *v0 = (Vector4 *)buf;
+    Vector4 *v1 = (Vector4 *)(buf + stride);
+    Vector4 *v2 = (Vector4 *)(buf + (stride << 1));
+    const int nprops = stride - 4;
+    float p0[16], dpdx[16], dpdy[16], p[16];
+    register int i, x, y;
+
+    viewport_transform(v0);
+    viewport_transform(v1);
+    viewport_transform(v2);
+
+    const float area = (v1->x - v0->x) * (v2->y - v0->y) - (v2->x - v0->x) * (v1->y - v0->y);
+    if (area > -0.5f && area < 0.5f)
+        return; // less than a pixel, or degenerate
+
+    // undo the division by w, then get the screen space gradients of every prop
+    const float inv_area = 1.f / area;
+    const float w0 = 1.f / v0->w, w1 = 1.f / v1->w, w2 = 1.f / v2->w;
+    for (i = 0; i < nprops; ++i) {
+        const float a = buf[4 + i] * w0;
+        const float b = buf[stride + 4 + i] * w1 - a;
+        const float c = buf[(stride << 1) + 4 + i] * w2 - a;
+        p0[i] = a;
+        dpdx[i] = (b * (v2->y - v0->y) - c * (v1->y - v0->y)) * inv_area;
+        dpdy[i] = (c * (v1->x - v0->x) - b * (v2->x - v0->x)) * inv_area;
+    }
+
+    const int x0 = imax(r_clip.x0, (int)fminf(v0->x, fminf(v1->x, v2->x)));
+    const int x1 = imin(r_clip.x1, (int)fmaxf(v0->x, fmaxf(v1->x, v2->x)) + 1);
+    const int y0 = imax(r_clip.y0, (int)fminf(v0->y, fminf(v1->y, v2->y)));
+    const int y1 = imin(r_clip.y1, (int)fmaxf(v0->y, fmaxf(v1->y, v2->y)) + 1);
+    const uint16_t uz = u16clamp((v0->z + v1->z + v2->z) * (65535.f / 3.f) + z_offset);
+    const float sign = area > 0.f ? 1.f : -1.f;
+
+    mark_tiles(x0, scr_height - y1, x1, scr_height - y0);
+
+    for (y = y0; y < y1; ++y) {
+        const float py = y + 0.5f - v0->y;
+        int idx = scr_width * (scr_height - y - 1) + x0;
+        pal_dither_row = pal_dither[(scr_height - y - 1) & 3];
+        for (x = x0; x < x1; ++x, ++idx) {
+            const float px = x + 0.5f - v0->x;
+            // edge functions of the three sides, all non-negative inside the triangle
+            const float e0 = sign * ((v1->x - v0->x) * py - (v1->y - v0->y) * px);
+            const float e1 = sign * ((v2->x - v1->x) * (y + 0.5f - v1->y) - (v2->y - v1->y) * (x + 0.5f - v1->x));
+            const float e2 = sign * ((v0->x - v2->x) * (y + 0.5f - v2->y) - (v0->y - v2->y) * (x + 0.5f - v2->x));
+            if (e0 < 0.f || e1 < 0.f || e2 < 0.f)
+                continue;
+            if (z_test && uz > z_buffer[idx])
+                continue;
+            for (i = 0; i < nprops; ++i)
+                p[i] = p0[i] + px * dpdx[i] + py * dpdy[i];
+            draw_fn(idx, uz, cur_shader->combine(1.f, p));
+        }
+    }
+}
+
 static inline void depth_clear(void) {
     memset(z_buffer, 0xFF, scr_size << 1);
 }
 
 static inline void color_clear(void) {
     memset(gfx_output, 0x00, scr_size << 2);
+    memset(gfx_soft_dirty_tiles, 1, sizeof(gfx_soft_dirty_tiles));
 }
 
 /* FIXME: ztrick fucks with sky blending
@@ -602,6 +767,288 @@ static inline void depth_swap(void) {
 }
 */
 
+/* palette building for GFX_SOFT_FMT_PAL8 */
+
+#define PAL_NEW_TEXTURES 16   // uploads it takes to consider the scene changed
+#define PAL_SETTLE_FRAMES 30  // frames without uploads before the palette is rebuilt
+#define PAL_RECENT_FRAMES 90  // textures selected this recently make up the palette
+#define PAL_LOOKUP_STEP 2048  // lookup entries built per frame
+#define PAL_GRID_COLORS 27    // fixed 3x3x3 grid, for untextured and fogged surfaces
+
+struct PalBin {
+    uint16_t rgb; // 4:4:4
+    uint32_t count;
+};
+
+struct PalBox {
+    int start, end; // range in pal_bins
+    uint32_t count;
+    int axis, extent; // longest side
+};
+
+static const uint8_t bayer_4x4[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+static uint32_t pal_hist[4096];
+static struct PalBin pal_bins[4096];
+static struct PalBox pal_boxes[256];
+static int pal_split_axis;
+static Color4 pal_next[256];        // palette the lookup is being built for
+static uint8_t pal_order[256];      // pal_next sorted by green
+static uint16_t pal_green_start[256]; // first pal_order entry with at least this much green, 256 if none
+static int pal_build_pos = -1;      // next lookup entry to build, -1 if not building
+static uint32_t pal_new_textures;
+static uint32_t pal_quiet_frames;
+
+static inline int pal_bin_channel(const int rgb, const int axis) {
+    return (rgb >> (8 - 4 * axis)) & 15;
+}
+
+static int pal_bin_compare(const void *a, const void *b) {
+    return pal_bin_channel(((const struct PalBin *)a)->rgb, pal_split_axis)
+         - pal_bin_channel(((const struct PalBin *)b)->rgb, pal_split_axis);
+}
+
+static void pal_box_measure(struct PalBox *box) {
+    int lo[3] = { 15, 15, 15 }, hi[3] = { 0, 0, 0 };
+    box->count = 0;
+    for (int i = box->start; i < box->end; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            const int v = pal_bin_channel(pal_bins[i].rgb, c);
+            lo[c] = imin(lo[c], v);
+            hi[c] = imax(hi[c], v);
+        }
+        box->count += pal_bins[i].count;
+    }
+    box->axis = 0;
+    for (int c = 1; c < 3; ++c)
+        if (hi[c] - lo[c] > hi[box->axis] - lo[box->axis])
+            box->axis = c;
+    box->extent = hi[box->axis] - lo[box->axis];
+}
+
+// counts the texels of recently used textures, plus half as many at half
+// brightness because most surfaces are shaded, and the fog color
+static void pal_gather(void) {
+    uint32_t total = 0;
+    memset(pal_hist, 0, sizeof(pal_hist));
+    for (uint32_t t = 0; t < tex_num; ++t) {
+        const struct Texture *tex = tex_hdr + t;
+        if (tex->w == 0 || frame_num - tex->used > PAL_RECENT_FRAMES)
+            continue;
+        const uint8_t *p = texcache + tex->addr;
+        for (int i = tex->w * tex->h; i > 0; --i, p += 4) {
+            if (p[3] < 0x80)
+                continue;
+            pal_hist[((p[0] >> 4) << 8) | ((p[1] >> 4) << 4) | (p[2] >> 4)] += 2;
+            pal_hist[((p[0] >> 5) << 8) | ((p[1] >> 5) << 4) | (p[2] >> 5)] += 1;
+            total += 3;
+        }
+    }
+    pal_hist[((fog_color.r >> 4) << 8) | ((fog_color.g >> 4) << 4) | (fog_color.b >> 4)] += total >> 4;
+}
+
+// median cut of pal_hist into at most max_colors colors, returns how many it made
+static int pal_median_cut(Color4 *out, const int max_colors) {
+    int num_bins = 0, num_boxes = 1;
+
+    for (int i = 0; i < 4096; ++i) {
+        if (pal_hist[i]) {
+            pal_bins[num_bins].rgb = i;
+            pal_bins[num_bins].count = pal_hist[i];
+            ++num_bins;
+        }
+    }
+    if (num_bins == 0)
+        return 0;
+
+    pal_boxes[0].start = 0;
+    pal_boxes[0].end = num_bins;
+    pal_box_measure(&pal_boxes[0]);
+
+    while (num_boxes < max_colors) {
+        // split the box that covers the most texels over the longest distance
+        struct PalBox *box = NULL;
+        uint64_t best = 0;
+        for (int b = 0; b < num_boxes; ++b) {
+            const uint64_t score = (uint64_t)pal_boxes[b].count * pal_boxes[b].extent;
+            if (score > best) {
+                best = score;
+                box = &pal_boxes[b];
+            }
+        }
+        if (box == NULL)
+            break; // every box is down to a single bin
+
+        pal_split_axis = box->axis;
+        qsort(pal_bins + box->start, box->end - box->start, sizeof(struct PalBin), pal_bin_compare);
+
+        int mid = box->start;
+        uint32_t below = 0;
+        while (mid < box->end - 1 && below + pal_bins[mid].count <= box->count / 2)
+            below += pal_bins[mid++].count;
+        if (mid == box->start)
+            ++mid;
+
+        pal_boxes[num_boxes].start = mid;
+        pal_boxes[num_boxes].end = box->end;
+        box->end = mid;
+        pal_box_measure(box);
+        pal_box_measure(&pal_boxes[num_boxes]);
+        ++num_boxes;
+    }
+
+    for (int b = 0; b < num_boxes; ++b) {
+        uint32_t sum[3] = { 0, 0, 0 };
+        for (int i = pal_boxes[b].start; i < pal_boxes[b].end; ++i)
+            for (int c = 0; c < 3; ++c)
+                sum[c] += pal_bins[i].count * ((pal_bin_channel(pal_bins[i].rgb, c) << 4) | 8);
+        out[b].r = sum[0] / pal_boxes[b].count;
+        out[b].g = sum[1] / pal_boxes[b].count;
+        out[b].b = sum[2] / pal_boxes[b].count;
+        out[b].a = 0xFF;
+    }
+
+    return num_boxes;
+}
+
+static void pal_sort_next(void) {
+    int i, j;
+    for (i = 0; i < 256; ++i) {
+        const uint8_t e = i;
+        for (j = i; j > 0 && pal_next[pal_order[j - 1]].g > pal_next[e].g; --j)
+            pal_order[j] = pal_order[j - 1];
+        pal_order[j] = e;
+    }
+    for (i = 0, j = 0; i < 256; ++i) {
+        while (j < 256 && pal_next[pal_order[j]].g < i)
+            ++j;
+        pal_green_start[i] = j;
+    }
+}
+
+// closest entry of pal_next, walking out from the nearest green until green alone is too far
+static uint8_t pal_nearest(const int r, const int g, const int b) {
+    int best = 0x7FFFFFFF, best_idx = 0;
+    for (int i = pal_green_start[g]; i < 256; ++i) {
+        const Color4 c = pal_next[pal_order[i]];
+        const int dr = c.r - r, dg = c.g - g, db = c.b - b;
+        if (4 * dg * dg >= best)
+            break;
+        const int d = 3 * dr * dr + 4 * dg * dg + 2 * db * db;
+        if (d < best) {
+            best = d;
+            best_idx = pal_order[i];
+        }
+    }
+    for (int i = pal_green_start[g] - 1; i >= 0; --i) {
+        const Color4 c = pal_next[pal_order[i]];
+        const int dr = c.r - r, dg = c.g - g, db = c.b - b;
+        if (4 * dg * dg >= best)
+            break;
+        const int d = 3 * dr * dr + 4 * dg * dg + 2 * db * db;
+        if (d < best) {
+            best = d;
+            best_idx = pal_order[i];
+        }
+    }
+    return best_idx;
+}
+
+// the dither offsets span about the distance between neighbouring palette entries
+static void pal_setup_dither(void) {
+    float spread = 0.f;
+    for (int i = 0; i < 256; ++i) {
+        int nearest = 0x7FFFFFFF;
+        for (int j = 0; j < 256; ++j) {
+            const int dr = pal_colors[i].r - pal_colors[j].r;
+            const int dg = pal_colors[i].g - pal_colors[j].g;
+            const int db = pal_colors[i].b - pal_colors[j].b;
+            const int d = dr * dr + dg * dg + db * db;
+            if (j != i && d > 0 && d < nearest)
+                nearest = d;
+        }
+        if (nearest != 0x7FFFFFFF)
+            spread += sqrtf(nearest);
+    }
+    const int amount = imin(64, imax(8, (int)(spread / 256.f)));
+
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            const int offset = ((2 * bayer_4x4[y][x] + 1) * amount) / 32 - amount / 2;
+            for (int v = 0; v < 256; ++v)
+                pal_dither[y][(x << 8) + v] = imin(255, imax(0, v + offset)) >> 3;
+        }
+    }
+}
+
+// builds count more entries of the lookup for pal_next, into the half not in use,
+// and switches over to the new palette once all of them are done
+static void pal_build_lookup(const int count) {
+    uint8_t *lookup = (pal_lookup == pal_lookup_buf[0]) ? pal_lookup_buf[1] : pal_lookup_buf[0];
+    const int end = imin(32768, pal_build_pos + count);
+
+    for (; pal_build_pos < end; ++pal_build_pos) {
+        const int r = pal_build_pos >> 10, g = (pal_build_pos >> 5) & 31, b = pal_build_pos & 31;
+        lookup[pal_build_pos] = pal_nearest((r << 3) | (r >> 2), (g << 3) | (g >> 2), (b << 3) | (b >> 2));
+    }
+
+    if (pal_build_pos == 32768) {
+        pal_build_pos = -1;
+        pal_lookup = lookup;
+        memcpy(pal_colors, pal_next, sizeof(pal_colors));
+        for (int i = 0; i < 256; ++i) {
+            pal_dac[i * 3 + 0] = pal_colors[i].r;
+            pal_dac[i * 3 + 1] = pal_colors[i].g;
+            pal_dac[i * 3 + 2] = pal_colors[i].b;
+        }
+        pal_setup_dither();
+        pal_changed = true;
+    }
+}
+
+static void pal_set_rgb332(void) {
+    for (int i = 0; i < 256; ++i) {
+        gfx_soft_unpack_rgb332(i, &pal_next[i].r, &pal_next[i].g, &pal_next[i].b);
+        pal_next[i].a = 0xFF;
+    }
+}
+
+// Once a burst of texture uploads (a new level or area) has settled, the palette is
+// rebuilt from the textures in use. The lookup for it is spread over a few frames.
+static void pal_update(void) {
+    if (pal_build_pos >= 0) {
+        pal_build_lookup(PAL_LOOKUP_STEP);
+        return;
+    }
+
+    if (pal_new_textures < PAL_NEW_TEXTURES || ++pal_quiet_frames < PAL_SETTLE_FRAMES)
+        return;
+    pal_new_textures = 0;
+
+    pal_set_rgb332(); // fills whatever the median cut leaves over
+    for (int i = 0; i < PAL_GRID_COLORS; ++i) {
+        pal_next[i].r = (i % 3) * 0x7F + (i % 3) / 2;
+        pal_next[i].g = (i / 3 % 3) * 0x7F + (i / 3 % 3) / 2;
+        pal_next[i].b = (i / 9) * 0x7F + (i / 9) / 2;
+    }
+    pal_gather();
+    pal_median_cut(pal_next + PAL_GRID_COLORS, 256 - PAL_GRID_COLORS);
+    pal_sort_next();
+    pal_build_pos = 0;
+}
+
+const uint8_t *gfx_soft_get_new_palette(void) {
+    if (!pal_changed)
+        return NULL;
+    pal_changed = false;
+    return pal_dac;
+}
+
 /* interface */
 
 static bool gfx_soft_z_is_from_0_to_1(void) {
@@ -722,6 +1169,7 @@ static uint32_t gfx_soft_new_texture(void) {
 
 static void gfx_soft_select_texture(int tile, uint32_t texture_id) {
     cur_tex[tile] = tex_hdr + texture_id;
+    cur_tex[tile]->used = frame_num;
     cur_tmu = tile;
 }
 
@@ -746,6 +1194,11 @@ static uint32_t tex_cache_alloc(const uint32_t w, const uint32_t h) {
 static void gfx_soft_upload_texture(const uint8_t *rgba32_buf, int width, int height) {
     uint32_t addr = tex_cache_alloc(width, height);
     memcpy(texcache + addr, rgba32_buf, width * height * 4);
+    gfx_frame_stats.uploads++;
+    gfx_frame_stats.upload_bytes += width * height * 4;
+    gfx_frame_stats.resident_bytes = texcache_addr;
+    ++pal_new_textures;
+    pal_quiet_frames = 0;
     struct Texture *tex = cur_tex[cur_tmu];
     tex->addr = addr;
     tex->w = width;
@@ -825,15 +1278,21 @@ static void gfx_soft_set_fog_color(const uint8_t *rgb) {
 }
 
 static inline void gfx_soft_pick_draw_func(void) {
-    static const draw_fn_t draw_funcs[] = {
-        draw_pixel,
-        draw_pixel_zwrite,
-        draw_pixel_blend,
-        draw_pixel_blend_zwrite,
-        draw_pixel_blend_edge,
-        draw_pixel_blend_edge_zwrite,
+    static const draw_fn_t draw_funcs[GFX_SOFT_FMT_COUNT][6] = {
+        {
+            draw_pixel,
+            draw_pixel_zwrite,
+            draw_pixel_blend,
+            draw_pixel_blend_zwrite,
+            draw_pixel_blend_edge,
+            draw_pixel_blend_edge_zwrite,
+        },
+        NATIVE_DRAW_FUNCS(rgb332),
+        NATIVE_DRAW_FUNCS(rgb555),
+        NATIVE_DRAW_FUNCS(rgb565),
+        NATIVE_DRAW_FUNCS(pal8),
     };
-    draw_fn = draw_funcs[cur_shader->draw_flags | z_write];
+    draw_fn = draw_funcs[out_format][cur_shader->draw_flags | z_write];
 }
 
 static void gfx_soft_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
@@ -844,20 +1303,73 @@ static void gfx_soft_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t
         pop_triangle(buf_vbo + i, stride);
 }
 
+static void gfx_soft_draw_particles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
+    gfx_soft_pick_draw_func();
+    const size_t num_verts = 3 * buf_vbo_num_tris;
+    const size_t stride = buf_vbo_len / num_verts;
+    for (size_t i = 0; i < num_verts * stride; i += 3 * stride)
+        splat_triangle(buf_vbo + i, stride);
+}
+
 static void gfx_soft_fill_rect(int x0, int y0, int x1, int y1, const uint8_t *rgba) {
     // HACK: these are mainly used just to clear the screen and draw simple rects, so we ignore drawmode stuff and Z
     x0 = imax(0, x0);
     y0 = imax(0, y0);
     x1 = imin(scr_width, x1);
     y1 = imin(scr_height, y1);
-    register const uint32_t color = *(uint32_t *)rgba;
-    register uint32_t *base = gfx_output + y0 * scr_width + x0;
-    register uint32_t *p;
+    if (x0 >= x1 || y0 >= y1)
+        return;
+    mark_tiles(x0, y0, x1, y1);
     register int x, y;
-    for (y = y0; y < y1; ++y, base += scr_width) {
-        p = base;
-        for (x = x0; x < x1; ++x, ++p)
-            *p = color;
+    if (out_format == GFX_SOFT_FMT_PAL8) {
+        // the dither pattern repeats every 4 pixels, so pack those once per row
+        register uint8_t *base = (uint8_t *)gfx_output + y0 * scr_width;
+        uint8_t pattern[4];
+        for (y = y0; y < y1; ++y, base += scr_width) {
+            pal_dither_row = pal_dither[y & 3];
+            for (x = 0; x < 4; ++x)
+                pattern[x] = pack_pal8(x, rgba[0], rgba[1], rgba[2]);
+            for (x = x0; x < x1; ++x)
+                base[x] = pattern[x & 3];
+        }
+    } else if (out_format == GFX_SOFT_FMT_RGB332) {
+        register const uint8_t color = gfx_soft_pack_rgb332(rgba[0], rgba[1], rgba[2]);
+        register uint8_t *base = (uint8_t *)gfx_output + y0 * scr_width + x0;
+        for (y = y0; y < y1; ++y, base += scr_width)
+            memset(base, color, x1 - x0);
+    } else if (out_format != GFX_SOFT_FMT_RGBA32) {
+        register const uint16_t color = (out_format == GFX_SOFT_FMT_RGB555)
+            ? gfx_soft_pack_rgb555(rgba[0], rgba[1], rgba[2])
+            : gfx_soft_pack_rgb565(rgba[0], rgba[1], rgba[2]);
+        register uint16_t *base = (uint16_t *)gfx_output + y0 * scr_width + x0;
+        register uint16_t *p;
+        for (y = y0; y < y1; ++y, base += scr_width) {
+            p = base;
+            for (x = x0; x < x1; ++x, ++p)
+                *p = color;
+        }
+    } else {
+        register const uint32_t color = *(uint32_t *)rgba;
+        register uint32_t *base = gfx_output + y0 * scr_width + x0;
+        register uint32_t *p;
+        for (y = y0; y < y1; ++y, base += scr_width) {
+            p = base;
+            for (x = x0; x < x1; ++x, ++p)
+                *p = color;
+        }
+    }
+}
+
+// Lets the window manager pick the format gfx_output is written in. The buffer
+// keeps room for RGBA32, so this can be changed at any time.
+void gfx_soft_set_output_format(enum GfxSoftFormat format) {
+    out_format = format;
+    if (format == GFX_SOFT_FMT_PAL8) {
+        // start out with RGB332 until there are textures to build a palette from
+        pal_set_rgb332();
+        pal_sort_next();
+        pal_build_pos = 0;
+        pal_build_lookup(32768);
     }
 }
 
@@ -870,6 +1382,7 @@ static inline void gfx_soft_tex_rect_replace(int x0, int y0, int x1, int y1, con
     for (y = y0; y < y1; ++y, base += scr_width, v += dvdy) {
         idx = base;
         u = u0;
+        pal_dither_row = pal_dither[y & 3];
         for (x = x0; x < x1; ++x, ++idx, u += dudx)
             draw_fn(idx, 0, cur_tex[0]->sample(cur_tex[0], u, v));
     }
@@ -884,16 +1397,21 @@ static inline void gfx_soft_tex_rect_modulate(int x0, int y0, int x1, int y1, co
     for (y = y0; y < y1; ++y, base += scr_width, v += dvdy) {
         idx = base;
         u = u0;
+        pal_dither_row = pal_dither[y & 3];
         for (x = x0; x < x1; ++x, ++idx, u += dudx)
             draw_fn(idx, 0, rgba_modulate(cur_tex[0]->sample(cur_tex[0], u, v), rgba));
     }
 }
 
-static void gfx_soft_tex_rect(int x0, int y0, int x1, int y1, const float u0, const float v0, const float dudx, const float dvdy, const uint8_t *rgba) {
-    x0 = imax(0, x0);
-    y0 = imax(0, y0);
+static void gfx_soft_tex_rect(int x0, int y0, int x1, int y1, float u0, float v0, const float dudx, const float dvdy, const uint8_t *rgba) {
+    // advance the texture origin along with the clipped edges so scrolled rects (e.g. the sky) don't shift
+    if (x0 < 0) { u0 -= x0 * dudx; x0 = 0; }
+    if (y0 < 0) { v0 -= y0 * dvdy; y0 = 0; }
     x1 = imin(scr_width, x1);
     y1 = imin(scr_height, y1);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+    mark_tiles(x0, y0, x1, y1);
     gfx_soft_pick_draw_func();
     if (cur_shader->cc.num_inputs)
         gfx_soft_tex_rect_modulate(x0, y0, x1, y1, u0, v0, dudx, dvdy, *(Color4 *)rgba);
@@ -955,6 +1473,9 @@ static void gfx_soft_init(void) {
 static void gfx_soft_start_frame(void) {
     // depth_swap(); // FIXME: ztrick
     depth_clear();
+    ++frame_num;
+    if (out_format == GFX_SOFT_FMT_PAL8)
+        pal_update();
 }
 
 static void gfx_soft_shutdown(void) {
@@ -998,6 +1519,8 @@ struct GfxRenderingAPI gfx_soft_api = {
     gfx_soft_tex_rect,
     gfx_soft_set_fog_color,
     gfx_soft_shutdown,
+    gfx_soft_draw_particles,
+    NULL,
 };
 
 #endif // ENABLE_OPENGL_LEGACY
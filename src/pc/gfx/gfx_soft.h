@@ -2,8 +2,25 @@
 #define GFX_SOFT_H
 
 #include "gfx_rendering_api.h"
+#include "gfx_soft_formats.h"
 
 extern struct GfxRenderingAPI gfx_soft_api;
 extern uint32_t *gfx_output;
 
+// gfx_output is split into 16x16 tiles, and everything that draws flags the
+// tiles it touches here. Whoever presents the frame clears the flags.
+#define GFX_SOFT_TILE_SHIFT 4
+#define GFX_SOFT_TILE_SIZE (1 << GFX_SOFT_TILE_SHIFT)
+#define GFX_SOFT_TILES_X (320 >> GFX_SOFT_TILE_SHIFT)
+#define GFX_SOFT_TILES_Y (240 >> GFX_SOFT_TILE_SHIFT)
+#define GFX_SOFT_TILES (GFX_SOFT_TILES_X * GFX_SOFT_TILES_Y)
+
+extern uint8_t gfx_soft_dirty_tiles[GFX_SOFT_TILES];
+
+void gfx_soft_set_output_format(enum GfxSoftFormat format);
+
+// Returns the palette GFX_SOFT_FMT_PAL8 indices refer to as 256 RGB triplets,
+// or NULL if it hasn't changed since the last call.
+const uint8_t *gfx_soft_get_new_palette(void);
+
 #endif
@@ -0,0 +1,56 @@
+#ifndef GFX_SOFT_FORMATS_H
+#define GFX_SOFT_FORMATS_H
+
+#include <stdint.h>
+
+// Pixel formats gfx_soft can write gfx_output in. Anything but RGBA32 is
+// only used by video modes that can show it without a conversion pass.
+enum GfxSoftFormat {
+    GFX_SOFT_FMT_RGBA32,
+    GFX_SOFT_FMT_RGB332,
+    GFX_SOFT_FMT_RGB555,
+    GFX_SOFT_FMT_RGB565,
+    GFX_SOFT_FMT_PAL8, // dithered indices into a palette gfx_soft builds per level
+    GFX_SOFT_FMT_COUNT
+};
+
+// These produce exactly what the old present converters in gfx_dos_api.c did
+// with an RGBA32 frame, so the palette and VESA modes need no other changes.
+
+static inline uint8_t gfx_soft_pack_rgb332(const uint8_t r, const uint8_t g, const uint8_t b) {
+    return (r & 0xE0) | ((g & 0xE0) >> 3) | (b >> 6);
+}
+
+static inline uint16_t gfx_soft_pack_rgb555(const uint8_t r, const uint8_t g, const uint8_t b) {
+    return ((r & 0xF8) << 7) | ((g & 0xF8) << 2) | (b >> 3);
+}
+
+static inline uint16_t gfx_soft_pack_rgb565(const uint8_t r, const uint8_t g, const uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// Unpacking replicates the high bits into the low ones, so white stays white
+// when a translucent pixel is blended over it.
+
+static inline void gfx_soft_unpack_rgb332(const uint8_t p, uint8_t *r, uint8_t *g, uint8_t *b) {
+    const uint8_t r3 = p >> 5, g3 = (p >> 2) & 7, b2 = p & 3;
+    *r = (r3 << 5) | (r3 << 2) | (r3 >> 1);
+    *g = (g3 << 5) | (g3 << 2) | (g3 >> 1);
+    *b = b2 * 0x55;
+}
+
+static inline void gfx_soft_unpack_rgb555(const uint16_t p, uint8_t *r, uint8_t *g, uint8_t *b) {
+    const uint8_t r5 = p >> 10, g5 = (p >> 5) & 31, b5 = p & 31;
+    *r = (r5 << 3) | (r5 >> 2);
+    *g = (g5 << 3) | (g5 >> 2);
+    *b = (b5 << 3) | (b5 >> 2);
+}
+
+static inline void gfx_soft_unpack_rgb565(const uint16_t p, uint8_t *r, uint8_t *g, uint8_t *b) {
+    const uint8_t r5 = p >> 11, g6 = (p >> 5) & 63, b5 = p & 31;
+    *r = (r5 << 3) | (r5 >> 2);
+    *g = (g6 << 2) | (g6 >> 4);
+    *b = (b5 << 3) | (b5 >> 2);
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifdef LOAD_BENCHMARK
+
+#include <stdio.h>
+
+#include "sm64.h"
+#include "level_table.h"
+#include "game/area.h"
+
+#include "load_benchmark.h"
+#include "perf_timer.h"
+#include "configfile.h"
+#include "common.h"
+
+// Frames to stay in a level before warping to the next one
+#define LOAD_BENCHMARK_SETTLE_FRAMES 30
+
+static const s16 sCourses[] = {
+    LEVEL_BOB, LEVEL_WF,  LEVEL_JRB, LEVEL_CCM, LEVEL_BBH, LEVEL_HMC, LEVEL_LLL, LEVEL_SSL,
+    LEVEL_DDD, LEVEL_SL,  LEVEL_WDW, LEVEL_TTM, LEVEL_THI, LEVEL_TTC, LEVEL_RR,
+};
+
+#define NUM_COURSES (s32)(sizeof(sCourses) / sizeof(sCourses[0]))
+// Course, castle grounds, course again
+#define LOADS_PER_COURSE 3
+
+static uint64_t sLoadTimes[NUM_COURSES * LOADS_PER_COURSE];
+static s32 sNumLoads;
+static s32 sLoading;
+static uint64_t sLoadTime;
+static uint64_t sChunkStart;
+static s32 sSettleTimer;
+
+s16 load_benchmark_next_level(void) {
+    if (sNumLoads % LOADS_PER_COURSE == 1) {
+        return LEVEL_CASTLE_GROUNDS;
+    }
+    return sCourses[sNumLoads / LOADS_PER_COURSE];
+}
+
+void load_benchmark_start(void) {
+    sLoading = TRUE;
+    sLoadTime = 0;
+    sChunkStart = perf_timer_ns();
+}
+
+void load_benchmark_script_begin(void) {
+    sChunkStart = perf_timer_ns();
+}
+
+void load_benchmark_script_end(void) {
+    if (sLoading) {
+        sLoadTime += perf_timer_ns() - sChunkStart;
+    }
+}
+
+void load_benchmark_finish(void) {
+    if (sLoading) {
+        sLoadTime += perf_timer_ns() - sChunkStart;
+        sLoadTimes[sNumLoads++] = sLoadTime;
+        sLoading = FALSE;
+        sSettleTimer = LOAD_BENCHMARK_SETTLE_FRAMES;
+    }
+}
+
+static void load_benchmark_report(void) {
+    uint64_t coldTotal = 0;
+    uint64_t warmTotal = 0;
+    s32 i;
+
+    printf("level_cache %s\n", configLevelCache ? "on" : "off");
+    printf("%-6s %10s %10s\n", "level", "cold ms", "warm ms");
+    for (i = 0; i < NUM_COURSES; i++) {
+        uint64_t cold = sLoadTimes[i * LOADS_PER_COURSE];
+        uint64_t warm = sLoadTimes[i * LOADS_PER_COURSE + 2];
+
+        printf("%-6d %10.3f %10.3f\n", sCourses[i], cold / 1000000.0, warm / 1000000.0);
+        coldTotal += cold;
+        warmTotal += warm;
+    }
+    printf("%-6s %10.3f %10.3f\n", "total", coldTotal / 1000000.0, warmTotal / 1000000.0);
+}
+
+/**
+ * Called once per frame of normal play. Returns the level to warp to once the
+ * current one has settled, or 0 to keep playing.
+ */
+s16 load_benchmark_update(void) {
+    if (sLoading || --sSettleTimer > 0) {
+        return 0;
+    }
+
+    if (sNumLoads == NUM_COURSES * LOADS_PER_COURSE) {
+        load_benchmark_report();
+        game_exit();
+    }
+
+    return load_benchmark_next_level();
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef LOAD_BENCHMARK_H
+#define LOAD_BENCHMARK_H
+
+#include <PR/ultratypes.h>
+
+// Level load benchmark (LOAD_BENCHMARK=1). Warps through every main course
+// twice with the castle grounds in between and reports the cold and warm time
+// spent in the level scripts for each load.
+#ifdef LOAD_BENCHMARK
+s16 load_benchmark_next_level(void);
+void load_benchmark_start(void);
+void load_benchmark_finish(void);
+s16 load_benchmark_update(void);
+void load_benchmark_script_begin(void);
+void load_benchmark_script_end(void);
+#endif
+
+#endif
@@ -0,0 +1,258 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "mat4_simd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#define MAT4_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#ifdef TARGET_DOS
+#include <setjmp.h>
+#include <signal.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MAT4_NEON
+#include <arm_neon.h>
+#endif
+
+struct Mat4Kernels gMat4Kernels = { "scalar", NULL, NULL, NULL, NULL };
+
+#ifdef MAT4_X86
+/**
+ * SSE, which every x86-64 CPU and x86 CPUs from the Pentium III on have. The
+ * DOS build targets the 486, so these are compiled for SSE on their own.
+ */
+
+// a[0] * b0 + a[1] * b1 + a[2] * b2, added in the order mtxf_mul does
+__attribute__((target("sse"))) static inline __m128 sse_row3(const float *a, __m128 b0, __m128 b1, __m128 b2) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), b0), _mm_mul_ps(_mm_set1_ps(a[1]), b1)),
+                      _mm_mul_ps(_mm_set1_ps(a[2]), b2));
+}
+
+__attribute__((target("sse"))) static void mul_sse(float dest[4][4], float a[4][4], float b[4][4]) {
+    const __m128 b0 = _mm_loadu_ps(b[0]);
+    const __m128 b1 = _mm_loadu_ps(b[1]);
+    const __m128 b2 = _mm_loadu_ps(b[2]);
+    const __m128 b3 = _mm_loadu_ps(b[3]);
+    int i;
+
+    // Each row of a is read before the same row of dest is written, so dest may be a or b
+    for (i = 0; i < 3; i++) {
+        _mm_storeu_ps(dest[i], sse_row3(a[i], b0, b1, b2));
+        dest[i][3] = 0;
+    }
+    _mm_storeu_ps(dest[3], _mm_add_ps(sse_row3(a[3], b0, b1, b2), b3));
+    dest[3][3] = 1;
+}
+
+__attribute__((target("sse"))) static void mul_full_sse(float dest[4][4], float a[4][4], float b[4][4]) {
+    const __m128 b0 = _mm_loadu_ps(b[0]);
+    const __m128 b1 = _mm_loadu_ps(b[1]);
+    const __m128 b2 = _mm_loadu_ps(b[2]);
+    const __m128 b3 = _mm_loadu_ps(b[3]);
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        _mm_storeu_ps(dest[i], _mm_add_ps(sse_row3(a[i], b0, b1, b2), _mm_mul_ps(_mm_set1_ps(a[i][3]), b3)));
+    }
+}
+
+__attribute__((target("sse"))) static void scale_sse(float dest[4][4], float mtx[4][4], float s[3]) {
+    _mm_storeu_ps(dest[0], _mm_mul_ps(_mm_loadu_ps(mtx[0]), _mm_set1_ps(s[0])));
+    _mm_storeu_ps(dest[1], _mm_mul_ps(_mm_loadu_ps(mtx[1]), _mm_set1_ps(s[1])));
+    _mm_storeu_ps(dest[2], _mm_mul_ps(_mm_loadu_ps(mtx[2]), _mm_set1_ps(s[2])));
+    _mm_storeu_ps(dest[3], _mm_loadu_ps(mtx[3]));
+}
+
+__attribute__((target("sse"))) static void transform_sse(float dest[3], float mtx[4][4], float x, float y, float z) {
+    float out[4];
+    const float point[3] = { x, y, z };
+
+    _mm_storeu_ps(out, _mm_add_ps(sse_row3(point, _mm_loadu_ps(mtx[0]), _mm_loadu_ps(mtx[1]),
+                                           _mm_loadu_ps(mtx[2])),
+                                  _mm_loadu_ps(mtx[3])));
+    dest[0] = out[0];
+    dest[1] = out[1];
+    dest[2] = out[2];
+}
+
+/**
+ * AVX, which does two rows at once. Each lane of a row pair gets the matching
+ * element of its own row of a, so the sums are the same as with SSE.
+ */
+
+__attribute__((target("avx"))) static inline __m256 avx_load_twice(const float *row) {
+    const __m128 r = _mm_loadu_ps(row);
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(r), r, 1);
+}
+
+__attribute__((target("avx"))) static inline __m256 avx_rows3(__m256 a, __m256 b0, __m256 b1, __m256 b2) {
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(a, 0x00), b0),
+                                       _mm256_mul_ps(_mm256_permute_ps(a, 0x55), b1)),
+                         _mm256_mul_ps(_mm256_permute_ps(a, 0xAA), b2));
+}
+
+__attribute__((target("avx"))) static void mul_avx(float dest[4][4], float a[4][4], float b[4][4]) {
+    const __m256 b0 = avx_load_twice(b[0]);
+    const __m256 b1 = avx_load_twice(b[1]);
+    const __m256 b2 = avx_load_twice(b[2]);
+    // Adding -0 leaves row 2 exactly as it is, zeros included
+    const __m256 b3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(-0.0f)), _mm_loadu_ps(b[3]), 1);
+    const __m256 a01 = _mm256_loadu_ps(a[0]);
+    const __m256 a23 = _mm256_loadu_ps(a[2]);
+
+    _mm256_storeu_ps(dest[0], avx_rows3(a01, b0, b1, b2));
+    _mm256_storeu_ps(dest[2], _mm256_add_ps(avx_rows3(a23, b0, b1, b2), b3));
+    dest[0][3] = dest[1][3] = dest[2][3] = 0;
+    dest[3][3] = 1;
+}
+
+__attribute__((target("avx"))) static void mul_full_avx(float dest[4][4], float a[4][4], float b[4][4]) {
+    const __m256 b0 = avx_load_twice(b[0]);
+    const __m256 b1 = avx_load_twice(b[1]);
+    const __m256 b2 = avx_load_twice(b[2]);
+    const __m256 b3 = avx_load_twice(b[3]);
+    const __m256 a01 = _mm256_loadu_ps(a[0]);
+    const __m256 a23 = _mm256_loadu_ps(a[2]);
+
+    _mm256_storeu_ps(dest[0], _mm256_add_ps(avx_rows3(a01, b0, b1, b2),
+                                            _mm256_mul_ps(_mm256_permute_ps(a01, 0xFF), b3)));
+    _mm256_storeu_ps(dest[2], _mm256_add_ps(avx_rows3(a23, b0, b1, b2),
+                                            _mm256_mul_ps(_mm256_permute_ps(a23, 0xFF), b3)));
+}
+
+#ifdef TARGET_DOS
+static jmp_buf sse_probe_env;
+
+static void sse_probe_trap(int sig) {
+    (void) sig;
+    longjmp(sse_probe_env, 1);
+}
+
+// The DPMI host has to enable SSE as well, or the first SSE instruction traps
+__attribute__((target("sse"))) static bool os_has_sse(void) {
+    void (*prev)(int) = signal(SIGILL, sse_probe_trap);
+    volatile bool enabled = false;
+
+    if (setjmp(sse_probe_env) == 0) {
+        __asm__ __volatile__("xorps %%xmm0, %%xmm0" : : : "xmm0");
+        enabled = true;
+    }
+    signal(SIGILL, prev);
+    return enabled;
+}
+#endif
+
+static bool cpu_has_sse(void) {
+    unsigned int eax, ebx, ecx, edx;
+
+    // Fails on CPUs without CPUID
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(edx & bit_SSE)) {
+        return false;
+    }
+#ifdef TARGET_DOS
+    return os_has_sse();
+#else
+    return true;
+#endif
+}
+
+static bool cpu_has_avx(void) {
+    unsigned int eax, ebx, ecx, edx, xcr0, xcr0High;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return false;
+    }
+
+    // The OS has to save the upper halves of the registers too
+    __asm__ __volatile__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+    return (xcr0 & 6) == 6;
+}
+#endif
+
+#ifdef MAT4_NEON
+/**
+ * NEON, which ARM builds that can use it always have.
+ */
+
+static inline float32x4_t neon_row3(const float *a, float32x4_t b0, float32x4_t b1, float32x4_t b2) {
+    return vaddq_f32(vaddq_f32(vmulq_f32(vdupq_n_f32(a[0]), b0), vmulq_f32(vdupq_n_f32(a[1]), b1)),
+                     vmulq_f32(vdupq_n_f32(a[2]), b2));
+}
+
+static void mul_neon(float dest[4][4], float a[4][4], float b[4][4]) {
+    const float32x4_t b0 = vld1q_f32(b[0]);
+    const float32x4_t b1 = vld1q_f32(b[1]);
+    const float32x4_t b2 = vld1q_f32(b[2]);
+    const float32x4_t b3 = vld1q_f32(b[3]);
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        vst1q_f32(dest[i], neon_row3(a[i], b0, b1, b2));
+        dest[i][3] = 0;
+    }
+    vst1q_f32(dest[3], vaddq_f32(neon_row3(a[3], b0, b1, b2), b3));
+    dest[3][3] = 1;
+}
+
+static void mul_full_neon(float dest[4][4], float a[4][4], float b[4][4]) {
+    const float32x4_t b0 = vld1q_f32(b[0]);
+    const float32x4_t b1 = vld1q_f32(b[1]);
+    const float32x4_t b2 = vld1q_f32(b[2]);
+    const float32x4_t b3 = vld1q_f32(b[3]);
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        vst1q_f32(dest[i], vaddq_f32(neon_row3(a[i], b0, b1, b2), vmulq_f32(vdupq_n_f32(a[i][3]), b3)));
+    }
+}
+
+static void scale_neon(float dest[4][4], float mtx[4][4], float s[3]) {
+    vst1q_f32(dest[0], vmulq_n_f32(vld1q_f32(mtx[0]), s[0]));
+    vst1q_f32(dest[1], vmulq_n_f32(vld1q_f32(mtx[1]), s[1]));
+    vst1q_f32(dest[2], vmulq_n_f32(vld1q_f32(mtx[2]), s[2]));
+    vst1q_f32(dest[3], vld1q_f32(mtx[3]));
+}
+
+static void transform_neon(float dest[3], float mtx[4][4], float x, float y, float z) {
+    float out[4];
+    const float point[3] = { x, y, z };
+
+    vst1q_f32(out, vaddq_f32(neon_row3(point, vld1q_f32(mtx[0]), vld1q_f32(mtx[1]), vld1q_f32(mtx[2])),
+                             vld1q_f32(mtx[3])));
+    dest[0] = out[0];
+    dest[1] = out[1];
+    dest[2] = out[2];
+}
+#endif
+
+static struct Mat4Kernels sVariants[3];
+static int sNumVariants = 0;
+
+const struct Mat4Kernels *mat4_simd_variants(int *count) {
+    if (sNumVariants == 0) {
+        sVariants[sNumVariants++] = (struct Mat4Kernels) { "scalar", NULL, NULL, NULL, NULL };
+#ifdef MAT4_X86
+        if (cpu_has_sse()) {
+            sVariants[sNumVariants++] = (struct Mat4Kernels) { "SSE", mul_sse, mul_full_sse, scale_sse, transform_sse };
+            if (cpu_has_avx()) {
+                // Scaling and transforming a point don't get anything out of the wider registers
+                sVariants[sNumVariants++] = (struct Mat4Kernels) { "AVX", mul_avx, mul_full_avx, scale_sse, transform_sse };
+            }
+        }
+#elif defined(MAT4_NEON)
+        sVariants[sNumVariants++] = (struct Mat4Kernels) { "NEON", mul_neon, mul_full_neon, scale_neon, transform_neon };
+#endif
+    }
+
+    *count = sNumVariants;
+    return sVariants;
+}
+
+void mat4_simd_init(bool strict) {
+    int count;
+    const struct Mat4Kernels *variants = mat4_simd_variants(&count);
+
+    gMat4Kernels = variants[strict ? 0 : count - 1];
+}
@@ -0,0 +1,39 @@
+#ifndef MAT4_SIMD_H
+#define MAT4_SIMD_H
+
+#include <stdbool.h>
+
+// Vector versions of the Mat4 routines of math_util.c and gfx_pc.c, picked at
+// startup for the CPU the game runs on. A kernel is NULL when the scalar code
+// should be used, which is always the case in strict mode.
+//
+// The kernels do the same single precision multiplies and adds in the same
+// order as the scalar code, so they match it exactly when the scalar code is
+// compiled to SSE too. Builds that use the x87 FPU (DOS) or contract the
+// multiply-adds keep more precision in between, and the results can then
+// differ by up to MAT4_SIMD_TOLERANCE times the sum of the magnitudes of the
+// terms that were added up.
+#define MAT4_SIMD_TOLERANCE 2e-6f
+
+struct Mat4Kernels {
+    const char *name;
+    // mtxf_mul: dest = a * b for transformation matrices, the w column is set to 0, 0, 0, 1
+    void (*mul)(float dest[4][4], float a[4][4], float b[4][4]);
+    // gfx_matrix_mul: dest = a * b for any matrices
+    void (*mul_full)(float dest[4][4], float a[4][4], float b[4][4]);
+    // mtxf_scale_vec3f: the first three rows of mtx scaled by s
+    void (*scale)(float dest[4][4], float mtx[4][4], float s[3]);
+    // mtxf_mul_vec3s and mtxf_billboard: the point (x, y, z) transformed by mtx
+    void (*transform)(float dest[3], float mtx[4][4], float x, float y, float z);
+};
+
+extern struct Mat4Kernels gMat4Kernels;
+
+// Every kernel set this CPU can run, starting with the scalar one (all NULL)
+// and ending with the fastest
+const struct Mat4Kernels *mat4_simd_variants(int *count);
+
+// Pick the fastest kernels, or none in strict mode
+void mat4_simd_init(bool strict);
+
+#endif
@@ -18,6 +18,7 @@
 #include "gfx/gfx_dxgi.h"
 #include "gfx/gfx_glx.h"
 #include "gfx/gfx_sdl.h"
+#include "gfx/gfx_headless.h"
 
 #include "audio/audio_api.h"
 #include "audio/audio_sb16.h"
@@ -30,6 +31,9 @@
 #include "controller/controller_keyboard.h"
 
 #include "configfile.h"
+#include "perf_timer.h"
+#include "zone_profiler.h"
+#include "mat4_simd.h"
 
 #include "compat.h"
 
@@ -80,10 +84,12 @@ void send_display_list(struct SPTask *spTask) {
 #endif
 
 void produce_one_frame(void) {
+    PROFILER_ZONE_BEGIN(ZONE_FRAME);
     gfx_start_frame();
     game_loop_one_iteration();
 
     if (configEnableSound) {
+        PROFILER_ZONE_BEGIN(ZONE_AUDIO);
         int samples_left = audio_api->buffered();
         u32 num_audio_samples = samples_left < audio_api->get_desired_buffered() ? SAMPLES_HIGH : SAMPLES_LOW;
         s16 audio_buffer[SAMPLES_HIGH * 2 * 2];
@@ -91,9 +97,16 @@ void produce_one_frame(void) {
             create_next_audio_buffer(audio_buffer + i * (num_audio_samples * 2), num_audio_samples);
         }
         audio_api->play((u8 *)audio_buffer, 2 * num_audio_samples * 4);
+        PROFILER_ZONE_END(ZONE_AUDIO);
     }
 
+    PROFILER_ZONE_BEGIN(ZONE_PRESENT);
     gfx_end_frame();
+    PROFILER_ZONE_END(ZONE_PRESENT);
+    PROFILER_ZONE_END(ZONE_FRAME);
+#ifdef ZONE_PROFILER
+    zone_profiler_end_frame();
+#endif
 }
 
 #ifdef TARGET_WEB
@@ -133,6 +146,12 @@ static void save_config(void) {
     configfile_save(CONFIG_FILE);
 }
 
+#ifdef ZONE_PROFILER
+static void write_profiler_trace(void) {
+    zone_profiler_write_trace("profile.json");
+}
+#endif
+
 static void on_fullscreen_changed(bool is_now_fullscreen) {
     configFullscreen = is_now_fullscreen;
 }
@@ -145,18 +164,33 @@ void game_exit(void) {
 
 void main_func(void) {
     static u64 pool[0x165000/8 / 4 * sizeof(void *)];
+    perf_timer_init();
     main_pool_init(pool, pool + sizeof(pool) / sizeof(pool[0]));
     gEffectsMemoryPool = mem_pool_init(0x4000, MEMORY_POOL_LEFT);
 
     configfile_load(CONFIG_FILE);
     atexit(save_config);
+    mat4_simd_init(!configSimdMath);
+    gShowProfiler = configShowProfiler;
+#ifdef ZONE_PROFILER
+    if (configProfilerTrace) {
+        atexit(write_profiler_trace);
+    }
+#endif
 
 #ifdef TARGET_WEB
     emscripten_set_main_loop(em_main_loop, 0, 0);
     request_anim_frame(on_anim_frame);
 #endif
 
-#if defined(ENABLE_DX12)
+#if defined(HEADLESS)
+    #if defined(ENABLE_SOFTRAST)
+        rendering_api = &gfx_soft_api;
+    #else
+        rendering_api = &gfx_null_api;
+    #endif
+    wm_api = &gfx_headless_api;
+#elif defined(ENABLE_DX12)
     rendering_api = &gfx_direct3d12_api;
     wm_api = &gfx_dxgi_api;
 #elif defined(ENABLE_DX11)
@@ -184,6 +218,7 @@ void main_func(void) {
 
     gfx_init(wm_api, rendering_api, "Super Mario 64 PC-Port", configFullscreen);
 
+#ifndef HEADLESS
     if (configEnableSound) {
 #if HAVE_WASAPI
         if (audio_api == NULL && audio_wasapi.init()) {
@@ -211,6 +246,7 @@ void main_func(void) {
         }
 #endif
     }
+#endif
 
     if (audio_api == NULL) {
         audio_api = &audio_null;
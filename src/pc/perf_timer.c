@@ -0,0 +1,114 @@
+#include <stdbool.h>
+
+#include "perf_timer.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#elif defined(TARGET_WEB)
+#include <emscripten.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(_WIN32) || defined(_WIN64)
+
+static LARGE_INTEGER qpc_freq;
+
+void perf_timer_init(void) {
+    QueryPerformanceFrequency(&qpc_freq);
+}
+
+uint64_t perf_timer_ns(void) {
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return (uint64_t)(t.QuadPart / qpc_freq.QuadPart) * 1000000000ULL
+           + (uint64_t)(t.QuadPart % qpc_freq.QuadPart) * 1000000000ULL / qpc_freq.QuadPart;
+}
+
+#elif defined(TARGET_WEB)
+
+void perf_timer_init(void) {
+}
+
+uint64_t perf_timer_ns(void) {
+    return (uint64_t)(emscripten_get_now() * 1000000.0);
+}
+
+#elif defined(TARGET_DOS)
+
+// uclock() reads the PIT, which Allegro reprograms once its timers are installed,
+// so it is only trusted for calibrating the TSC. CPUs without a TSC (486) fall
+// back to uclock() and get whatever precision is left.
+static bool has_tsc;
+static uint64_t tsc_hz;
+static uint64_t tsc_start;
+
+static inline uint64_t read_tsc(void) {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static bool detect_tsc(void) {
+    uint32_t before, after, eax, ebx, ecx, edx;
+
+    // CPUID is available if the ID flag (bit 21) of EFLAGS can be toggled
+    __asm__ __volatile__("pushfl\n\t"
+                         "popl %0\n\t"
+                         "movl %0, %1\n\t"
+                         "xorl $0x200000, %0\n\t"
+                         "pushl %0\n\t"
+                         "popfl\n\t"
+                         "pushfl\n\t"
+                         "popl %0\n\t"
+                         "pushl %1\n\t"
+                         "popfl"
+                         : "=&r"(after), "=&r"(before));
+    if (((before ^ after) & 0x200000) == 0) {
+        return false;
+    }
+
+    __asm__ __volatile__("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1));
+    return (edx & 0x10) != 0;
+}
+
+void perf_timer_init(void) {
+    uclock_t start, end;
+    uint64_t tsc_begin;
+
+    has_tsc = detect_tsc();
+    if (!has_tsc) {
+        return;
+    }
+
+    start = uclock();
+    tsc_begin = read_tsc();
+    do {
+        end = uclock();
+    } while (end - start < UCLOCKS_PER_SEC / 20);
+    tsc_hz = (read_tsc() - tsc_begin) * UCLOCKS_PER_SEC / (end - start);
+    tsc_start = read_tsc();
+}
+
+uint64_t perf_timer_ns(void) {
+    if (has_tsc) {
+        uint64_t t = read_tsc() - tsc_start;
+        return t / tsc_hz * 1000000000ULL + t % tsc_hz * 1000000000ULL / tsc_hz;
+    } else {
+        uclock_t t = uclock();
+        return (uint64_t)(t / UCLOCKS_PER_SEC) * 1000000000ULL + (uint64_t)(t % UCLOCKS_PER_SEC) * 1000000000ULL / UCLOCKS_PER_SEC;
+    }
+}
+
+#else
+
+void perf_timer_init(void) {
+}
+
+uint64_t perf_timer_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif
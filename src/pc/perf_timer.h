@@ -0,0 +1,12 @@
+#ifndef PERF_TIMER_H
+#define PERF_TIMER_H
+
+#include <stdint.h>
+
+// Monotonic high resolution clock for benchmarks and profiling, in nanoseconds.
+// perf_timer_init() must be called once at startup, before any frame timers
+// are installed (on DOS the TSC is calibrated against the PIT).
+void perf_timer_init(void);
+uint64_t perf_timer_ns(void);
+
+#endif
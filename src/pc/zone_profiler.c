@@ -0,0 +1,216 @@
+#ifdef ZONE_PROFILER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <PR/ultratypes.h>
+
+#include "game/print.h"
+
+#include "zone_profiler.h"
+#include "perf_timer.h"
+
+#define ZONE_MAX_DEPTH 16
+// Completed zones kept per thread for the trace, must be a power of two
+#define ZONE_EVENT_CAPACITY 0x10000
+// Frames the overlay times are averaged over
+#define ZONE_AVERAGE_FRAMES 30
+
+#ifdef TARGET_DOS
+#define ZONE_THREAD_LOCAL
+#else
+#define ZONE_THREAD_LOCAL __thread
+#endif
+
+struct ZoneEvent {
+    uint64_t start;
+    uint32_t duration;
+    uint8_t zone;
+    uint8_t depth;
+};
+
+// Every thread that opens a zone gets its own buffer, so recording needs no locking
+struct ZoneThreadBuffer {
+    struct ZoneThreadBuffer *next;
+    uint32_t threadIndex;
+    uint32_t depth;
+    uint64_t stackStart[ZONE_MAX_DEPTH];
+    uint8_t stackZone[ZONE_MAX_DEPTH];
+    uint64_t zoneTime[ZONE_COUNT];
+    uint8_t zoneDepth[ZONE_COUNT];
+    uint32_t numEvents;
+    struct ZoneEvent events[ZONE_EVENT_CAPACITY];
+};
+
+// Overlay labels, short enough to fit next to the stats overlay
+static const char *sZoneLabels[ZONE_COUNT] = {
+    "FRAME %d", "SCRIPT %d", "OBJ %d", "COLL %d", "GEO %d",
+    "GFX %d", "TEX %d", "RAST %d", "AUDIO %d", "SWAP %d",
+};
+
+static const char *sZoneNames[ZONE_COUNT] = {
+    "frame", "level_script", "objects", "collision", "geo_process",
+    "gfx_run", "texture_import", "raster", "audio_mix", "present",
+};
+
+static struct ZoneThreadBuffer *sThreadBuffers;
+static uint32_t sNumThreadBuffers;
+static ZONE_THREAD_LOCAL struct ZoneThreadBuffer *sThreadBuffer;
+static bool sOutOfMemory;
+
+static uint32_t sNumFrames;
+static uint64_t sLastZoneTime[ZONE_COUNT];
+static s32 sZoneMicroseconds[ZONE_COUNT];
+static u8 sZoneDepth[ZONE_COUNT];
+static bool sZoneSeen[ZONE_COUNT];
+
+static struct ZoneThreadBuffer *get_thread_buffer(void) {
+    struct ZoneThreadBuffer *buf = sThreadBuffer;
+
+    if (buf == NULL && !sOutOfMemory) {
+        buf = calloc(1, sizeof(struct ZoneThreadBuffer));
+        if (buf == NULL) {
+            printf("zone_profiler: could not allocate thread buffer\n");
+            sOutOfMemory = true;
+            return NULL;
+        }
+        buf->threadIndex = __sync_fetch_and_add(&sNumThreadBuffers, 1);
+        do {
+            buf->next = sThreadBuffers;
+        } while (!__sync_bool_compare_and_swap(&sThreadBuffers, buf->next, buf));
+        sThreadBuffer = buf;
+    }
+    return buf;
+}
+
+void zone_profiler_begin(enum ProfilerZone zone) {
+    struct ZoneThreadBuffer *buf = get_thread_buffer();
+
+    if (buf == NULL) {
+        return;
+    }
+    // Zones nested deeper than ZONE_MAX_DEPTH are only counted, not timed
+    if (buf->depth < ZONE_MAX_DEPTH) {
+        buf->stackZone[buf->depth] = zone;
+        buf->stackStart[buf->depth] = perf_timer_ns();
+    }
+    buf->depth++;
+}
+
+void zone_profiler_end(void) {
+    struct ZoneThreadBuffer *buf = sThreadBuffer;
+    struct ZoneEvent *event;
+    uint32_t depth;
+    uint64_t duration;
+
+    if (buf == NULL || buf->depth == 0) {
+        return;
+    }
+    depth = --buf->depth;
+    if (depth >= ZONE_MAX_DEPTH) {
+        return;
+    }
+
+    duration = perf_timer_ns() - buf->stackStart[depth];
+    buf->zoneTime[buf->stackZone[depth]] += duration;
+    buf->zoneDepth[buf->stackZone[depth]] = depth;
+
+    event = &buf->events[buf->numEvents++ & (ZONE_EVENT_CAPACITY - 1)];
+    event->start = buf->stackStart[depth];
+    event->duration = duration;
+    event->zone = buf->stackZone[depth];
+    event->depth = depth;
+}
+
+/**
+ * Called once per frame on the main thread. Every ZONE_AVERAGE_FRAMES frames
+ * the time spent in each zone since the last update is averaged for the overlay.
+ */
+void zone_profiler_end_frame(void) {
+    struct ZoneThreadBuffer *buf;
+    uint64_t total;
+    int i;
+
+    if (++sNumFrames % ZONE_AVERAGE_FRAMES != 0) {
+        return;
+    }
+
+    for (i = 0; i < ZONE_COUNT; i++) {
+        total = 0;
+        for (buf = sThreadBuffers; buf != NULL; buf = buf->next) {
+            if (buf->zoneTime[i] != 0) {
+                total += buf->zoneTime[i];
+                sZoneDepth[i] = buf->zoneDepth[i];
+                sZoneSeen[i] = true;
+            }
+        }
+        sZoneMicroseconds[i] = (total - sLastZoneTime[i]) / (ZONE_AVERAGE_FRAMES * 1000);
+        sLastZoneTime[i] = total;
+    }
+}
+
+/**
+ * Print the average microseconds per frame of every zone that has been entered,
+ * indented by nesting depth.
+ */
+void zone_profiler_draw(void) {
+    s32 y = 222;
+    int i;
+
+    for (i = 0; i < ZONE_COUNT; i++) {
+        if (sZoneSeen[i]) {
+            print_text_fmt_int(140 + sZoneDepth[i] * 8, y, sZoneLabels[i], sZoneMicroseconds[i]);
+            y -= 16;
+        }
+    }
+}
+
+/**
+ * Write the zones kept in the thread buffers as complete ("X") events of the
+ * Chrome trace event format, viewable in chrome://tracing or Perfetto.
+ */
+void zone_profiler_write_trace(const char *filename) {
+    struct ZoneThreadBuffer *buf;
+    uint64_t base = UINT64_MAX;
+    uint32_t count, first, i;
+    bool comma = false;
+    FILE *fp;
+
+    for (buf = sThreadBuffers; buf != NULL; buf = buf->next) {
+        count = buf->numEvents < ZONE_EVENT_CAPACITY ? buf->numEvents : ZONE_EVENT_CAPACITY;
+        first = buf->numEvents - count;
+        for (i = 0; i < count; i++) {
+            const struct ZoneEvent *event = &buf->events[(first + i) & (ZONE_EVENT_CAPACITY - 1)];
+            if (event->start < base) {
+                base = event->start;
+            }
+        }
+    }
+
+    fp = fopen(filename, "w");
+    if (fp == NULL) {
+        return;
+    }
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    for (buf = sThreadBuffers; buf != NULL; buf = buf->next) {
+        fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                comma ? ",\n" : "", buf->threadIndex, buf->threadIndex == 0 ? "main" : "worker");
+        comma = true;
+
+        count = buf->numEvents < ZONE_EVENT_CAPACITY ? buf->numEvents : ZONE_EVENT_CAPACITY;
+        first = buf->numEvents - count;
+        for (i = 0; i < count; i++) {
+            const struct ZoneEvent *event = &buf->events[(first + i) & (ZONE_EVENT_CAPACITY - 1)];
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    sZoneNames[event->zone], buf->threadIndex, (event->start - base) / 1000.0,
+                    event->duration / 1000.0);
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+}
+
+#endif
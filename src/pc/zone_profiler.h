@@ -0,0 +1,34 @@
+#ifndef ZONE_PROFILER_H
+#define ZONE_PROFILER_H
+
+// Zones of the PC profiler (PROFILER=1). Zones nest, so the time of a zone
+// includes the time of every zone opened inside it.
+enum ProfilerZone {
+    ZONE_FRAME,
+    ZONE_SCRIPT,
+    ZONE_OBJECTS,
+    ZONE_COLLISION,
+    ZONE_GEO,
+    ZONE_GFX,
+    ZONE_TEXTURE,
+    ZONE_RASTER,
+    ZONE_AUDIO,
+    ZONE_PRESENT,
+    ZONE_COUNT
+};
+
+#ifdef ZONE_PROFILER
+void zone_profiler_begin(enum ProfilerZone zone);
+void zone_profiler_end(void);
+void zone_profiler_end_frame(void);
+void zone_profiler_draw(void);
+void zone_profiler_write_trace(const char *filename);
+
+#define PROFILER_ZONE_BEGIN(zone) zone_profiler_begin(zone)
+#define PROFILER_ZONE_END(zone) zone_profiler_end()
+#else
+#define PROFILER_ZONE_BEGIN(zone)
+#define PROFILER_ZONE_END(zone)
+#endif
+
+#endif
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+# Bakes the static surface partition of every area terrain referenced by a
+# level script, in the same order load_area_terrain would build it. The game
+# still computes the surfaces themselves, and only uses the baked lists if
+# every surface sorts into the same list as it did here.
+import os
+import re
+import struct
+import sys
+
+SPATIAL_PARTITION_FLOORS = 0
+SPATIAL_PARTITION_CEILS = 1
+SPATIAL_PARTITION_WALLS = 2
+
+def s16(x):
+    return ((x + 0x8000) & 0xFFFF) - 0x8000
+
+def s32(x):
+    return ((x + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+
+def f32(x):
+    return struct.unpack("<f", struct.pack("<f", x))[0]
+
+def q_rsqrt(number):
+    x2 = f32(number * 0.5)
+    i = struct.unpack("<i", struct.pack("<f", number))[0]
+    i = (0x5F375A86 - (i >> 1)) & 0xFFFFFFFF
+    y = struct.unpack("<f", struct.pack("<I", i))[0]
+    return f32(y * f32(1.5 - f32(f32(x2 * y) * y)))
+
+def surface_list(v1, v2, v3):
+    # Matches read_surface_data and add_surface_to_cell in surface_load.c
+    x1, y1, z1 = v1
+    x2, y2, z2 = v2
+    x3, y3, z3 = v3
+    nx = f32(s32((y2 - y1) * (z3 - z2) - (z2 - z1) * (y3 - y2)))
+    ny = f32(s32((z2 - z1) * (x3 - x2) - (x2 - x1) * (z3 - z2)))
+    nz = f32(s32((x2 - x1) * (y3 - y2) - (y2 - y1) * (x3 - x2)))
+    mag = q_rsqrt(f32(f32(f32(nx * nx) + f32(ny * ny)) + f32(nz * nz)))
+    ny = f32(ny * mag)
+    if ny > 0.01:
+        return SPATIAL_PARTITION_FLOORS, 1
+    if ny < -0.01:
+        return SPATIAL_PARTITION_CEILS, -1
+    return SPATIAL_PARTITION_WALLS, 0
+
+def lower_cell_index(coord):
+    coord = s16(coord + 0x2000)
+    if coord < 0:
+        coord = 0
+    index = coord // 0x400
+    if coord % 0x400 < 50:
+        index -= 1
+    return max(index, 0)
+
+def upper_cell_index(coord):
+    coord = s16(coord + 0x2000)
+    if coord < 0:
+        coord = 0
+    index = coord // 0x400
+    if coord % 0x400 > 0x400 - 50:
+        index += 1
+    return min(index, 15)
+
+def preprocess(lines, defines):
+    out = []
+    stack = []
+    for line in lines:
+        stripped = line.strip()
+        if stripped.startswith("#ifdef") or stripped.startswith("#ifndef"):
+            cond = stripped.split()[1] in defines
+            if stripped.startswith("#ifndef"):
+                cond = not cond
+            stack.append(cond)
+        elif stripped.startswith("#else"):
+            stack[-1] = not stack[-1]
+        elif stripped.startswith("#endif"):
+            stack.pop()
+        elif all(stack):
+            out.append(line)
+    return out
+
+def read_collision(path, name, defines):
+    with open(path) as f:
+        lines = preprocess(f.read().splitlines(), defines)
+    text = re.sub(r"/\*.*?\*/|//[^\n]*", "", "\n".join(lines), flags=re.S)
+    m = re.search(r"Collision\s+" + name + r"\s*\[\]\s*=\s*\{(.*?)\};", text, re.S)
+    if m is None:
+        return None
+    return [(macro, [a.strip() for a in args.split(",") if a.strip()])
+            for macro, args in re.findall(r"([A-Z_]+)\(([^)]*)\)", m.group(1))]
+
+def bake(cmds):
+    surfaces = []  # (list, priority, cells)
+    vertices = []
+    pos = 0
+    while pos < len(cmds):
+        macro, args = cmds[pos]
+        pos += 1
+        if macro == "COL_VERTEX_INIT":
+            count = int(args[0], 0)
+            vertices = [tuple(s16(int(a, 0)) for a in cmds[pos + i][1][:3]) for i in range(count)]
+            pos += count
+        elif macro == "COL_TRI_INIT":
+            count = int(args[1], 0)
+            for i in range(count):
+                v1, v2, v3 = (vertices[int(a, 0)] for a in cmds[pos + i][1][:3])
+                listIndex, sortDir = surface_list(v1, v2, v3)
+                minX, maxX = min(v1[0], v2[0], v3[0]), max(v1[0], v2[0], v3[0])
+                minZ, maxZ = min(v1[2], v2[2], v3[2]), max(v1[2], v2[2], v3[2])
+                cells = [(cellZ, cellX)
+                         for cellZ in range(lower_cell_index(minZ), upper_cell_index(maxZ) + 1)
+                         for cellX in range(lower_cell_index(minX), upper_cell_index(maxX) + 1)]
+                surfaces.append((listIndex, s16(v1[1] * sortDir), cells))
+            pos += count
+
+    # Replay add_surface_to_cell: nodes are allocated in surface order and
+    # inserted after every node of the same or higher priority.
+    lists = {}
+    nodes = []
+    for surfaceIndex, (listIndex, priority, cells) in enumerate(surfaces):
+        for cellZ, cellX in cells:
+            cell = lists.setdefault((cellZ, cellX, listIndex), [])
+            at = 0
+            while at < len(cell) and not priority > surfaces[nodes[cell[at]][1]][1]:
+                at += 1
+            cell.insert(at, len(nodes))
+            nodes.append([-1, surfaceIndex])
+
+    partition = [-1] * (16 * 16 * 3)
+    for (cellZ, cellX, listIndex), cell in lists.items():
+        partition[(cellZ * 16 + cellX) * 3 + listIndex] = cell[0]
+        for a, b in zip(cell, cell[1:]):
+            nodes[a][0] = b
+
+    return [s[0] for s in surfaces], nodes, partition
+
+def find_terrains():
+    terrains = []
+    for level in sorted(os.listdir("levels")):
+        script = os.path.join("levels", level, "script.c")
+        if not os.path.isfile(script):
+            continue
+        with open(script) as f:
+            names = re.findall(r"TERRAIN\(\s*(?:/\*.*?\*/)?\s*(\w+)\s*\)", f.read())
+        for name in names:
+            if name not in (t[0] for t in terrains):
+                terrains.append((name, os.path.join("levels", level)))
+    return terrains
+
+def format_array(values, per_line):
+    return "\n".join("    " + " ".join(str(v) + "," for v in values[i:i + per_line])
+                     for i in range(0, len(values), per_line))
+
+def main():
+    defines = [a[2:].split("=")[0] for a in sys.argv[1:] if a.startswith("-D")]
+    entries = []
+
+    print("// Generated by tools/collision_bake.py, do not edit.")
+    print('#include "types.h"')
+    print('#include "engine/surface_load.h"')
+    print()
+
+    for name, level_dir in find_terrains():
+        cmds = None
+        for root, dirs, files in sorted(os.walk(level_dir)):
+            for file in sorted(files):
+                if file.endswith(".c") and cmds is None:
+                    cmds = read_collision(os.path.join(root, file), name, defines)
+        if cmds is None:
+            print("collision_bake.py: " + name + " not found, skipping", file=sys.stderr)
+            continue
+
+        surfaceLists, nodes, partition = bake(cmds)
+        if len(surfaceLists) == 0 or len(nodes) > 0x7FFF:
+            print("collision_bake.py: " + name + " has no surfaces or too many, skipping", file=sys.stderr)
+            continue
+
+        print("extern const Collision " + name + "[];")
+        print("static const u8 " + name + "_lists[] = {")
+        print(format_array(surfaceLists, 32))
+        print("};")
+        print("static const s16 " + name + "_nodes[] = {")
+        print(format_array([v for node in nodes for v in node], 16))
+        print("};")
+        print("static const s16 " + name + "_partition[] = {")
+        print(format_array(partition, 16))
+        print("};")
+        print()
+        entries.append("    { " + name + ", " + str(len(surfaceLists)) + ", " + str(len(nodes)) + ", "
+                       + name + "_lists, " + name + "_nodes, " + name + "_partition },")
+
+    print("const struct CollisionBake gCollisionBakes[] = {")
+    print("\n".join(entries))
+    print("    { NULL, 0, 0, NULL, NULL, NULL },")
+    print("};")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,347 @@
+/*
+ * Host-side check for find_surface_on_segment.
+ *
+ * The camera tests line of sight by stepping points along a segment and asking
+ * the wall, floor and ceiling queries about each of them. The raycast walks
+ * the partition cells the segment crosses instead. This builds a level of
+ * terrain, pillars and platforms, checks the raycast against testing the
+ * segment with every surface, and times it against the stepped probes.
+ *
+ * Built by `make -C tools benches`.
+ *
+ * usage: collision_ray_bench [rays]
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "types.h"
+#include "surface_terrains.h"
+#include "engine/surface_collision.h"
+#include "engine/surface_load.h"
+#include "game/object_list_processor.h"
+
+#define MAX_SURFACES 12000
+#define MAX_NODES 60000
+#define STEPS 10
+
+/* What surface_collision.c needs from the rest of the game */
+
+SpatialPartitionCell gStaticSurfacePartition[16][16];
+SpatialPartitionCell gDynamicSurfacePartition[16][16];
+struct Object *gCurrentObject;
+struct Object *gMarioObject;
+struct MarioState *gMarioState;
+struct NumTimesCalled gNumCalls;
+s32 gNumFindFloorMisses;
+s16 gCheckingSurfaceCollisionsForCamera;
+s16 gFindFloorIncludeSurfaceIntangible;
+s16 *gEnvironmentRegions;
+s32 gSurfaceNodesAllocated;
+s32 gNumStaticSurfaces;
+s32 gSurfacesAllocated;
+
+void print_debug_top_down_mapinfo(const char *str, ...) {
+}
+
+void set_text_array_x_y(s32 x, s32 y) {
+}
+
+static struct Surface surfaces[MAX_SURFACES];
+static struct SurfaceNode nodes[MAX_NODES];
+static int numSurfaces;
+static int numNodes;
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static float frand(float lo, float hi) {
+    return lo + (hi - lo) * (rng() & 0xFFFF) / 65535.0f;
+}
+
+/* Cell range of a surface, with the 50 unit border surface_load adds */
+
+static int lower_cell(int coord) {
+    int index;
+    coord += 0x2000;
+    if (coord < 0) coord = 0;
+    index = coord / 0x400;
+    if (coord % 0x400 < 50) index--;
+    return index < 0 ? 0 : index;
+}
+
+static int upper_cell(int coord) {
+    int index;
+    coord += 0x2000;
+    if (coord < 0) coord = 0;
+    index = coord / 0x400;
+    if (coord % 0x400 > 0x400 - 50) index++;
+    return index > 15 ? 15 : index;
+}
+
+// Same normal, offset and bounds as read_surface_data, same lists as add_surface
+static void add_triangle(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3) {
+    struct Surface *s;
+    float nx = (y2 - y1) * (z3 - z2) - (z2 - z1) * (y3 - y2);
+    float ny = (z2 - z1) * (x3 - x2) - (x2 - x1) * (z3 - z2);
+    float nz = (x2 - x1) * (y3 - y2) - (y2 - y1) * (x3 - x2);
+    float mag = sqrtf(nx * nx + ny * ny + nz * nz);
+    int minX, maxX, minZ, maxZ, list, cx, cz;
+
+    if (mag == 0.0f || numSurfaces == MAX_SURFACES) {
+        return;
+    }
+    s = &surfaces[numSurfaces++];
+    nx /= mag;
+    ny /= mag;
+    nz /= mag;
+
+    s->vertex1[0] = x1; s->vertex1[1] = y1; s->vertex1[2] = z1;
+    s->vertex2[0] = x2; s->vertex2[1] = y2; s->vertex2[2] = z2;
+    s->vertex3[0] = x3; s->vertex3[1] = y3; s->vertex3[2] = z3;
+    s->normal.x = nx;
+    s->normal.y = ny;
+    s->normal.z = nz;
+    s->originOffset = -(nx * x1 + ny * y1 + nz * z1);
+    s->lowerY = fminf(y1, fminf(y2, y3)) - 5;
+    s->upperY = fmaxf(y1, fmaxf(y2, y3)) + 5;
+    s->flags = (nx < -0.707f || nx > 0.707f) ? SURFACE_FLAG_X_PROJECTION : 0;
+    s->type = SURFACE_DEFAULT;
+
+    list = (ny > 0.01f) ? SPATIAL_PARTITION_FLOORS
+         : (ny < -0.01f) ? SPATIAL_PARTITION_CEILS : SPATIAL_PARTITION_WALLS;
+    minX = x1 < x2 ? (x1 < x3 ? x1 : x3) : (x2 < x3 ? x2 : x3);
+    maxX = x1 > x2 ? (x1 > x3 ? x1 : x3) : (x2 > x3 ? x2 : x3);
+    minZ = z1 < z2 ? (z1 < z3 ? z1 : z3) : (z2 < z3 ? z2 : z3);
+    maxZ = z1 > z2 ? (z1 > z3 ? z1 : z3) : (z2 > z3 ? z2 : z3);
+
+    for (cz = lower_cell(minZ); cz <= upper_cell(maxZ); cz++) {
+        for (cx = lower_cell(minX); cx <= upper_cell(maxX); cx++) {
+            struct SurfaceNode *head = &gStaticSurfacePartition[cz][cx][list];
+            if (numNodes == MAX_NODES) {
+                return;
+            }
+            nodes[numNodes].surface = s;
+            nodes[numNodes].next = head->next;
+            head->next = &nodes[numNodes++];
+        }
+    }
+}
+
+static int terrain_height(int x, int z) {
+    return (int) (300.0f * sinf(x * 0.0011f) * cosf(z * 0.0009f));
+}
+
+// Rolling terrain, box pillars and floating platforms
+static void build_level(void) {
+    int i, x, z;
+
+    for (z = -7680; z < 7680; z += 320) {
+        for (x = -7680; x < 7680; x += 320) {
+            int h00 = terrain_height(x, z), h10 = terrain_height(x + 320, z);
+            int h01 = terrain_height(x, z + 320), h11 = terrain_height(x + 320, z + 320);
+            add_triangle(x, h00, z, x, h01, z + 320, x + 320, h11, z + 320);
+            add_triangle(x, h00, z, x + 320, h11, z + 320, x + 320, h10, z);
+        }
+    }
+
+    for (i = 0; i < 400; i++) {
+        int x0 = frand(-7000, 6800), z0 = frand(-7000, 6800);
+        int w = frand(60, 400), d = frand(60, 400);
+        int y0 = -400, y1 = frand(200, 2500);
+        int x1 = x0 + w, z1 = z0 + d;
+        // Outward facing walls
+        add_triangle(x0, y0, z0, x0, y1, z0, x1, y1, z0);
+        add_triangle(x0, y0, z0, x1, y1, z0, x1, y0, z0);
+        add_triangle(x1, y0, z1, x1, y1, z1, x0, y1, z1);
+        add_triangle(x1, y0, z1, x0, y1, z1, x0, y0, z1);
+        add_triangle(x0, y0, z1, x0, y1, z1, x0, y1, z0);
+        add_triangle(x0, y0, z1, x0, y1, z0, x0, y0, z0);
+        add_triangle(x1, y0, z0, x1, y1, z0, x1, y1, z1);
+        add_triangle(x1, y0, z0, x1, y1, z1, x1, y0, z1);
+        add_triangle(x0, y1, z0, x0, y1, z1, x1, y1, z1);
+        add_triangle(x0, y1, z0, x1, y1, z1, x1, y1, z0);
+    }
+
+    for (i = 0; i < 150; i++) {
+        int x0 = frand(-7000, 6000), z0 = frand(-7000, 6000);
+        int x1 = x0 + frand(200, 1000), z1 = z0 + frand(200, 1000);
+        int y = frand(600, 2000);
+        add_triangle(x0, y, z0, x0, y, z1, x1, y, z1);
+        add_triangle(x0, y, z0, x1, y, z1, x1, y, z0);
+        add_triangle(x0, y - 60, z0, x1, y - 60, z1, x0, y - 60, z1);
+        add_triangle(x0, y - 60, z0, x1, y - 60, z0, x1, y - 60, z1);
+    }
+}
+
+/* The segment test of surface_collision.c, applied to every surface */
+
+static float segment_hit(struct Surface *surf, const float *orig, const float *dir) {
+    float e1x = surf->vertex2[0] - surf->vertex1[0];
+    float e1y = surf->vertex2[1] - surf->vertex1[1];
+    float e1z = surf->vertex2[2] - surf->vertex1[2];
+    float e2x = surf->vertex3[0] - surf->vertex1[0];
+    float e2y = surf->vertex3[1] - surf->vertex1[1];
+    float e2z = surf->vertex3[2] - surf->vertex1[2];
+    float px = dir[1] * e2z - dir[2] * e2y;
+    float py = dir[2] * e2x - dir[0] * e2z;
+    float pz = dir[0] * e2y - dir[1] * e2x;
+    float det = e1x * px + e1y * py + e1z * pz;
+    float sx, sy, sz, qx, qy, qz, u, v, t;
+
+    if (det == 0.0f) {
+        return 2.0f;
+    }
+    sx = orig[0] - surf->vertex1[0];
+    sy = orig[1] - surf->vertex1[1];
+    sz = orig[2] - surf->vertex1[2];
+    u = sx * px + sy * py + sz * pz;
+    qx = sy * e1z - sz * e1y;
+    qy = sz * e1x - sx * e1z;
+    qz = sx * e1y - sy * e1x;
+    v = dir[0] * qx + dir[1] * qy + dir[2] * qz;
+    t = e2x * qx + e2y * qy + e2z * qz;
+    if (det < 0.0f) {
+        det = -det;
+        u = -u;
+        v = -v;
+        t = -t;
+    }
+    if (u < 0.0f || v < 0.0f || u + v > det || t < 0.0f || t > det) {
+        return 2.0f;
+    }
+    return t / det;
+}
+
+static float brute_force(Vec3f from, Vec3f to) {
+    float dir[3] = { to[0] - from[0], to[1] - from[1], to[2] - from[2] };
+    float nearest = 2.0f;
+    int i;
+
+    for (i = 0; i < numSurfaces; i++) {
+        float t = segment_hit(&surfaces[i], from, dir);
+        if (t < nearest) {
+            nearest = t;
+        }
+    }
+    return nearest > 1.0f ? -1.0f : nearest * sqrtf(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+}
+
+// Blocked the way the camera checks it, with walls, floors and ceilings at each step
+static int stepped(Vec3f from, Vec3f to) {
+    struct WallCollisionData data;
+    struct Surface *surf;
+    int i;
+
+    for (i = 1; i <= STEPS; i++) {
+        float t = (float) i / STEPS;
+        float x = from[0] + (to[0] - from[0]) * t;
+        float y = from[1] + (to[1] - from[1]) * t;
+        float z = from[2] + (to[2] - from[2]) * t;
+
+        data.x = x;
+        data.y = y;
+        data.z = z;
+        data.offsetY = 0.0f;
+        data.radius = 50.0f;
+        if (find_wall_collisions(&data) != 0) {
+            return 1;
+        }
+        if (find_floor(x, y, z, &surf) > y || find_ceil(x, y, z, &surf) < y) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void make_rays(Vec3f *from, Vec3f *to, int count) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        float x = frand(-7000, 7000), z = frand(-7000, 7000);
+        float yaw = frand(0, 6.2831853f), dist = frand(300, 3000);
+        from[i][0] = x;
+        from[i][1] = terrain_height(x, z) + frand(100, 800);
+        from[i][2] = z;
+        to[i][0] = x + sinf(yaw) * dist;
+        to[i][1] = from[i][1] + frand(-400, 400);
+        to[i][2] = z + cosf(yaw) * dist;
+    }
+}
+
+int main(int argc, char **argv) {
+    int count = (argc > 1) ? atoi(argv[1]) : 20000;
+    Vec3f *from, *to;
+    float *exact;
+    int i, hits = 0, wrong = 0, agree = 0, blocked = 0;
+    clock_t start;
+    double rayUs, stepUs, bruteUs;
+    volatile float sink = 0.0f;
+
+    if (count <= 0) {
+        count = 1;
+    }
+    from = malloc(count * sizeof(Vec3f));
+    to = malloc(count * sizeof(Vec3f));
+    exact = malloc(count * sizeof(float));
+
+    build_level();
+    make_rays(from, to, count);
+    printf("%d surfaces, %d cell nodes, %d rays\n", numSurfaces, numNodes, count);
+
+    start = clock();
+    for (i = 0; i < count; i++) {
+        exact[i] = brute_force(from[i], to[i]);
+    }
+    bruteUs = (double) (clock() - start) * 1e6 / CLOCKS_PER_SEC / count;
+
+    for (i = 0; i < count; i++) {
+        Vec3f pos;
+        float dist;
+        struct Surface *surf = find_surface_on_segment(from[i], to[i], RAYCAST_ALL, pos, &dist);
+        int s = stepped(from[i], to[i]);
+
+        hits += surf != NULL;
+        blocked += s;
+        agree += s == (surf != NULL);
+        // Another surface at the same distance is fine, the nearest one is not found twice
+        if ((surf != NULL) != (exact[i] >= 0.0f) || (surf != NULL && fabsf(dist - exact[i]) > 0.01f)) {
+            wrong++;
+        }
+    }
+
+    start = clock();
+    for (i = 0; i < count; i++) {
+        Vec3f pos;
+        float dist;
+        find_surface_on_segment(from[i], to[i], RAYCAST_ALL, pos, &dist);
+        sink += dist;
+    }
+    rayUs = (double) (clock() - start) * 1e6 / CLOCKS_PER_SEC / count;
+
+    start = clock();
+    for (i = 0; i < count; i++) {
+        sink += stepped(from[i], to[i]);
+    }
+    stepUs = (double) (clock() - start) * 1e6 / CLOCKS_PER_SEC / count;
+
+    printf("%-22s %10s %10s\n", "method", "us/ray", "blocked");
+    printf("%-22s %10.3f %10d\n", "every surface", bruteUs, hits);
+    printf("%-22s %10.3f %10d\n", "find_surface_on_segment", rayUs, hits);
+    printf("%-22s %10.3f %10d\n", "10 stepped probes", stepUs, blocked);
+    printf("raycast vs every surface: %d wrong\n", wrong);
+    printf("stepped probes agree with the raycast on %.1f%% of rays\n", 100.0 * agree / count);
+
+    free(from);
+    free(to);
+    free(exact);
+    return wrong != 0;
+}
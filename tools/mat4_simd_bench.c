@@ -0,0 +1,212 @@
+/*
+ * Host-side check for the vector matrix kernels of src/pc/mat4_simd.c.
+ *
+ * mtxf_mul, mtxf_scale_vec3f, mtxf_mul_vec3s / mtxf_billboard and gfx_pc's
+ * gfx_matrix_mul use these instead of their scalar code when the CPU supports
+ * them. This runs every kernel set the CPU supports on random matrices, checks
+ * the results against the scalar code and times both.
+ *
+ * Built by `make -C tools benches`.
+ *
+ * usage: mat4_simd_bench [iterations]
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/pc/mat4_simd.h"
+
+#define COUNT 256
+
+static float mats_a[COUNT][4][4];
+static float mats_b[COUNT][4][4];
+static float results[COUNT][4][4];
+static float expected[COUNT][4][4];
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static float frand(float range) {
+    return ((float) (rng() & 0xFFFF) / 32767.5f - 1.0f) * range;
+}
+
+/* The scalar code of math_util.c and gfx_pc.c */
+
+static void scalar_mul(float dest[4][4], float a[4][4], float b[4][4]) {
+    float temp[4][4];
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        temp[i][0] = a[i][0] * b[0][0] + a[i][1] * b[1][0] + a[i][2] * b[2][0];
+        temp[i][1] = a[i][0] * b[0][1] + a[i][1] * b[1][1] + a[i][2] * b[2][1];
+        temp[i][2] = a[i][0] * b[0][2] + a[i][1] * b[1][2] + a[i][2] * b[2][2];
+    }
+    temp[3][0] = a[3][0] * b[0][0] + a[3][1] * b[1][0] + a[3][2] * b[2][0] + b[3][0];
+    temp[3][1] = a[3][0] * b[0][1] + a[3][1] * b[1][1] + a[3][2] * b[2][1] + b[3][1];
+    temp[3][2] = a[3][0] * b[0][2] + a[3][1] * b[1][2] + a[3][2] * b[2][2] + b[3][2];
+    temp[0][3] = temp[1][3] = temp[2][3] = 0;
+    temp[3][3] = 1;
+    memcpy(dest, temp, sizeof(temp));
+}
+
+static void scalar_mul_full(float dest[4][4], float a[4][4], float b[4][4]) {
+    int i, j;
+
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 4; j++) {
+            dest[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j] + a[i][3] * b[3][j];
+        }
+    }
+}
+
+static void scalar_scale(float dest[4][4], float mtx[4][4], float s[3]) {
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        dest[0][i] = mtx[0][i] * s[0];
+        dest[1][i] = mtx[1][i] * s[1];
+        dest[2][i] = mtx[2][i] * s[2];
+        dest[3][i] = mtx[3][i];
+    }
+}
+
+static void scalar_transform(float dest[3], float mtx[4][4], float x, float y, float z) {
+    dest[0] = x * mtx[0][0] + y * mtx[1][0] + z * mtx[2][0] + mtx[3][0];
+    dest[1] = x * mtx[0][1] + y * mtx[1][1] + z * mtx[2][1] + mtx[3][1];
+    dest[2] = x * mtx[0][2] + y * mtx[1][2] + z * mtx[2][2] + mtx[3][2];
+}
+
+static const struct Mat4Kernels scalar = { "scalar", scalar_mul, scalar_mul_full, scalar_scale, scalar_transform };
+
+enum Kernel { K_MUL, K_MUL_FULL, K_SCALE, K_TRANSFORM, K_COUNT };
+
+static const char *kernel_names[K_COUNT] = { "mtxf_mul", "gfx_matrix_mul", "mtxf_scale_vec3f", "mtxf_mul_vec3s" };
+
+static void run(const struct Mat4Kernels *k, enum Kernel kernel, float out[COUNT][4][4]) {
+    int i;
+
+    for (i = 0; i < COUNT; i++) {
+        switch (kernel) {
+            case K_MUL:
+                k->mul(out[i], mats_a[i], mats_b[i]);
+                break;
+            case K_MUL_FULL:
+                k->mul_full(out[i], mats_a[i], mats_b[i]);
+                break;
+            case K_SCALE:
+                k->scale(out[i], mats_a[i], mats_b[i][0]);
+                break;
+            default:
+                k->transform(out[i][0], mats_a[i], mats_b[i][1][0], mats_b[i][1][1], mats_b[i][1][2]);
+                break;
+        }
+    }
+}
+
+// Largest difference to the scalar code, in units of the sum of the magnitudes of the terms
+static double compare(enum Kernel kernel, int *exact) {
+    double worst = 0.0;
+    int i, r, c;
+
+    *exact = 1;
+    for (i = 0; i < COUNT; i++) {
+        for (r = 0; r < 4; r++) {
+            for (c = 0; c < 4; c++) {
+                double size = 0.0, err;
+                int k;
+
+                if (kernel == K_TRANSFORM && (r > 0 || c > 2)) {
+                    continue;
+                }
+                if (kernel == K_MUL || kernel == K_MUL_FULL) {
+                    for (k = 0; k < 4; k++) {
+                        size += fabs((double) mats_a[i][r][k] * mats_b[i][k][c]);
+                    }
+                } else if (kernel == K_TRANSFORM) {
+                    for (k = 0; k < 4; k++) {
+                        size += fabs((double) mats_a[i][k][c] * (k < 3 ? mats_b[i][1][k] : 1.0f));
+                    }
+                } else {
+                    size = fabs(expected[i][r][c]);
+                }
+                if (memcmp(&results[i][r][c], &expected[i][r][c], sizeof(float)) != 0) {
+                    *exact = 0;
+                }
+                err = fabs((double) results[i][r][c] - expected[i][r][c]);
+                if (size > 0.0 && err / size > worst) {
+                    worst = err / size;
+                }
+            }
+        }
+    }
+    return worst;
+}
+
+static double time_ns(const struct Mat4Kernels *k, enum Kernel kernel, int iters) {
+    clock_t start = clock();
+    int i;
+
+    for (i = 0; i < iters; i++) {
+        run(k, kernel, results);
+    }
+    return (double) (clock() - start) * 1e9 / CLOCKS_PER_SEC / iters / COUNT;
+}
+
+int main(int argc, char **argv) {
+    int iters = (argc > 1) ? atoi(argv[1]) : 20000;
+    int count, v, i, r, c, failed = 0;
+    const struct Mat4Kernels *variants = mat4_simd_variants(&count);
+
+    if (iters <= 0) {
+        iters = 1;
+    }
+
+    // Transformation matrices, with the w column set like the game's
+    for (i = 0; i < COUNT; i++) {
+        for (r = 0; r < 4; r++) {
+            for (c = 0; c < 4; c++) {
+                mats_a[i][r][c] = (r == 3) ? frand(8000.0f) : frand(2.0f);
+                mats_b[i][r][c] = (r == 3) ? frand(8000.0f) : frand(2.0f);
+            }
+            mats_a[i][r][3] = mats_b[i][r][3] = (r == 3) ? 1.0f : 0.0f;
+        }
+    }
+    // The renderer multiplies by projection matrices, whose w column is not
+    for (i = 0; i < COUNT; i += 4) {
+        mats_b[i][2][3] = -1.0f;
+        mats_b[i][3][3] = 0.0f;
+    }
+
+    printf("%-18s %-8s %10s %10s %8s\n", "kernel", "set", "ns/call", "max diff", "exact");
+    for (v = 0; v < K_COUNT; v++) {
+        double scalarNs = time_ns(&scalar, v, iters);
+
+        run(&scalar, v, expected);
+        printf("%-18s %-8s %10.2f %10s %8s\n", kernel_names[v], "scalar", scalarNs, "-", "-");
+        for (i = 1; i < count; i++) {
+            int exact;
+            double worst;
+
+            run(&variants[i], v, results);
+            worst = compare(v, &exact);
+            failed |= worst > MAT4_SIMD_TOLERANCE;
+            printf("%-18s %-8s %10.2f %10.2g %8s\n", kernel_names[v], variants[i].name,
+                   time_ns(&variants[i], v, iters), worst, exact ? "yes" : "no");
+        }
+    }
+    if (count == 1) {
+        printf("no vector kernels for this CPU\n");
+    }
+    printf("max diff is relative to the sum of the magnitudes of the terms, the tolerance is %g\n",
+           MAT4_SIMD_TOLERANCE);
+
+    return failed;
+}
@@ -0,0 +1,226 @@
+/*
+ * Host-side check for the native output formats of gfx_soft.
+ *
+ * The DOS build used to render RGBA32 and convert every pixel when presenting.
+ * gfx_soft now packs pixels into RGB332/555/565 as it draws them, and presenting
+ * is a plain copy or a Mode X plane split. This renders test frames both ways,
+ * checks that the results are identical and times both presents.
+ *
+ * Built by `make -C tools benches`.
+ *
+ * usage: soft_formats_bench [iterations]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/pc/gfx/gfx_soft_formats.h"
+
+#define WIDTH 320
+#define HEIGHT 240
+#define PIXELS (WIDTH * HEIGHT)
+
+static uint8_t frame_rgba[PIXELS * 4];
+static uint8_t frame_native[PIXELS * 2];
+static uint8_t vram_old[PIXELS * 2];
+static uint8_t vram_new[PIXELS * 2];
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/* The converters gfx_dos_api.c used, with VRAM replaced by a buffer */
+
+static void old_vesa_lfb_8(const uint8_t *inp, uint8_t *out) {
+    uint16_t *vram = (uint16_t *) out;
+    for (unsigned i = 0; i < PIXELS / 2; i++, inp += 8, vram++) {
+        uint16_t B1 = (*(inp) & 0xE0);
+        uint16_t G1 = (*(inp + 1) & 0xE0) >> 3;
+        uint16_t R1 = *(inp + 2) >> 6;
+        uint16_t B2 = (*(inp + 4) & 0xE0) << 8;
+        uint16_t G2 = (*(inp + 5) & 0xE0) << 5;
+        uint16_t R2 = (*(inp + 6) & 0xC0) << 2;
+        *vram = R1 | G1 | B1 | R2 | G2 | B2;
+    }
+}
+
+static void old_vesa_lfb_15(const uint8_t *inp, uint8_t *out) {
+    uint32_t *vram = (uint32_t *) out;
+    for (unsigned i = 0; i < PIXELS / 2; i++, inp += 8, vram++) {
+        uint32_t B1 = (*(inp) & 0xF8) << 7;
+        uint32_t G1 = (*(inp + 1) & 0xF8) << 2;
+        uint32_t R1 = *(inp + 2) >> 3;
+        uint32_t B2 = (uint32_t) (*(inp + 4) & 0xF8) << 23;
+        uint32_t G2 = (*(inp + 5) & 0xF8) << 18;
+        uint32_t R2 = (*(inp + 6) & 0xF8) << 13;
+        *vram = R1 | G1 | B1 | R2 | G2 | B2;
+    }
+}
+
+static void old_vesa_lfb_16(const uint8_t *inp, uint8_t *out) {
+    uint32_t *vram = (uint32_t *) out;
+    for (unsigned i = 0; i < PIXELS / 2; i++, inp += 8, vram++) {
+        uint32_t B1 = (*(inp) & 0xF8) << 8;
+        uint32_t G1 = (*(inp + 1) & 0xFC) << 3;
+        uint32_t R1 = *(inp + 2) >> 3;
+        uint32_t B2 = (uint32_t) (*(inp + 4) & 0xF8) << 24;
+        uint32_t G2 = (*(inp + 5) & 0xFC) << 19;
+        uint32_t R2 = (*(inp + 6) & 0xF8) << 13;
+        *vram = R1 | G1 | B1 | R2 | G2 | B2;
+    }
+}
+
+// Mode X planes are laid out one after the other in the output buffer
+static void old_modex(const uint8_t *in, uint8_t *out) {
+    for (unsigned plane = 0; plane < 4; ++plane) {
+        for (unsigned x = plane; x < WIDTH; x += 4) {
+            const uint8_t *inp = in + 4 * x;
+            uint8_t *outp = out + plane * (PIXELS / 4) + (x >> 2);
+            for (unsigned y = 0; y < HEIGHT; ++y, inp += WIDTH * 4, outp += WIDTH / 4) {
+                uint8_t B = (*(inp) & 0xE0);
+                uint8_t G = (*(inp + 1) & 0xE0) >> 3;
+                uint8_t R = *(inp + 2) >> 6;
+                *outp = R | G | B;
+            }
+        }
+    }
+}
+
+/* The presents gfx_dos_api.c uses now */
+
+static void new_modex(const uint8_t *in, uint8_t *out) {
+    for (unsigned plane = 0; plane < 4; ++plane) {
+        const uint8_t *inp = in + plane;
+        uint8_t *outp = out + plane * (PIXELS / 4);
+        for (unsigned y = 0; y < HEIGHT; ++y, inp += WIDTH) {
+            for (unsigned x = 0; x < WIDTH / 4; ++x)
+                *outp++ = inp[x << 2];
+        }
+    }
+}
+
+static void new_copy_8(const uint8_t *in, uint8_t *out) {
+    memcpy(out, in, PIXELS);
+}
+
+static void new_copy_16(const uint8_t *in, uint8_t *out) {
+    memcpy(out, in, PIXELS * 2);
+}
+
+/* What the gfx_soft plotters do for every pixel they draw */
+
+static void pack_frame(enum GfxSoftFormat format) {
+    const uint8_t *p = frame_rgba;
+    for (unsigned i = 0; i < PIXELS; i++, p += 4) {
+        if (format == GFX_SOFT_FMT_RGB332) {
+            frame_native[i] = gfx_soft_pack_rgb332(p[0], p[1], p[2]);
+        } else {
+            uint16_t c = (format == GFX_SOFT_FMT_RGB555) ? gfx_soft_pack_rgb555(p[0], p[1], p[2])
+                                                         : gfx_soft_pack_rgb565(p[0], p[1], p[2]);
+            memcpy(frame_native + i * 2, &c, 2);
+        }
+    }
+}
+
+static void make_frame(int kind) {
+    for (unsigned i = 0; i < PIXELS; i++) {
+        unsigned x = i % WIDTH, y = i / WIDTH;
+        uint8_t *p = frame_rgba + i * 4;
+        if (kind == 0) {
+            uint32_t r = rng();
+            p[0] = r;
+            p[1] = r >> 8;
+            p[2] = r >> 16;
+        } else {
+            p[0] = x * 255 / (WIDTH - 1);
+            p[1] = y * 255 / (HEIGHT - 1);
+            p[2] = (x + y) & 0xFF;
+        }
+        p[3] = 0xFF;
+    }
+}
+
+static double time_ms(void (*fn)(const uint8_t *, uint8_t *), const uint8_t *in, uint8_t *out, int iters) {
+    clock_t start = clock();
+    for (int i = 0; i < iters; i++) {
+        fn(in, out);
+    }
+    return (double) (clock() - start) * 1000.0 / CLOCKS_PER_SEC / iters;
+}
+
+static double time_pack_ms(enum GfxSoftFormat format, int iters) {
+    clock_t start = clock();
+    for (int i = 0; i < iters; i++) {
+        pack_frame(format);
+    }
+    return (double) (clock() - start) * 1000.0 / CLOCKS_PER_SEC / iters;
+}
+
+// Largest channel error after unpacking, which is what blending reads back
+static int unpack_error(enum GfxSoftFormat format) {
+    int maxErr = 0;
+    for (unsigned c = 0; c < 256; c++) {
+        uint8_t r, g, b;
+        int err;
+        if (format == GFX_SOFT_FMT_RGB332) {
+            gfx_soft_unpack_rgb332(gfx_soft_pack_rgb332(c, c, c), &r, &g, &b);
+        } else if (format == GFX_SOFT_FMT_RGB555) {
+            gfx_soft_unpack_rgb555(gfx_soft_pack_rgb555(c, c, c), &r, &g, &b);
+        } else {
+            gfx_soft_unpack_rgb565(gfx_soft_pack_rgb565(c, c, c), &r, &g, &b);
+        }
+        err = abs((int) r - (int) c);
+        if (abs((int) g - (int) c) > err) err = abs((int) g - (int) c);
+        if (abs((int) b - (int) c) > err) err = abs((int) b - (int) c);
+        if (err > maxErr) maxErr = err;
+    }
+    return maxErr;
+}
+
+int main(int argc, char **argv) {
+    static const struct {
+        const char *name;
+        enum GfxSoftFormat format;
+        void (*oldPresent)(const uint8_t *, uint8_t *);
+        void (*newPresent)(const uint8_t *, uint8_t *);
+        unsigned bytes;
+    } modes[] = {
+        { "Mode X  RGB332", GFX_SOFT_FMT_RGB332, old_modex, new_modex, PIXELS },
+        { "VESA 8  RGB332", GFX_SOFT_FMT_RGB332, old_vesa_lfb_8, new_copy_8, PIXELS },
+        { "VESA 15 RGB555", GFX_SOFT_FMT_RGB555, old_vesa_lfb_15, new_copy_16, PIXELS * 2 },
+        { "VESA 16 RGB565", GFX_SOFT_FMT_RGB565, old_vesa_lfb_16, new_copy_16, PIXELS * 2 },
+    };
+    int iters = (argc > 1) ? atoi(argv[1]) : 200;
+    int failed = 0;
+
+    if (iters <= 0) {
+        iters = 1;
+    }
+
+    printf("%-15s %10s %10s %10s %10s %6s\n", "mode", "old ms", "pack ms", "copy ms", "result", "error");
+    for (unsigned m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        int same = 1;
+        for (int kind = 0; kind < 2; kind++) {
+            make_frame(kind);
+            modes[m].oldPresent(frame_rgba, vram_old);
+            pack_frame(modes[m].format);
+            modes[m].newPresent(frame_native, vram_new);
+            same &= memcmp(vram_old, vram_new, modes[m].bytes) == 0;
+        }
+        failed |= !same;
+        printf("%-15s %10.3f %10.3f %10.3f %10s %6d\n", modes[m].name,
+               time_ms(modes[m].oldPresent, frame_rgba, vram_old, iters),
+               time_pack_ms(modes[m].format, iters),
+               time_ms(modes[m].newPresent, frame_native, vram_new, iters),
+               same ? "same" : "DIFFERENT", unpack_error(modes[m].format));
+    }
+    printf("pack ms is paid while drawing, once per plotted pixel instead of once per frame\n");
+
+    return failed;
+}